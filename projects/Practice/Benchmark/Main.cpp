@@ -0,0 +1,65 @@
+// Headless benchmarks: no window and no GL context are created.
+//
+// Usage: Benchmark.exe [name ...]
+//        without names every benchmark runs; see the table below for the names.
+
+#include <iostream>
+#include <cstring>
+#include "bench_procedural.h"
+#include "bench_lod.h"
+#include "bench_subdivision.h"
+#include "bench_normals.h"
+#include "bench_hierarchy.h"
+#include "bench_culling.h"
+#include "bench_ecs.h"
+#include "bench_bvh.h"
+#include "bench_occlusion.h"
+#include "bench_impostor.h"
+#include "bench_hlod.h"
+#include "bench_boids.h"
+#include "bench_particles.h"
+#include "bench_stress.h"
+#include "bench_import.h"
+#include "bench_textures.h"
+#include "bench_mesh_cache.h"
+
+struct BenchmarkEntry {
+	const char *name;
+	void (*run)();
+};
+
+static const BenchmarkEntry benchmarks[] = {
+	{ "procedural", benchProcedural },
+	{ "lod", benchLod },
+	{ "subdivision", benchSubdivision },
+	{ "normals", benchNormals },
+	{ "hierarchy", benchHierarchy },
+	{ "culling", benchCulling },
+	{ "ecs", benchEcs },
+	{ "bvh", benchBvh },
+	{ "occlusion", benchOcclusion },
+	{ "impostor", benchImpostor },
+	{ "hlod", benchHlod },
+	{ "boids", benchBoids },
+	{ "particles", benchParticles },
+	{ "stress", benchStress },
+	{ "import", benchImport },
+	{ "textures", benchTextures },
+	{ "meshcache", benchMeshCache },
+};
+
+int main(int argc, char **argv)
+{
+	int count = sizeof(benchmarks) / sizeof(benchmarks[0]);
+	for (int i = 0; i < count; i++) {
+		bool selected = argc < 2;
+		for (int a = 1; a < argc; a++) {
+			if (strcmp(argv[a], benchmarks[i].name) == 0) selected = true;
+		}
+		if (selected) {
+			benchmarks[i].run();
+			std::cout << std::endl;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,76 @@
+// bench_boids.h
+//
+// Flocking (boids.h) headless: steps per second of swarms up to 100k agents against the 60 Hz
+// frame budget, split into the grid sort, the agent update (scalar and SIMD neighbour kernels)
+// and writing the instance matrices, plus a check of the grid neighbours against brute force.
+
+#ifndef BENCH_BOIDS_H
+#define BENCH_BOIDS_H
+
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include "boids.h"
+#include "bench_utils.h"
+
+// count agents in a cube sized for about 15 neighbours each (neighbour radius 2)
+inline void benchBoidsFill(Flock &flock, int count) {
+	std::mt19937 random(11);
+	float half = 0.5f * std::cbrt(count * (4.0f / 3.0f * 3.14159265f * 8.0f) / 15.0f);
+	std::uniform_real_distribution<float> position(-half, half), direction(-1.0f, 1.0f);
+	flock.bounds = AABB(glm::vec3(-half), glm::vec3(half));
+	flock.obstacles.push_back(BoundingSphere(glm::vec3(0.0f), half * 0.2f));
+	for (int i = 0; i < count; i++) {
+		glm::vec3 p(position(random), position(random), position(random));
+		flock.add(p, glm::vec3(direction(random), direction(random), direction(random)) * 3.0f);
+	}
+}
+
+inline void benchBoidsSwarm(int count) {
+	Flock flock;
+	benchBoidsFill(flock, count);
+	std::vector<InstanceData> instances(count);
+	glm::mat4 planeFix = glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+	// settle into flocks first
+	for (int i = 0; i < 30; i++) flock.step(1.0f / 60.0f);
+
+	double sort[2] = { 0.0, 0.0 }, update[2] = { 0.0, 0.0 }, write = 0.0;
+	long long neighbours = 0;
+	const int steps = 20;
+	for (int simd = 0; simd < 2; simd++) {
+		flock.simd = simd != 0;
+		for (int i = 0; i < steps; i++) {
+			flock.step(1.0f / 60.0f);
+			sort[simd] += flock.getSortMilliseconds() / steps;
+			update[simd] += flock.getUpdateMilliseconds() / steps;
+			if (!simd) continue;
+			BenchTimer timer;
+			flock.writeInstances(&instances[0], planeFix, 0.05f);
+			write += timer.milliseconds() / steps;
+		}
+	}
+	for (int i = 0; i < count; i += 97) neighbours += flock.gatherNeighbours(i).count;
+
+	// the grid must find exactly the agents brute force finds
+	int mismatches = 0;
+	float worst = 0.0f;
+	for (int i = 0; i < count; i += std::max(1, count / 500)) {
+		FlockSums grid = flock.gatherNeighbours(i), all = flock.gatherNeighboursBruteForce(i);
+		if (grid.count != all.count) mismatches++;
+		worst = std::max(worst, glm::length(grid.velocity - all.velocity) / std::max(1.0f, glm::length(all.velocity)));
+	}
+	double frame = sort[1] + update[1] + write;
+	printf("  %6d agents, %4.1f neighbours: sort %6.2f ms | update scalar %7.2f ms simd %7.2f ms x%.1f | instances %5.2f ms"
+		" | step %6.2f ms (%4.0f%% of 60 Hz) | %d count mismatches, sum error %.1e\n",
+		count, (double)neighbours / ((count + 96) / 97), sort[1], update[0], update[1], update[0] / update[1], write,
+		frame, 100.0 * frame / (1000.0 / 60.0), mismatches, worst);
+}
+
+void benchBoids() {
+	printf("boids flocking (%d threads)\n", ThreadPool::instance().threadCount());
+	benchBoidsSwarm(10000);
+	benchBoidsSwarm(50000);
+	benchBoidsSwarm(100000);
+}
+
+#endif // !BENCH_BOIDS_H
@@ -0,0 +1,174 @@
+// bench_bvh.h
+//
+// Spatial index (bvh.h) over large random scenes: build, update (refit after motion) and
+// frustum / ray / sphere / box query throughput, each query against a linear scan over all boxes.
+
+#ifndef BENCH_BVH_H
+#define BENCH_BVH_H
+
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include "bvh.h"
+#include "bench_utils.h"
+
+// runs step() until 0.2 s have passed; returns milliseconds per call
+template <typename Step>
+inline double benchBvhRepeat(const Step &step) {
+	int iterations = 0;
+	BenchTimer timer;
+	do {
+		step();
+		iterations++;
+	} while (timer.seconds() < 0.2);
+	return timer.milliseconds() / iterations;
+}
+
+inline void benchBvhScene(int count) {
+	// the same density at every size: 1 object per 80 cubic units, 1/5 as high as wide
+	float half = 0.5f * std::cbrt(count * 80.0f * 5.0f * 5.0f);
+	std::mt19937 random(17);
+	std::uniform_real_distribution<float> across(-half, half), up(-half / 5.0f, half / 5.0f), size(0.2f, 2.0f), unit(-1.0f, 1.0f);
+	std::vector<AABB> boxes(count);
+	for (int i = 0; i < count; i++) {
+		float x = across(random), y = up(random), z = across(random), r = size(random);
+		boxes[i] = AABB(glm::vec3(x, y, z) - glm::vec3(r), glm::vec3(x, y, z) + glm::vec3(r));
+	}
+	printf("  %7d objects\n", count);
+
+	BVH bvh;
+	BenchTimer timer;
+	bvh.build(&boxes[0], count);
+	printf("    build            %8.2f ms  (%d nodes)\n", timer.milliseconds(), bvh.nodeCount());
+
+	// 1% of the objects move a little (refit of their paths), then all of them (full bottom-up refit)
+	std::vector<glm::vec3> offsets(count);
+	for (int i = 0; i < count; i++) offsets[i] = glm::vec3(unit(random), unit(random) * 0.2f, unit(random)) * 0.05f;
+	int frame = 0;
+	double sparse = benchBvhRepeat([&]() {
+		for (int i = frame % 100; i < count; i += 100) {
+			boxes[i].min += offsets[i]; boxes[i].max += offsets[i];
+			bvh.setBounds(i, boxes[i]);
+		}
+		bvh.commit();
+		frame++;
+	});
+	int rebuilds = bvh.rebuildCount();
+	int frames = 0;
+	double dense = benchBvhRepeat([&]() {
+		for (int i = 0; i < count; i++) {
+			boxes[i].min += offsets[i]; boxes[i].max += offsets[i];
+			bvh.setBounds(i, boxes[i]);
+		}
+		bvh.commit();
+		frames++;
+	});
+	rebuilds = bvh.rebuildCount() - rebuilds;
+	timer.reset();
+	bvh.rebuild();
+	double rebuild = timer.milliseconds();
+	printf("    update 1%%        %8.3f ms  (%.1f M objects/s)\n", sparse, count / 100 / sparse / 1000.0);
+	printf("    update all       %8.3f ms  (%.1f M objects/s, %d rebuilds in %d frames)\n", dense, count / dense / 1000.0,
+		rebuilds, frames);
+	printf("    rebuild          %8.2f ms\n", rebuild);
+
+	// frustum: a camera in the middle of the scene, 100 units far plane
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 2.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum = Frustum::fromMatrix(projection * view);
+	std::vector<int> found;
+	int linearCount = 0, mismatches = 0;
+	double linear = benchBvhRepeat([&]() {
+		linearCount = 0;
+		for (int i = 0; i < count; i++) linearCount += frustum.intersects(boxes[i]) ? 1 : 0;
+	});
+	double indexed = benchBvhRepeat([&]() {
+		found.clear();
+		bvh.queryFrustum(frustum, found);
+	});
+	mismatches += (int)found.size() != linearCount;
+	printf("    frustum          %8.3f ms  linear %8.3f ms  x%6.1f  (%d visible)\n", indexed, linear, linear / indexed, linearCount);
+
+	// rays from random points in random directions, nearest box
+	const int rays = 1000;
+	std::vector<glm::vec3> origins(rays), directions(rays);
+	for (int i = 0; i < rays; i++) {
+		origins[i] = glm::vec3(across(random), up(random), across(random));
+		directions[i] = glm::normalize(glm::vec3(unit(random), unit(random) * 0.2f, unit(random)));
+	}
+	// compared by distance: a ray starting inside several boxes enters all of them at 0
+	std::vector<float> linearHits(rays), indexedHits(rays);
+	linear = benchBvhRepeat([&]() {
+		for (int r = 0; r < rays; r++) {
+			glm::vec3 inverse = 1.0f / directions[r];
+			float best = FLT_MAX;
+			for (int i = 0; i < count; i++) {
+				glm::vec3 t0 = (boxes[i].min - origins[r]) * inverse, t1 = (boxes[i].max - origins[r]) * inverse;
+				glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+				float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+				float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, best));
+				if (enter <= exit && enter < best) best = enter;
+			}
+			linearHits[r] = best;
+			if (count >= 100000) break;   // one ray is enough to time the scan
+		}
+	});
+	if (count >= 100000) linear *= rays;
+	indexed = benchBvhRepeat([&]() {
+		for (int r = 0; r < rays; r++) bvh.raycast(origins[r], directions[r], indexedHits[r]);
+	});
+	if (count < 100000) for (int r = 0; r < rays; r++) mismatches += linearHits[r] != indexedHits[r];
+	printf("    ray (nearest)    %8.3f us  linear %8.3f us  x%6.1f  (%.2f M rays/s)\n", indexed * 1000.0 / rays, linear * 1000.0 / rays,
+		linear / indexed, rays / indexed / 1000.0);
+
+	// proximity: spheres of radius 5 and boxes of 10^3 around the ray origins
+	const int probes = 1000;
+	int linearTotal = 0, indexedTotal = 0;
+	linear = benchBvhRepeat([&]() {
+		linearTotal = 0;
+		for (int p = 0; p < probes; p++) {
+			for (int i = 0; i < count; i++) {
+				glm::vec3 d = glm::max(glm::max(boxes[i].min - origins[p], origins[p] - boxes[i].max), glm::vec3(0.0f));
+				linearTotal += glm::dot(d, d) <= 25.0f ? 1 : 0;
+			}
+			if (count >= 100000) break;
+		}
+	});
+	if (count >= 100000) linear *= probes;
+	indexed = benchBvhRepeat([&]() {
+		indexedTotal = 0;
+		for (int p = 0; p < probes; p++) bvh.querySphere(origins[p], 5.0f, [&](int) { indexedTotal++; });
+	});
+	if (count < 100000) mismatches += linearTotal != indexedTotal;
+	printf("    sphere r=5       %8.3f us  linear %8.3f us  x%6.1f  (%.1f found)\n", indexed * 1000.0 / probes, linear * 1000.0 / probes,
+		linear / indexed, (double)indexedTotal / probes);
+
+	linear = benchBvhRepeat([&]() {
+		linearTotal = 0;
+		for (int p = 0; p < probes; p++) {
+			AABB probe(origins[p] - glm::vec3(5.0f), origins[p] + glm::vec3(5.0f));
+			for (int i = 0; i < count; i++) linearTotal += boxes[i].overlaps(probe) ? 1 : 0;
+			if (count >= 100000) break;
+		}
+	});
+	if (count >= 100000) linear *= probes;
+	indexed = benchBvhRepeat([&]() {
+		indexedTotal = 0;
+		for (int p = 0; p < probes; p++) {
+			bvh.queryAABB(AABB(origins[p] - glm::vec3(5.0f), origins[p] + glm::vec3(5.0f)), [&](int) { indexedTotal++; });
+		}
+	});
+	if (count < 100000) mismatches += linearTotal != indexedTotal;
+	printf("    box 10^3         %8.3f us  linear %8.3f us  x%6.1f  (%.1f found)\n", indexed * 1000.0 / probes, linear * 1000.0 / probes,
+		linear / indexed, (double)indexedTotal / probes);
+	printf("    %d mismatches against the linear scans\n", mismatches);
+}
+
+void benchBvh() {
+	printf("spatial index (BVH, binned SAH, refit + rebuild)\n");
+	benchBvhScene(10000);
+	benchBvhScene(100000);
+	benchBvhScene(1000000);
+}
+
+#endif // !BENCH_BVH_H
@@ -0,0 +1,76 @@
+// bench_culling.h
+//
+// Frustum culling (frustum.h) of large random scenes: the scalar loop, the SIMD kernel on one
+// thread and FrustumCuller::cull (SIMD in parallel chunks), per frame.
+
+#ifndef BENCH_CULLING_H
+#define BENCH_CULLING_H
+
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include "frustum.h"
+#include "bench_utils.h"
+
+// times cull() until 0.2 s have passed; returns milliseconds per call
+template <typename Cull>
+inline double benchCullFrame(const Cull &cull) {
+	int iterations = 0;
+	BenchTimer timer;
+	do {
+		cull();
+		iterations++;
+	} while (timer.seconds() < 0.2);
+	return timer.milliseconds() / iterations;
+}
+
+inline void benchCullingScene(int count) {
+	// objects scattered in a 200 x 40 x 200 box around a camera looking down -z
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> across(-100.0f, 100.0f), up(-20.0f, 20.0f), size(0.2f, 2.0f);
+	std::vector<float> x(count), y(count), z(count), r(count);
+	for (int i = 0; i < count; i++) {
+		x[i] = across(random); y[i] = up(random); z[i] = across(random); r[i] = size(random);
+	}
+	FrustumCuller culler;
+	culler.reserve(count);
+	for (int i = 0; i < count; i++) culler.add(BoundingSphere(glm::vec3(x[i], y[i], z[i]), r[i]));
+
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 2.0f, 0.1f, 100.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 viewProjection = projection * view;
+	Frustum frustum = Frustum::fromMatrix(viewProjection);
+
+	std::vector<unsigned char> scalarVisible(count), simdVisible(count);
+
+	int visible = 0;
+	double scalar = benchCullFrame([&]() {
+		visible = cullSpheresScalar(frustum, &x[0], &y[0], &z[0], &r[0], 0, count, &scalarVisible[0]);
+	});
+	double simd = benchCullFrame([&]() {
+		cullSpheresKernel(frustum, &x[0], &y[0], &z[0], &r[0], 0, count, &simdVisible[0]);
+	});
+	drawStats().reset();
+	int frames = 0;
+	double pooled = benchCullFrame([&]() {
+		culler.cull(viewProjection);
+		frames++;
+	});
+
+	int mismatches = 0;
+	for (int i = 0; i < count; i++) {
+		if (scalarVisible[i] != simdVisible[i] || scalarVisible[i] != (culler.isVisible(i) ? 1 : 0)) mismatches++;
+	}
+	printf("  %7d objects: %7d culled (%4.1f%%) | scalar %7.3f ms | simd %7.3f ms x%.1f | parallel simd %7.3f ms x%.1f (%.3f ms in drawStats) | %d mismatches\n",
+		count, count - visible, 100.0 * (count - visible) / count, scalar, simd, scalar / simd, pooled, scalar / pooled,
+		drawStats().cullMilliseconds / frames, mismatches);
+}
+
+void benchCulling() {
+	printf("frustum culling (%d threads)\n", ThreadPool::instance().threadCount());
+	benchCullingScene(10000);
+	benchCullingScene(100000);
+	benchCullingScene(1000000);
+}
+
+#endif // !BENCH_CULLING_H
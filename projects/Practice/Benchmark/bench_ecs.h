@@ -0,0 +1,100 @@
+// bench_ecs.h
+//
+// One frame of a moving scene (motion, world matrices, draw gathering) for 100k+ entities:
+// the archetype ECS (ecs.h, scene.h) against heap objects reached through a pointer list, the
+// layout the demos used before.
+
+#ifndef BENCH_ECS_H
+#define BENCH_ECS_H
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "scene.h"
+#include "bench_utils.h"
+
+// the pointer layout: one heap object per scene object, updated and submitted through a virtual call
+class BenchSceneObject {
+public:
+	Transform transform;
+	Velocity velocity;
+	glm::mat4 model;
+	MeshHandle mesh;
+	Material material;
+
+	virtual ~BenchSceneObject() { }
+
+	virtual void update(float dt) {
+		transform.position += velocity.linear * dt;
+		float angle = glm::length(velocity.angular) * dt;
+		if (angle > 0.0f) transform.rotation = glm::normalize(glm::angleAxis(angle, glm::normalize(velocity.angular)) * transform.rotation);
+		model = transform.matrix();
+	}
+
+	virtual void submit(std::vector<InstanceData> &out) {
+		out.push_back(InstanceData(model, material.color));
+	}
+};
+
+// times frame() until 0.3 s have passed; returns milliseconds per call
+template <typename Frame>
+inline double benchEcsFrame(const Frame &frame) {
+	int iterations = 0;
+	BenchTimer timer;
+	do {
+		frame();
+		iterations++;
+	} while (timer.seconds() < 0.3);
+	return timer.milliseconds() / iterations;
+}
+
+inline void benchEcsScene(int count) {
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	const int meshCount = 4;
+
+	World world;
+	world.reserve<Transform, Velocity, WorldMatrix, MeshHandle, Material>(count);
+	std::vector<BenchSceneObject *> objects;
+	for (int i = 0; i < count; i++) {
+		Transform transform(glm::vec3(unit(random), unit(random), unit(random)) * 100.0f);
+		Velocity velocity(glm::vec3(unit(random), unit(random), unit(random)), glm::vec3(0.0f, unit(random), 0.0f));
+		MeshHandle mesh = MeshHandle::elements(1 + i % meshCount, 36);
+		Material material(NULL, glm::vec4(1.0f), true);
+		world.create(transform, velocity, WorldMatrix(), mesh, material);
+
+		BenchSceneObject *object = new BenchSceneObject();
+		object->transform = transform; object->velocity = velocity; object->mesh = mesh; object->material = material;
+		objects.push_back(object);
+	}
+	// objects created over a program's life end up scattered: visit them in a shuffled order
+	std::shuffle(objects.begin(), objects.end(), random);
+
+	std::vector<DrawBatch> batches;
+	double ecs = benchEcsFrame([&]() {
+		integrateMotion(world, 0.016f);
+		updateWorldMatrices(world);
+		gatherDrawBatches(world, batches);
+		benchKeep(batches[0].instances[0].model[3][0]);
+	});
+
+	std::vector<std::vector<InstanceData> > pointerBatches(meshCount);
+	double pointers = benchEcsFrame([&]() {
+		for (int m = 0; m < meshCount; m++) pointerBatches[m].clear();
+		for (size_t i = 0; i < objects.size(); i++) objects[i]->update(0.016f);
+		for (size_t i = 0; i < objects.size(); i++) objects[i]->submit(pointerBatches[objects[i]->mesh.VAO - 1]);
+		benchKeep(pointerBatches[0][0].model[3][0]);
+	});
+
+	printf("  %7d entities, %d batches: pointer objects %8.3f ms | ecs %8.3f ms  x%.1f\n",
+		count, (int)batches.size(), pointers, ecs, pointers / ecs);
+	for (size_t i = 0; i < objects.size(); i++) delete objects[i];
+}
+
+void benchEcs() {
+	printf("entity-component scene update (%d threads)\n", ThreadPool::instance().threadCount());
+	benchEcsScene(100000);
+	benchEcsScene(300000);
+}
+
+#endif // !BENCH_ECS_H
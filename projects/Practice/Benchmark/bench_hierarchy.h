@@ -0,0 +1,97 @@
+// bench_hierarchy.h
+//
+// World matrices for a 100k node transform tree (transform_hierarchy.h): the flattened linear
+// pass with everything dirty and with a few moved subtrees, against the pointer tree that is
+// walked recursively from the roots every frame.
+
+#ifndef BENCH_HIERARCHY_H
+#define BENCH_HIERARCHY_H
+
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include "transform_hierarchy.h"
+#include "bench_utils.h"
+
+// the naive layout: heap nodes with child pointers, every world matrix rebuilt every frame
+struct RecursiveTransformNode {
+	glm::mat4 local;
+	glm::mat4 world;
+	std::vector<RecursiveTransformNode *> children;
+};
+
+inline void benchRecursiveUpdate(RecursiveTransformNode *node, const glm::mat4 &parent) {
+	node->world = parent * node->local;
+	for (size_t i = 0; i < node->children.size(); i++) benchRecursiveUpdate(node->children[i], node->world);
+}
+
+// times frame() until 0.2 s have passed; returns milliseconds per call
+template <typename Frame>
+inline double benchHierarchyFrame(const Frame &frame) {
+	int iterations = 0;
+	BenchTimer timer;
+	do {
+		frame(iterations);
+		iterations++;
+	} while (timer.seconds() < 0.2);
+	return timer.milliseconds() / iterations;
+}
+
+void benchHierarchy() {
+	const int nodeCount = 100000, rootCount = 16;
+	printf("transform hierarchy (%d nodes, %d roots)\n", nodeCount, rootCount);
+
+	// random recursive tree: each node hangs off a uniformly chosen earlier one (depth grows like ln n)
+	std::mt19937 random(7);
+	std::vector<int> parents(nodeCount);
+	std::vector<glm::mat4> locals(nodeCount);
+	for (int i = 0; i < nodeCount; i++) {
+		parents[i] = i < rootCount ? TransformHierarchy::NO_PARENT : (int)(random() % i);
+		locals[i] = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(0.01f * (i % 7), 0.02f, 0.0f)),
+			0.001f * (i % 13), glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+
+	TransformHierarchy tree;
+	tree.reserve(nodeCount);
+	for (int i = 0; i < nodeCount; i++) tree.addNode(parents[i], locals[i]);
+	tree.update();
+
+	std::vector<RecursiveTransformNode> pointerNodes(nodeCount);
+	std::vector<RecursiveTransformNode *> roots;
+	for (int i = 0; i < nodeCount; i++) {
+		pointerNodes[i].local = locals[i];
+		if (parents[i] == TransformHierarchy::NO_PARENT) roots.push_back(&pointerNodes[i]);
+		else pointerNodes[parents[i]].children.push_back(&pointerNodes[i]);
+	}
+
+	double recursive = benchHierarchyFrame([&](int) {
+		for (size_t r = 0; r < roots.size(); r++) benchRecursiveUpdate(roots[r], glm::mat4(1.0f));
+		benchKeep(pointerNodes[nodeCount - 1].world[3][0]);
+	});
+	printf("  recursive, all nodes:     %8.3f ms\n", recursive);
+
+	double full = benchHierarchyFrame([&](int frame) {
+		for (int r = 0; r < rootCount; r++) tree.setLocal(r, glm::translate(glm::mat4(1.0f), glm::vec3(0.001f * frame, 0.0f, 0.0f)));
+		tree.update();
+		benchKeep(tree.getWorld(nodeCount - 1)[3][0]);
+	});
+	printf("  flattened, all dirty:     %8.3f ms  x%.1f\n", full, recursive / full);
+
+	const int moved[] = { 10, 100, 1000 };
+	for (int m = 0; m < 3; m++) {
+		int recomputed = 0;
+		double sparse = benchHierarchyFrame([&](int frame) {
+			for (int k = 0; k < moved[m]; k++) {
+				int node = nodeCount / 2 + (int)(((unsigned int)(frame * moved[m] + k) * 2654435761u) % (nodeCount / 2));
+				tree.getLocal(node)[3][2] += 0.001f;
+				tree.markDirty(node);
+			}
+			recomputed = tree.update();
+			benchKeep(tree.getWorld(nodeCount - 1)[3][0]);
+		});
+		printf("  flattened, %4d moved:     %8.3f ms  x%.1f  (%d world matrices recomputed)\n",
+			moved[m], sparse, recursive / sparse, recomputed);
+	}
+}
+
+#endif // !BENCH_HIERARCHY_H
@@ -0,0 +1,114 @@
+// bench_hlod.h
+//
+// Hierarchical LOD (hlod.h) on a synthetic city: blocks of box buildings with pyramid roofs and
+// bucket water tanks. Building the cluster tree and its proxies, then per-frame selection from a
+// street-level and an aerial camera, against drawing every object that is in view.
+
+#ifndef BENCH_HLOD_H
+#define BENCH_HLOD_H
+
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include "hlod.h"
+#include "bench_utils.h"
+
+inline void benchHlodView(const HLOD &hlod, const char *name, const glm::vec3 &eye, const glm::vec3 &target, float maxPixelError) {
+	const float viewportHeight = 600.0f;
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 5000.0f);
+	glm::mat4 view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum = Frustum::fromMatrix(projection * view);
+
+	// without HLOD: every object in view, one draw each
+	int flatDraws = 0;
+	long long flatTriangles = 0;
+	for (int i = 0; i < hlod.objectCount(); i++) {
+		if (!frustum.intersects(hlod.getObjectBounds(i))) continue;
+		flatDraws++;
+		flatTriangles += hlod.getObjectTriangles(i);
+	}
+
+	HlodSelection selection;
+	int frames = 0;
+	BenchTimer timer;
+	do {
+		hlod.select(view, projection, viewportHeight, maxPixelError, selection, &frustum);
+		frames++;
+	} while (timer.seconds() < 0.2);
+	double ms = timer.milliseconds() / frames;
+
+	// every object in view must be drawn exactly once, by itself or inside one proxy
+	std::vector<int> covered(hlod.objectCount(), 0);
+	for (size_t i = 0; i < selection.objects.size(); i++) covered[selection.objects[i]]++;
+	for (size_t i = 0; i < selection.proxies.size(); i++) {
+		const HlodNode &node = hlod.getNode(selection.proxies[i]);
+		for (int k = node.firstObject; k < node.firstObject + node.objectCount; k++) covered[hlod.getObjectOrder()[k]]++;
+	}
+	int missing = 0, twice = 0;
+	for (int i = 0; i < hlod.objectCount(); i++) {
+		if (covered[i] > 1) twice++;
+		if (covered[i] == 0 && frustum.intersects(hlod.getObjectBounds(i))) missing++;
+	}
+
+	printf("    %-6s %4.1f px: %6d draws %9lld triangles -> %5d proxies + %5d objects = %5d draws %8lld triangles"
+		" (x%.0f draws, x%.1f triangles) | select %6.3f ms | %d missing, %d twice\n",
+		name, maxPixelError, flatDraws, flatTriangles, (int)selection.proxies.size(), (int)selection.objects.size(),
+		selection.drawCount(), selection.triangles, (double)flatDraws / std::max(1, selection.drawCount()),
+		(double)flatTriangles / std::max(1LL, selection.triangles), ms, missing, twice);
+}
+
+inline void benchHlodCity(int blocks) {
+	// the three primitives every object is made of
+	VectorSink cube, roof, tank;
+	generateCube(CubeShape(), cube);
+	PyramidShape pyramid;
+	generatePyramid(pyramid, roof);
+	BucketShape bucket;
+	bucket.topN = 20; bucket.bottomN = 10;
+	generateBucket(bucket, tank);
+
+	// blocks of 4 buildings 30 units apart; each building a box, a roof and a water tank
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> height(4.0f, 30.0f), width(6.0f, 11.0f);
+	std::vector<HlodObject> objects;
+	for (int bz = 0; bz < blocks; bz++) {
+		for (int bx = 0; bx < blocks; bx++) {
+			for (int b = 0; b < 4; b++) {
+				glm::vec3 base(bx * 30.0f + (b & 1) * 13.0f, 0.0f, bz * 30.0f + (b >> 1) * 13.0f);
+				float h = height(random), w = width(random), d = width(random);
+				glm::mat4 building = glm::scale(glm::translate(glm::mat4(1.0f), base + glm::vec3(0.0f, h * 0.5f, 0.0f)), glm::vec3(w, h, d));
+				objects.push_back(HlodObject(&cube, building));
+				glm::mat4 top = glm::scale(glm::translate(glm::mat4(1.0f), base + glm::vec3(0.0f, h + 1.0f, 0.0f)), glm::vec3(w, 2.0f, d));
+				objects.push_back(HlodObject(&roof, top));
+				glm::mat4 water = glm::scale(glm::translate(glm::mat4(1.0f), base + glm::vec3(w * 0.25f, h + 1.0f, d * 0.25f)), glm::vec3(1.0f, 2.0f, 1.0f));
+				objects.push_back(HlodObject(&tank, water));
+			}
+		}
+	}
+
+	HLOD hlod;
+	BenchTimer timer;
+	hlod.build(&objects[0], (int)objects.size());
+	double buildMs = timer.milliseconds();
+	long long inputTriangles = 0;
+	for (int i = 0; i < hlod.objectCount(); i++) inputTriangles += hlod.getObjectTriangles(i);
+	printf("  %d x %d blocks, %d objects, %lld triangles: build %.0f ms, %d clusters, proxy triangles per height:",
+		blocks, blocks, (int)objects.size(), inputTriangles, buildMs, hlod.nodeCount());
+	for (int h = 0; h <= hlod.getNode(0).height; h++) printf(" %lld", hlod.proxyTriangles(h));
+	printf("\n");
+
+	float size = blocks * 30.0f;
+	glm::vec3 center(size * 0.5f, 0.0f, size * 0.5f);
+	benchHlodView(hlod, "street", glm::vec3(-5.0f, 2.0f, -5.0f), center, 1.0f);
+	benchHlodView(hlod, "street", glm::vec3(-5.0f, 2.0f, -5.0f), center, 4.0f);
+	benchHlodView(hlod, "aerial", glm::vec3(center.x, size * 0.6f, -size * 0.3f), center, 1.0f);
+	benchHlodView(hlod, "aerial", glm::vec3(center.x, size * 0.6f, -size * 0.3f), center, 4.0f);
+}
+
+void benchHlod() {
+	printf("hierarchical LOD on a synthetic city (%d threads)\n", ThreadPool::instance().threadCount());
+	benchHlodCity(32);
+	benchHlodCity(100);
+}
+
+#endif // !BENCH_HLOD_H
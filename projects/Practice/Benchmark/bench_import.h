@@ -0,0 +1,155 @@
+// bench_import.h
+//
+// CPU side of Model loading (mesh_import.h) on a synthetic model of 300 meshes laid out the way
+// assimp returns them (separate position / normal / texture coordinate arrays, one index array
+// per face): the old per-vertex push_back conversion with its copies into the Mesh, and the
+// preallocated conversion on worker pools of 1, 2, 4 and 8 threads. Reading the file and the GL
+// uploads are not part of it (no assimp and no context here).
+
+#ifndef BENCH_IMPORT_H
+#define BENCH_IMPORT_H
+
+#include <random>
+#include <vector>
+#include "mesh_import.h"
+#include "bench_utils.h"
+
+struct BenchAiVector3 {
+	float x, y, z;
+};
+
+struct BenchAiFace {
+	unsigned int mNumIndices;
+	unsigned int *mIndices;
+};
+
+// the members of aiMesh that the conversion reads
+struct BenchAiMesh {
+	unsigned int mNumVertices, mNumFaces, mMaterialIndex;
+	BenchAiVector3 *mVertices, *mNormals, *mTextureCoords[8];
+	BenchAiFace *mFaces;
+
+	// a side x side grid, 2 triangles per cell
+	explicit BenchAiMesh(int side) {
+		mNumVertices = side * side;
+		mNumFaces = (side - 1) * (side - 1) * 2;
+		mMaterialIndex = 0;
+		mVertices = new BenchAiVector3[mNumVertices];
+		mNormals = new BenchAiVector3[mNumVertices];
+		for (int i = 0; i < 8; i++) mTextureCoords[i] = NULL;
+		mTextureCoords[0] = new BenchAiVector3[mNumVertices];
+		for (unsigned int i = 0; i < mNumVertices; i++) {
+			float u = (float)(i % side) / side, v = (float)(i / side) / side;
+			BenchAiVector3 position = { u, 0.1f * std::sin(u * 10.0f), v }, normal = { 0.0f, 1.0f, 0.0f }, uv = { u, v, 0.0f };
+			mVertices[i] = position; mNormals[i] = normal; mTextureCoords[0][i] = uv;
+		}
+		mFaces = new BenchAiFace[mNumFaces];
+		int face = 0;
+		for (int y = 0; y + 1 < side; y++) {
+			for (int x = 0; x + 1 < side; x++) {
+				unsigned int a = y * side + x, b = a + 1, c = a + side, d = c + 1;
+				unsigned int corners[2][3] = { { a, c, b }, { b, c, d } };
+				for (int t = 0; t < 2; t++, face++) {
+					mFaces[face].mNumIndices = 3;
+					mFaces[face].mIndices = new unsigned int[3];
+					for (int k = 0; k < 3; k++) mFaces[face].mIndices[k] = corners[t][k];
+				}
+			}
+		}
+	}
+
+	~BenchAiMesh() {
+		for (unsigned int i = 0; i < mNumFaces; i++) delete[] mFaces[i].mIndices;
+		delete[] mFaces;
+		delete[] mVertices;
+		delete[] mNormals;
+		delete[] mTextureCoords[0];
+	}
+
+private:
+	BenchAiMesh(const BenchAiMesh &);
+	BenchAiMesh &operator=(const BenchAiMesh &);
+};
+
+// the conversion as Model::processMesh did it: push_back without reserve, then the by-value
+// Mesh(vertices, indices, textures) constructor copying both arrays twice
+inline void benchImportLegacy(const BenchAiMesh &mesh, MeshData &out) {
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	for (unsigned int i = 0; i < mesh.mNumVertices; i++) {
+		Vertex vertex;
+		vertex.Position = glm::vec3(mesh.mVertices[i].x, mesh.mVertices[i].y, mesh.mVertices[i].z);
+		vertex.Normal = glm::vec3(mesh.mNormals[i].x, mesh.mNormals[i].y, mesh.mNormals[i].z);
+		vertex.TexCoords = glm::vec2(mesh.mTextureCoords[0][i].x, mesh.mTextureCoords[0][i].y);
+		vertices.push_back(vertex);
+	}
+	for (unsigned int i = 0; i < mesh.mNumFaces; i++) {
+		BenchAiFace face = mesh.mFaces[i];
+		for (unsigned int j = 0; j < face.mNumIndices; j++) indices.push_back(face.mIndices[j]);
+	}
+	std::vector<Vertex> argumentVertices(vertices);
+	std::vector<unsigned int> argumentIndices(indices);
+	out.vertices = argumentVertices;
+	out.indices = argumentIndices;
+	out.bounds = AABB();
+	for (size_t i = 0; i < out.vertices.size(); i++) out.bounds.extend(out.vertices[i].Position);
+}
+
+template <typename Load>
+inline double benchImportTime(const Load &load) {
+	int iterations = 0;
+	BenchTimer timer;
+	do {
+		load();
+		iterations++;
+	} while (timer.seconds() < 0.5);
+	return timer.milliseconds() / iterations;
+}
+
+void benchImport() {
+	// 300 meshes from 10 x 10 to 120 x 120 vertices, as in a scene exported object by object
+	std::mt19937 random(9);
+	std::vector<BenchAiMesh *> meshes;
+	long long vertexCount = 0, indexCount = 0;
+	for (int i = 0; i < 300; i++) {
+		int side = 10 + (int)(random() % 111u);
+		meshes.push_back(new BenchAiMesh(side));
+		vertexCount += meshes.back()->mNumVertices;
+		indexCount += meshes.back()->mNumFaces * 3;
+	}
+	printf("mesh import, %d meshes, %.2f M vertices, %.2f M indices\n", (int)meshes.size(), vertexCount / 1e6, indexCount / 1e6);
+
+	double legacy = benchImportTime([&]() {
+		for (size_t i = 0; i < meshes.size(); i++) {
+			MeshData data;
+			benchImportLegacy(*meshes[i], data);
+			benchKeep(data.bounds.max.x);
+		}
+	});
+	printf("  push_back, 1 thread        %8.2f ms\n", legacy);
+
+	int mismatches = 0;
+	for (int threads = 1; threads <= 8; threads *= 2) {
+		ThreadPool pool(threads);
+		double converted = benchImportTime([&]() {
+			std::vector<MeshData> data(meshes.size());
+			convertMeshes(&meshes[0], (int)meshes.size(), &data[0], pool);
+			benchKeep(data[0].bounds.max.x);
+		});
+		printf("  preallocated, %d thread%s   %8.2f ms  x%.1f\n", threads, threads > 1 ? "s" : " ", converted, legacy / converted);
+		if (threads == 1) {
+			std::vector<MeshData> data(meshes.size());
+			convertMeshes(&meshes[0], (int)meshes.size(), &data[0], pool);
+			for (size_t i = 0; i < meshes.size(); i++) {
+				MeshData expected;
+				benchImportLegacy(*meshes[i], expected);
+				if (data[i].indices != expected.indices || data[i].vertices.size() != expected.vertices.size() ||
+					memcmp(&data[i].vertices[0], &expected.vertices[0], expected.vertices.size() * sizeof(Vertex)) != 0) mismatches++;
+			}
+		}
+	}
+	printf("  %d meshes differ from the push_back conversion (%d hardware threads)\n", mismatches, (int)std::thread::hardware_concurrency());
+	for (size_t i = 0; i < meshes.size(); i++) delete meshes[i];
+}
+
+#endif // !BENCH_IMPORT_H
@@ -0,0 +1,79 @@
+// bench_impostor.h
+//
+// The CPU side of impostors (octahedral.h, instance_data.h): how far the nearest baked view can
+// be from the viewing direction per atlas grid size, the frame blend weights, and the per-frame
+// cost of splitting a fleet into full meshes and impostors by distance.
+
+#ifndef BENCH_IMPOSTOR_H
+#define BENCH_IMPOSTOR_H
+
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include "octahedral.h"
+#include "instance_data.h"
+#include "fighter_shape.h"
+#include "bench_utils.h"
+
+inline void benchImpostorGrid(int gridSize) {
+	std::mt19937 random(3);
+	std::normal_distribution<float> normal;
+	const int samples = 200000;
+	float worstRoundTrip = 0.0f, worstNearest = 0.0f, worstWeightSum = 0.0f;
+	double sumNearest = 0.0;
+	for (int i = 0; i < samples; i++) {
+		glm::vec3 direction = glm::normalize(glm::vec3(normal(random), normal(random), normal(random)));
+		worstRoundTrip = std::max(worstRoundTrip, glm::length(octahedralDecode(octahedralEncode(direction)) - direction));
+		OctahedralFrames frames = octahedralFrames(direction, gridSize);
+		float nearest = 180.0f, weightSum = 0.0f;
+		for (int k = 0; k < 3; k++) {
+			glm::vec3 view = octahedralFrameDirection(frames.x[k], frames.y[k], gridSize);
+			nearest = std::min(nearest, glm::degrees(std::acos(std::min(1.0f, glm::dot(view, direction)))));
+			weightSum += frames.weight[k];
+		}
+		worstNearest = std::max(worstNearest, nearest);
+		sumNearest += nearest;
+		worstWeightSum = std::max(worstWeightSum, std::fabs(weightSum - 1.0f));
+	}
+	printf("  %2d x %2d views: nearest view %5.2f deg mean, %5.2f deg worst | round trip error %.1e | weight sum error %.1e\n",
+		gridSize, gridSize, sumNearest / samples, worstNearest, worstRoundTrip, worstWeightSum);
+}
+
+inline void benchImpostorSplit(int count, float impostorDistance) {
+	// a square fleet 0.5 apart, seen from its edge
+	int side = (int)std::sqrt((float)count);
+	std::vector<InstanceData> planes;
+	for (int i = 0; i < side * side; i++) {
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3((i % side) * 0.5f, 0.0f, -(i / side) * 0.5f));
+		planes.push_back(InstanceData(glm::scale(model, glm::vec3(0.05f)), glm::vec4(1.0f)));
+	}
+	std::vector<InstanceData> nearby, distant;
+	glm::vec3 camera(side * 0.25f, 2.0f, 5.0f);
+	int frames = 0;
+	BenchTimer timer;
+	do {
+		nearby.clear();
+		distant.clear();
+		splitByDistance(&planes[0], (int)planes.size(), glm::vec3(0.0f), camera, impostorDistance, nearby, distant);
+		frames++;
+	} while (timer.seconds() < 0.2);
+	// the fighter plane baked as one mesh; an impostor is 2 triangles
+	long plane = FighterShape().merge().triangleCount();
+	long full = plane * (long)planes.size(), mixed = plane * (long)nearby.size() + 2L * (long)distant.size();
+	printf("  %7d planes, impostors beyond %4.0f: %7d full + %7d impostors, 2 draw calls | %8.0f k -> %7.0f k triangles | split %6.3f ms\n",
+		(int)planes.size(), impostorDistance, (int)nearby.size(), (int)distant.size(), full / 1000.0, mixed / 1000.0,
+		timer.milliseconds() / frames);
+}
+
+void benchImpostor() {
+	printf("octahedral impostor views\n");
+	benchImpostorGrid(4);
+	benchImpostorGrid(8);
+	benchImpostorGrid(16);
+	printf("fleet split by distance\n");
+	benchImpostorSplit(10000, 20.0f);
+	benchImpostorSplit(100000, 20.0f);
+	benchImpostorSplit(100000, 40.0f);
+}
+
+#endif // !BENCH_IMPOSTOR_H
@@ -0,0 +1,62 @@
+// bench_lod.h
+//
+// Triangle savings of screen-size LOD selection (lod.h) on a scene of many buckets spread
+// from 2 to 200 units in front of the camera, with the projection FirstPractice uses.
+
+#ifndef BENCH_LOD_H
+#define BENCH_LOD_H
+
+#include <vector>
+#include <cstdlib>
+#include <glm/gtc/matrix_transform.hpp>
+#include "lod.h"
+#include "bench_utils.h"
+
+void benchLod() {
+	printf("bucket LOD selection\n");
+
+	const int count = 10000;
+	const float viewportHeight = 600.0f;
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 1000.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	std::vector<glm::vec3> centers(count);
+	srand(1);
+	for (int i = 0; i < count; i++) {
+		float distance = 2.0f + 198.0f * (float)i / (count - 1);
+		float x = ((rand() % 2001) / 1000.0f - 1.0f) * distance * 0.4f;
+		float y = ((rand() % 2001) / 1000.0f - 1.0f) * distance * 0.3f;
+		centers[i] = glm::vec3(x, y, -distance);
+	}
+
+	const int shapes[][2] = { { 20, 20 }, { 20, 4 }, { 12, 6 } };
+	for (int s = 0; s < 3; s++) {
+		BucketShape shape;
+		shape.topN = shapes[s][0]; shape.bottomN = shapes[s][1];
+		std::vector<BucketShape> chain = bucketLodChain(shape, 4);
+		float radius = bucketBoundingRadius(shape);
+
+		printf("  bucket %d/%d levels:", shape.topN, shape.bottomN);
+		for (int i = 0; i < (int)chain.size(); i++) printf(" %d/%d (%d tris)", chain[i].topN, chain[i].bottomN, bucketTriangleCount(chain[i]));
+		printf("\n");
+
+		std::vector<int> histogram(chain.size(), 0);
+		long long fullTriangles = 0, lodTriangles = 0;
+		BenchTimer timer;
+		for (int i = 0; i < count; i++) {
+			float pixels = projectedSphereRadius(centers[i], radius, view, projection, viewportHeight);
+			int level = selectBucketLevel(chain, pixels, 8.0f);
+			histogram[level]++;
+			fullTriangles += bucketTriangleCount(chain[0]);
+			lodTriangles += bucketTriangleCount(chain[level]);
+		}
+		double ms = timer.milliseconds();
+
+		printf("    %d buckets: %lld -> %lld triangles (%.1f%% saved), selection %.3f ms, per level:",
+			count, fullTriangles, lodTriangles, 100.0 * (fullTriangles - lodTriangles) / fullTriangles, ms);
+		for (int i = 0; i < (int)histogram.size(); i++) printf(" %d", histogram[i]);
+		printf("\n");
+	}
+}
+
+#endif // !BENCH_LOD_H
@@ -0,0 +1,134 @@
+// bench_mesh_cache.h
+//
+// Repeat loads of a model through the binary mesh cache (mesh_cache.h) against converting it again,
+// on the synthetic 300 mesh model of bench_import.h. Both end with the bytes the GL upload would
+// read copied to a staging buffer, standing in for glBufferData. Also checks that the cache gives
+// back exactly what was written, and that changing the source or the importer flags makes it stale.
+// Reading the model file itself is not part of either side (no assimp here): a real cache hit also
+// saves that parse.
+
+#ifndef BENCH_MESH_CACHE_H
+#define BENCH_MESH_CACHE_H
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "mesh_cache.h"
+#include "bench_import.h"
+#include "bench_utils.h"
+
+inline void benchMeshCacheStage(std::vector<unsigned char> &staging, const void *bytes, size_t size) {
+	if (staging.size() < size) staging.resize(size);
+	memcpy(&staging[0], bytes, size);
+	benchKeep(staging[size / 2]);
+}
+
+void benchMeshCache() {
+	std::mt19937 random(9);
+	std::vector<BenchAiMesh *> meshes;
+	for (int i = 0; i < 300; i++) meshes.push_back(new BenchAiMesh(10 + (int)(random() % 111u)));
+	std::vector<std::vector<MeshCacheTexture> > textures(meshes.size());
+	for (size_t i = 0; i < meshes.size(); i++) {
+		textures[i].push_back(MeshCacheTexture("texture_diffuse", "textures/diffuse" + std::to_string(i % 7) + ".png"));
+		if (i % 3 == 0) textures[i].push_back(MeshCacheTexture("texture_specular", "textures/specular.png"));
+	}
+
+	// the cache is keyed by a source file: any file will do
+	std::string source = "bench_mesh_cache.source", cache = meshCachePath(source);
+	FILE *file = fopen(source.c_str(), "wb");
+	if (file == NULL) {
+		printf("mesh cache: cannot write %s, skipped\n", source.c_str());
+		return;
+	}
+	fputs("synthetic model", file);
+	fclose(file);
+	const unsigned int flags = 0x8 | 0x800000;
+
+	ThreadPool pool(1);
+	long long sourceTime = 0;
+	unsigned long long sourceSize = 0;
+	fileStamp(source, sourceTime, sourceSize);
+	std::vector<MeshData> data(meshes.size());
+	convertMeshes(&meshes[0], (int)meshes.size(), &data[0], pool);
+	BenchTimer writeTimer;
+	bool written = writeMeshCache(cache, source, sourceTime, sourceSize, flags, &data[0], &textures[0], (int)data.size());
+	double writing = writeTimer.milliseconds();
+
+	MeshCacheFile mapped;
+	printf("mesh cache, %d meshes, %.1f MB file, written in %.2f ms\n", (int)meshes.size(),
+		written && mapped.open(cache, source, flags) ? mapped.size() / 1e6 : 0.0, writing);
+	mapped.close();
+
+	std::vector<unsigned char> staging;
+	double converted = benchImportTime([&]() {
+		std::vector<MeshData> out(meshes.size());
+		convertMeshes(&meshes[0], (int)meshes.size(), &out[0], pool);
+		for (size_t i = 0; i < out.size(); i++) {
+			benchMeshCacheStage(staging, &out[i].vertices[0], out[i].vertices.size() * sizeof(Vertex));
+			benchMeshCacheStage(staging, &out[i].indices[0], out[i].indices.size() * sizeof(unsigned int));
+		}
+	});
+	printf("  convert, 1 thread    %8.2f ms\n", converted);
+
+	int misses = 0;
+	double cached = benchImportTime([&]() {
+		MeshCacheFile hit;
+		if (!hit.open(cache, source, flags)) {
+			misses++;
+			return;
+		}
+		for (int i = 0; i < hit.meshCount(); i++) {
+			benchMeshCacheStage(staging, hit.vertices(i), hit.vertexCount(i) * sizeof(Vertex));
+			benchMeshCacheStage(staging, hit.indices(i), hit.indexCount(i) * sizeof(unsigned int));
+			benchKeep(hit.textures(i).size());
+		}
+	});
+	printf("  mapped cache         %8.2f ms  x%.1f%s\n", cached, converted / cached, misses > 0 ? "  (CACHE MISSED)" : "");
+
+	// round trip
+	int mismatches = 0;
+	if (!mapped.open(cache, source, flags) || mapped.meshCount() != (int)data.size()) mismatches = (int)data.size();
+	for (int i = 0; i < mapped.meshCount() && mismatches == 0; i++) {
+		std::vector<MeshCacheTexture> back = mapped.textures(i);
+		bool same = mapped.vertexCount(i) == data[i].vertices.size() && mapped.indexCount(i) == data[i].indices.size() &&
+			memcmp(mapped.vertices(i), &data[i].vertices[0], data[i].vertices.size() * sizeof(Vertex)) == 0 &&
+			memcmp(mapped.indices(i), &data[i].indices[0], data[i].indices.size() * sizeof(unsigned int)) == 0 &&
+			mapped.materialIndex(i) == data[i].materialIndex && mapped.bounds(i).max == data[i].bounds.max &&
+			back.size() == textures[i].size();
+		for (size_t t = 0; same && t < back.size(); t++) same = back[t].type == textures[i][t].type && back[t].path == textures[i][t].path;
+		if (!same) mismatches++;
+	}
+	mapped.close();
+
+	// stale: other importer flags, then a changed source
+	bool otherFlags = mapped.open(cache, source, flags | 0x2);
+	mapped.close();
+	file = fopen(source.c_str(), "ab");
+	if (file != NULL) {
+		fputs(", edited", file);
+		fclose(file);
+	}
+	bool edited = mapped.open(cache, source, flags);
+	mapped.close();
+
+	// a source saved during the import: the cache carries the stamp from before the import
+	fileStamp(source, sourceTime, sourceSize);
+	file = fopen(source.c_str(), "ab");
+	if (file != NULL) {
+		fputs(", saved again", file);
+		fclose(file);
+	}
+	writeMeshCache(cache, source, sourceTime, sourceSize, flags, &data[0], &textures[0], (int)data.size());
+	bool savedDuring = mapped.open(cache, source, flags);
+	mapped.close();
+	printf("  %d meshes differ after the round trip; stale on other flags: %s, on an edited source: %s, on one saved during the import: %s\n",
+		mismatches, otherFlags ? "NO" : "yes", edited ? "NO" : "yes", savedDuring ? "NO" : "yes");
+
+	remove(cache.c_str());
+	remove(source.c_str());
+	for (size_t i = 0; i < meshes.size(); i++) delete meshes[i];
+}
+
+#endif // !BENCH_MESH_CACHE_H
@@ -0,0 +1,95 @@
+// bench_normals.h
+//
+// Face normals of a 100 x 100 paper sheet (40,000 triangles, the per-frame work of Paper/Paper2):
+// the old per-triangle MyUtils get_normal against the batch kernels of normals.h.
+
+#ifndef BENCH_NORMALS_H
+#define BENCH_NORMALS_H
+
+#include <cmath>
+#include <vector>
+#include "procedural.h"
+#include "normals.h"
+#include "bench_utils.h"
+
+// MyUtils get_normal as it was, kept here only for comparison
+inline float *legacyGetNormal(float v1_x, float v1_y, float v1_z, float v2_x, float v2_y, float v2_z, float v3_x, float v3_y, float v3_z) {
+	float vec1_x = v1_x - v2_x; float vec1_y = v1_y - v2_y; float vec1_z = v1_z - v2_z;
+	float vec2_x = v1_x - v3_x; float vec2_y = v1_y - v3_y; float vec2_z = v1_z - v3_z;
+	float vec1_vec1_inner_product = pow(vec1_x, 2) + pow(vec1_y, 2) + pow(vec1_z, 2);
+	float vec1_vec2_inner_product = vec1_x * vec2_x + vec1_y * vec2_y + vec1_z * vec2_z;
+	float vec3_x = vec2_x - (vec1_x*vec1_vec2_inner_product / vec1_vec1_inner_product);
+	float vec3_y = vec2_y - (vec1_y*vec1_vec2_inner_product / vec1_vec1_inner_product);
+	float vec3_z = vec2_z - (vec1_z*vec1_vec2_inner_product / vec1_vec1_inner_product);
+	float vec4_x = v1_x; float vec4_y = v1_y; float vec4_z = v1_z + 10.0f;
+	float vec3_vec3_inner_product = pow(vec3_x, 2) + pow(vec3_y, 2) + pow(vec3_z, 2);
+	float vec1_vec4_inner_product = vec1_x * vec4_x + vec1_y * vec4_y + vec1_z * vec4_z;
+	float vec3_vec4_inner_product = vec3_x * vec4_x + vec3_y * vec4_y + vec3_z * vec4_z;
+	float vec5_x = vec4_x - (vec1_x*vec1_vec4_inner_product / vec1_vec1_inner_product) - (vec3_x*vec3_vec4_inner_product / vec3_vec3_inner_product);
+	float vec5_y = vec4_y - (vec1_y*vec1_vec4_inner_product / vec1_vec1_inner_product) - (vec3_y*vec3_vec4_inner_product / vec3_vec3_inner_product);
+	float vec5_z = vec4_z - (vec1_z*vec1_vec4_inner_product / vec1_vec1_inner_product) - (vec3_z*vec3_vec4_inner_product / vec3_vec3_inner_product);
+	float *ret = new float[3];
+	ret[0] = vec5_x; ret[1] = vec5_y; ret[2] = vec5_z;
+	return ret;
+}
+
+template <typename Run>
+double benchNormalsRun(const char *name, int triangles, Run run, double baseline) {
+	int iterations = 0;
+	BenchTimer timer;
+	do {
+		run();
+		iterations++;
+	} while (timer.seconds() < 0.3);
+	double ms = timer.milliseconds() / iterations;
+	printf("  %-28s %8.3f ms/frame %8.1f Mtris/s", name, ms, triangles / ms / 1000.0);
+	if (baseline > 0.0) printf("   x%.1f", baseline / ms);
+	printf("\n");
+	return ms;
+}
+
+void benchNormals() {
+	printf("face normals (%d threads)\n", ThreadPool::instance().threadCount());
+
+	PaperShape shape;
+	shape.width = 5.0f; shape.height = 4.0f;
+	const int triangles = paperCounts(shape).vertices / 3;
+	std::vector<float> positions(triangles * 9), normals(triangles * 9), reference(triangles * 9);
+	ArraySink sheet(&positions[0], NULL, NULL, triangles * 3);
+	generatePaper(shape, sheet);
+	for (int i = 0; i < triangles * 3; i++) positions[i * 3 + 2] = 0.1f * sinf(positions[i * 3] * 3.0f) * cosf(positions[i * 3 + 1] * 2.0f);
+	glm::vec3 away(0.0f, 0.0f, -10.0f);
+
+	double legacy = benchNormalsRun("MyUtils get_normal (old)", triangles, [&]() {
+		for (int i = 0; i < triangles; i++) {
+			const float *p = &positions[i * 9];
+			float *normal = legacyGetNormal(p[0], p[1], p[2], p[3], p[4], p[5], p[6], p[7], p[8]);
+			for (int k = 0; k < 3; k++) {
+				reference[i * 9 + k * 3] = normal[0]; reference[i * 9 + k * 3 + 1] = normal[1]; reference[i * 9 + k * 3 + 2] = normal[2];
+			}
+			delete[] normal;
+		}
+	}, 0.0);
+
+	benchNormalsRun("scalar kernel", triangles, [&]() {
+		faceNormalsScalar(&positions[0], 0, triangles, &normals[0], 3, &away);
+	}, legacy);
+#ifdef NORMALS_SSE
+	benchNormalsRun("SSE kernel", triangles, [&]() {
+		faceNormalsSSE(&positions[0], 0, triangles, &normals[0], 3, &away);
+	}, legacy);
+#endif
+	benchNormalsRun("computeFaceNormals (parallel)", triangles, [&]() {
+		computeFaceNormals(&positions[0], triangles, &normals[0], 3, &away);
+	}, legacy);
+
+	// the old normals were not normalized; compare directions
+	double worst = 0.0;
+	for (int i = 0; i < triangles * 3; i++) {
+		glm::vec3 a(reference[i * 3], reference[i * 3 + 1], reference[i * 3 + 2]), b(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]);
+		worst = fmax(worst, glm::length(glm::normalize(a) - b));
+	}
+	printf("  largest direction difference to the old normals: %g\n", worst);
+}
+
+#endif // !BENCH_NORMALS_H
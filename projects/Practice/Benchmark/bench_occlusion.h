@@ -0,0 +1,114 @@
+// bench_occlusion.h
+//
+// Software occlusion culling (occlusion.h): a row of walls and one big block in front of a
+// random field of boxes. Rasterizing the occluders and testing every box, scalar kernels against
+// SIMD ones, with the share of boxes culled.
+
+#ifndef BENCH_OCCLUSION_H
+#define BENCH_OCCLUSION_H
+
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include "occlusion.h"
+#include "bench_utils.h"
+
+// runs step() until 0.2 s have passed; returns milliseconds per call
+template <typename Step>
+inline double benchOcclusionRepeat(const Step &step) {
+	int iterations = 0;
+	BenchTimer timer;
+	do {
+		step();
+		iterations++;
+	} while (timer.seconds() < 0.2);
+	return timer.milliseconds() / iterations;
+}
+
+// true if the segment from a to b passes through the box (slab test)
+inline bool benchSegmentHitsBox(const glm::vec3 &a, const glm::vec3 &b, const AABB &box) {
+	glm::vec3 d = b - a;
+	float enter = 0.0f, exit = 1.0f;
+	for (int axis = 0; axis < 3; axis++) {
+		if (std::fabs(d[axis]) < 1e-12f) {
+			if (a[axis] < box.min[axis] || a[axis] > box.max[axis]) return false;
+			continue;
+		}
+		float t0 = (box.min[axis] - a[axis]) / d[axis], t1 = (box.max[axis] - a[axis]) / d[axis];
+		enter = std::max(enter, std::min(t0, t1));
+		exit = std::min(exit, std::max(t0, t1));
+	}
+	return enter <= exit;
+}
+
+inline void benchOcclusionScene(int count) {
+	const float fov = glm::radians(60.0f), aspect = 2.0f;
+	glm::mat4 viewProjection = glm::perspective(fov, aspect, 0.1f, 200.0f) *
+		glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	// occluders: five walls 8 wide with 3 wide gaps at z = -30, a block close in front
+	std::vector<AABB> occluders;
+	for (int i = 0; i < 5; i++) {
+		float x = -27.5f + i * 11.0f;
+		occluders.push_back(AABB(glm::vec3(x, -15.0f, -31.0f), glm::vec3(x + 8.0f, 15.0f, -30.0f)));
+	}
+	occluders.push_back(AABB(glm::vec3(-3.0f, -2.0f, -9.0f), glm::vec3(3.0f, 2.0f, -7.0f)));
+	std::vector<OccluderMesh> meshes;
+	for (size_t i = 0; i < occluders.size(); i++) meshes.push_back(OccluderMesh::box(occluders[i]));
+
+	// boxes spread over the view, 5 to 150 units away
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f), distance(5.0f, 150.0f), size(0.2f, 1.0f);
+	std::vector<AABB> boxes(count);
+	float tanHalf = std::tan(fov * 0.5f);
+	for (int i = 0; i < count; i++) {
+		float u = unit(random), v = unit(random), z = distance(random), r = size(random);
+		glm::vec3 center(u * z * tanHalf * aspect, v * z * tanHalf, -z);
+		boxes[i] = AABB(center - glm::vec3(r), center + glm::vec3(r));
+	}
+
+	OcclusionBuffer occlusion;
+	std::vector<unsigned char> scalarVisible(count), simdVisible(count);
+	double rasterize[2], test[2];
+	int visible = 0;
+	for (int simd = 0; simd < 2; simd++) {
+		occlusion.simd = simd != 0;
+		rasterize[simd] = benchOcclusionRepeat([&]() {
+			occlusion.clear();
+			for (size_t i = 0; i < meshes.size(); i++) occlusion.addOccluder(meshes[i], viewProjection);
+			occlusion.rasterize();
+		});
+		unsigned char *out = simd ? &simdVisible[0] : &scalarVisible[0];
+		test[simd] = benchOcclusionRepeat([&]() {
+			visible = occlusion.testBoxes(&boxes[0], count, viewProjection, out);
+		});
+	}
+
+	// a culled box should be out of sight from the camera at its centre and all eight corners
+	int mismatches = 0, seen = 0;
+	for (int i = 0; i < count; i++) {
+		if (scalarVisible[i] != simdVisible[i]) mismatches++;
+		if (simdVisible[i]) continue;
+		for (int k = 0; k < 9; k++) {
+			const AABB &b = boxes[i];
+			glm::vec3 point = k == 8 ? b.center() : glm::vec3(k & 4 ? b.max.x : b.min.x, k & 2 ? b.max.y : b.min.y, k & 1 ? b.max.z : b.min.z);
+			bool hidden = false;
+			for (size_t o = 0; o < occluders.size() && !hidden; o++) hidden = benchSegmentHitsBox(glm::vec3(0.0f), point, occluders[o]);
+			if (!hidden) { seen++; break; }
+		}
+	}
+	printf("  %7d boxes, %d occluder triangles: %4.1f%% culled | rasterize scalar %6.3f ms simd %6.3f ms x%.1f"
+		" | test scalar %7.3f ms simd %7.3f ms x%.1f | frame %7.3f ms | %d mismatches, %d culled with a point in sight\n",
+		count, occlusion.triangleCount(), 100.0 * (count - visible) / count, rasterize[0], rasterize[1], rasterize[0] / rasterize[1],
+		test[0], test[1], test[0] / test[1], rasterize[1] + test[1], mismatches, seen);
+}
+
+void benchOcclusion() {
+	OcclusionBuffer occlusion;
+	printf("software occlusion culling (%d x %d depth, %d threads)\n", occlusion.getWidth(), occlusion.getHeight(),
+		ThreadPool::instance().threadCount());
+	benchOcclusionScene(10000);
+	benchOcclusionScene(100000);
+}
+
+#endif // !BENCH_OCCLUSION_H
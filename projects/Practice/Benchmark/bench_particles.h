@@ -0,0 +1,75 @@
+// bench_particles.h
+//
+// Particle pools (particles.h) at up to a million live particles: the time of each stage of a
+// frame (emission, integration and ageing with the scalar and the SIMD kernel, compaction,
+// writing the vertex stream) in a steady state where as many particles expire as are emitted.
+
+#ifndef BENCH_PARTICLES_H
+#define BENCH_PARTICLES_H
+
+#include <vector>
+#include "particles.h"
+#include "bench_utils.h"
+
+inline void benchParticlesSteady(int live) {
+	const float dt = 1.0f / 60.0f, lifetime = 2.0f;
+	const int perFrame = (int)(live * dt / lifetime) + 1;
+
+	ParticlePool scalarPool(live * 2), simdPool(live * 2);
+	scalarPool.simd = false;
+	ParticlePool *pools[2] = { &scalarPool, &simdPool };
+	ParticleSpawn spawn;
+	spawn.velocity = glm::vec3(0.0f, 20.0f, 0.0f);
+	spawn.spread = 0.3f;
+	spawn.positionJitter = 1.0f;
+	spawn.lifetime = lifetime;
+	spawn.lifetimeJitter = 0.1f;
+	std::vector<float> vertices(live * 2 * 4);
+
+	// fill to the steady state: one lifetime of emission
+	for (int p = 0; p < 2; p++) {
+		for (int frame = 0; frame < (int)(lifetime / dt); frame++) {
+			pools[p]->emit(perFrame, spawn);
+			pools[p]->update(dt);
+		}
+	}
+
+	const int frames = 30;
+	double emit = 0.0, integrate[2] = { 0.0, 0.0 }, compact = 0.0, write = 0.0;
+	int expired = 0;
+	for (int frame = 0; frame < frames; frame++) {
+		for (int p = 0; p < 2; p++) {
+			pools[p]->emit(perFrame, spawn);
+			pools[p]->update(dt);
+			const ParticleStats &stats = pools[p]->getStats();
+			integrate[p] += stats.integrateMilliseconds / frames;
+			if (p == 0) continue;
+			pools[p]->writeVertices(&vertices[0]);
+			emit += stats.emitMilliseconds / frames;
+			compact += stats.compactMilliseconds / frames;
+			write += stats.writeMilliseconds / frames;
+			expired += stats.expired;
+		}
+	}
+
+	// both kernels do the same arithmetic in the same order: the pools must match exactly, and
+	// hold live particles only
+	int mismatches = scalarPool.size() != simdPool.size() ? 1 : 0, expiredKept = 0;
+	for (int i = 0; i < simdPool.size(); i++) {
+		if (!(simdPool.getAge(i) < simdPool.getLifetime(i))) expiredKept++;
+		if (mismatches == 0 && (scalarPool.getPosition(i) != simdPool.getPosition(i) || scalarPool.getAge(i) != simdPool.getAge(i))) mismatches++;
+	}
+	double frame = emit + integrate[1] + compact + write;
+	printf("  %8d live, %6d emitted / %6d expired per frame: emit %6.3f ms | integrate scalar %6.2f ms simd %6.2f ms x%.1f"
+		" | compact %6.3f ms | vertices %6.2f ms | frame %6.2f ms | %d mismatches, %d expired kept\n",
+		simdPool.size(), perFrame, expired / frames, emit, integrate[0], integrate[1], integrate[0] / integrate[1], compact, write,
+		frame, mismatches, expiredKept);
+}
+
+void benchParticles() {
+	printf("particle pools (%d threads)\n", ThreadPool::instance().threadCount());
+	benchParticlesSteady(100000);
+	benchParticlesSteady(1000000);
+}
+
+#endif // !BENCH_PARTICLES_H
@@ -0,0 +1,139 @@
+// bench_procedural.h
+//
+// Generation throughput of the procedural primitives (procedural.h), without any GL upload.
+// Every primitive is generated once into a caller-owned array (ArraySink, what an uploader
+// writing into a mapped buffer does) and once into a reused VectorSink.
+// Then the compile-time tables of constexpr_mesh.h against the runtime generators they copy.
+
+#ifndef BENCH_PROCEDURAL_H
+#define BENCH_PROCEDURAL_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "procedural.h"
+#include "constexpr_mesh.h"
+#include "bench_utils.h"
+
+// the tables are complete when compiling: every vertex written, the cube's indices in place
+static_assert(StaticBucket<12, 6>::data.written == StaticBucket<12, 6>::Data::vertexCount, "compile-time bucket 12/6 is incomplete");
+static_assert(StaticBucket<20, 20>::data.written == StaticBucket<20, 20>::Data::vertexCount, "compile-time bucket 20/20 is incomplete");
+static_assert(StaticPyramid<>::data.written == StaticPyramid<>::Data::vertexCount, "compile-time pyramid is incomplete");
+static_assert(StaticCube<>::data.written == 24 && StaticCube<>::data.indices[35] == 20, "compile-time cube is incomplete");
+
+template <typename Shape, typename Generate>
+void benchPrimitive(const char *name, const Shape &shape, ProceduralCounts counts, int iterations, Generate generate) {
+	std::vector<float> positions(counts.vertices * 3), normals(counts.vertices * 3), texcoords(counts.vertices * 2);
+	std::vector<unsigned int> indices(counts.indices + 1);
+
+	BenchTimer timer;
+	for (int i = 0; i < iterations; i++) {
+		ArraySink out(&positions[0], &normals[0], &texcoords[0], counts.vertices, &indices[0], counts.indices);
+		generate(shape, out);
+		benchKeep(positions[i % positions.size()]);
+	}
+	double arraySeconds = timer.seconds();
+
+	VectorSink vectorOut;
+	timer.reset();
+	for (int i = 0; i < iterations; i++) {
+		vectorOut.positions.clear(); vectorOut.normals.clear(); vectorOut.texcoords.clear(); vectorOut.indices.clear();
+		generate(shape, vectorOut);
+		benchKeep(vectorOut.positions[i % vectorOut.positions.size()]);
+	}
+	double vectorSeconds = timer.seconds();
+
+	double bytes = counts.vertices * 8.0 * sizeof(float) + counts.indices * sizeof(unsigned int);
+	printf("  %-16s %8d verts %12.0f prims/s %10.1f Mverts/s %8.1f MB/s (array) | %12.0f prims/s (vector)\n",
+		name, counts.vertices, iterations / arraySeconds, counts.vertices * (double)iterations / arraySeconds / 1e6,
+		bytes * iterations / arraySeconds / 1e6, iterations / vectorSeconds);
+}
+
+inline float benchMaxDifference(const float *a, const std::vector<float> &b, int count) {
+	float largest = 0.0f;
+	for (int i = 0; i < count; i++) largest = std::max(largest, std::fabs(a[i] - b[i]));
+	return largest;
+}
+
+// largest difference of each attribute between a compile-time table and the runtime generator's output
+template <typename Data>
+void benchConstexprMatch(const char *name, const Data &data, const VectorSink &runtime) {
+	bool sameCounts = runtime.vertexCount() == Data::vertexCount && (int)runtime.indices.size() == (Data::indexCount > 0 ? Data::indexCount : 0);
+	if (!sameCounts) {
+		printf("  %-16s COUNTS DIFFER: %d / %d vertices\n", name, runtime.vertexCount(), Data::vertexCount);
+		return;
+	}
+	bool sameIndices = true;
+	for (int i = 0; i < Data::indexCount; i++) sameIndices = sameIndices && data.indices[i] == runtime.indices[i];
+	printf("  %-16s %4d verts, max difference: positions %.1e, normals %.1e, texcoords %.1e, indices %s\n", name, Data::vertexCount,
+		benchMaxDifference(data.positions, runtime.positions, Data::vertexCount * 3),
+		benchMaxDifference(data.normals, runtime.normals, Data::vertexCount * 3),
+		benchMaxDifference(data.texcoords, runtime.texcoords, Data::vertexCount * 2), sameIndices ? "equal" : "DIFFER");
+}
+
+// smooth sides on a bucket that is not unit sized: the normals are not the positions
+struct BenchSmoothBucketShape {
+	static constexpr float topRadius = 2.0f, bottomRadius = 1.5f;
+	static constexpr float topRatio = 1.0f, bottomRatio = 0.5f;
+	static constexpr float height = 3.0f;
+	static constexpr bool flatNormals = false;
+};
+
+void benchConstexprMeshes() {
+	printf("compile-time tables against runtime generation\n");
+	VectorSink runtime;
+	BucketShape bucket;
+	bucket.topN = 12; bucket.bottomN = 6;
+	generateBucket(bucket, runtime);
+	benchConstexprMatch("bucket 12/6", StaticBucket<12, 6>::data, runtime);
+
+	runtime = VectorSink();
+	bucket.topN = 20; bucket.bottomN = 20;
+	generateBucket(bucket, runtime);
+	benchConstexprMatch("bucket 20/20", StaticBucket<20, 20>::data, runtime);
+
+	runtime = VectorSink();
+	bucket.topN = 12; bucket.bottomN = 6;
+	bucket.topRadius = 2.0f; bucket.bottomRadius = 1.5f; bucket.bottomRatio = 0.5f; bucket.height = 3.0f;
+	bucket.flatNormals = false;
+	generateBucket(bucket, runtime);
+	benchConstexprMatch("bucket smooth", StaticBucket<12, 6, BenchSmoothBucketShape>::data, runtime);
+
+	runtime = VectorSink();
+	generatePyramid(PyramidShape(), runtime);
+	benchConstexprMatch("pyramid", StaticPyramid<>::data, runtime);
+
+	runtime = VectorSink();
+	generateCube(CubeShape(), runtime);
+	benchConstexprMatch("cube", StaticCube<>::data, runtime);
+}
+
+void benchProcedural() {
+	printf("procedural generation throughput\n");
+
+	CubeShape cube;
+	benchPrimitive("cube", cube, cubeCounts(cube), 200000,
+		[](const CubeShape &s, auto &out) { generateCube(s, out); });
+
+	PyramidShape pyramid;
+	benchPrimitive("pyramid", pyramid, pyramidCounts(pyramid), 200000,
+		[](const PyramidShape &s, auto &out) { generatePyramid(s, out); });
+
+	BucketShape bucket;
+	bucket.topN = 12; bucket.bottomN = 6;
+	benchPrimitive("bucket 12/6", bucket, bucketCounts(bucket), 50000,
+		[](const BucketShape &s, auto &out) { generateBucket(s, out); });
+
+	bucket.topN = 20; bucket.bottomN = 20;
+	benchPrimitive("bucket 20/20", bucket, bucketCounts(bucket), 50000,
+		[](const BucketShape &s, auto &out) { generateBucket(s, out); });
+
+	PaperShape paper;
+	paper.width = 5.0f; paper.height = 4.0f;
+	benchPrimitive("paper 100x100", paper, paperCounts(paper), 50,
+		[](const PaperShape &s, auto &out) { generatePaper(s, out); });
+
+	benchConstexprMeshes();
+}
+
+#endif // !BENCH_PROCEDURAL_H
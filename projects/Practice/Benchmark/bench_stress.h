@@ -0,0 +1,99 @@
+// bench_stress.h
+//
+// Scaling of a whole frame (stress_scene.h) from 10 to a million objects: a mixed scene of
+// cubes, buckets, pyramids, planes and paper sheets from a fixed seed, seen from one side, with
+// the time of every frame phase (update, cull, sort, upload, submit). The table is printed and
+// written as JSON to stress_scaling.json in the working directory, for plotting the curves.
+
+#ifndef BENCH_STRESS_H
+#define BENCH_STRESS_H
+
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include "stress_scene.h"
+#include "bench_utils.h"
+
+struct BenchStressRun {
+	int objects, frames, visible, batches, commands;
+	long long triangles;
+	double generateMilliseconds, worstFrame;
+	size_t uploadBytes;
+	StressFrameTimes mean;
+};
+
+inline BenchStressRun benchStressScene(int count) {
+	BenchStressRun run;
+	StressSceneConfig config = StressSceneConfig::mixed(count, 1);
+
+	BenchTimer timer;
+	World world;
+	StressScene scene;
+	scene.generate(world, config);
+	run.generateMilliseconds = timer.milliseconds();
+
+	// from the middle of the +z side, looking across the scene
+	float extent = config.extent();
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, extent * 0.5f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, extent * 2.0f);
+	const float dt = 1.0f / 60.0f;
+
+	StressFrame frame;
+	frame.run(world, dt, projection * view);
+
+	// a simulated second at most, so the moving objects stay in the scene
+	run.frames = 0;
+	run.worstFrame = 0.0;
+	run.mean = StressFrameTimes();
+	timer.reset();
+	do {
+		frame.run(world, dt, projection * view);
+		run.mean.add(frame.getTimes());
+		run.worstFrame = std::max(run.worstFrame, frame.getTimes().total());
+		run.frames++;
+	} while (run.frames < 60 && (run.frames < 3 || timer.seconds() < 2.0));
+	double scale = 1.0 / run.frames;
+	run.mean.update *= scale; run.mean.cull *= scale; run.mean.sort *= scale;
+	run.mean.upload *= scale; run.mean.submit *= scale;
+
+	run.objects = config.total();
+	run.visible = frame.getVisibleCount();
+	run.batches = (int)frame.getBatches().size();
+	run.commands = (int)frame.getCommands().size();
+	run.triangles = frame.getTriangleCount();
+	run.uploadBytes = frame.getUploadBytes();
+	benchKeep((float)run.triangles);
+
+	printf("  %7d objects %7d visible %3d draws %6.1f M tris | update %8.3f cull %8.3f sort %8.3f upload %7.3f submit %6.3f | frame %8.3f ms (worst %8.3f) | generate %7.0f ms\n",
+		run.objects, run.visible, run.commands, run.triangles / 1e6, run.mean.update, run.mean.cull, run.mean.sort,
+		run.mean.upload, run.mean.submit, run.mean.total(), run.worstFrame, run.generateMilliseconds);
+	return run;
+}
+
+inline void benchStressWriteJson(const char *path, const std::vector<BenchStressRun> &runs) {
+	FILE *file = fopen(path, "w");
+	if (file == NULL) {
+		printf("  cannot write %s\n", path);
+		return;
+	}
+	fprintf(file, "{\n  \"benchmark\": \"stress\",\n  \"seed\": 1,\n  \"threads\": %d,\n  \"runs\": [\n", ThreadPool::instance().threadCount());
+	for (size_t i = 0; i < runs.size(); i++) {
+		const BenchStressRun &run = runs[i];
+		fprintf(file, "    { \"objects\": %d, \"frames\": %d, \"visible\": %d, \"batches\": %d, \"draws\": %d, \"triangles\": %lld, \"upload_bytes\": %llu,\n",
+			run.objects, run.frames, run.visible, run.batches, run.commands, run.triangles, (unsigned long long)run.uploadBytes);
+		fprintf(file, "      \"generate_ms\": %.4f, \"update_ms\": %.4f, \"cull_ms\": %.4f, \"sort_ms\": %.4f, \"upload_ms\": %.4f, \"submit_ms\": %.4f, \"frame_ms\": %.4f, \"worst_frame_ms\": %.4f }%s\n",
+			run.generateMilliseconds, run.mean.update, run.mean.cull, run.mean.sort, run.mean.upload, run.mean.submit,
+			run.mean.total(), run.worstFrame, i + 1 < runs.size() ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+	fclose(file);
+	printf("  written to %s\n", path);
+}
+
+void benchStress() {
+	printf("stress scene frame phases, milliseconds per frame (%d threads)\n", ThreadPool::instance().threadCount());
+	std::vector<BenchStressRun> runs;
+	for (int count = 10; count <= 1000000; count *= 10) runs.push_back(benchStressScene(count));
+	benchStressWriteJson("stress_scaling.json", runs);
+}
+
+#endif // !BENCH_STRESS_H
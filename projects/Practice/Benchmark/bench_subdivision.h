@@ -0,0 +1,78 @@
+// bench_subdivision.h
+//
+// Loop subdivision (subdivision.h) per level: the one-time stencil build and the re-evaluation
+// after a vertex edit (sparse multiply + normals), in output triangles per second, and how far
+// the composed stencils are from refining one level at a time.
+
+#ifndef BENCH_SUBDIVISION_H
+#define BENCH_SUBDIVISION_H
+
+#include <algorithm>
+#include "subdivision.h"
+#include "bench_utils.h"
+
+// largest distance between the composed stencils of surface and applying refine() level by level
+inline float benchSubdivisionStepDifference(const SubdivMesh &base, int levels, const LoopSubdivision &surface) {
+	SubdivMesh mesh = base;
+	std::vector<glm::vec3> positions = base.positions;
+	for (int level = 0; level < levels; level++) {
+		SubdivMesh next;
+		StencilTable step;
+		LoopSubdivision::refine(mesh, next, step);
+		std::vector<glm::vec3> refined;
+		step.apply(positions, refined);
+		positions.swap(refined);
+		mesh = next;
+	}
+	float difference = 0.0f;
+	for (size_t i = 0; i < positions.size(); i++) difference = std::max(difference, glm::length(positions[i] - surface.positions()[i]));
+	return positions.size() == surface.positions().size() ? difference : -1.0f;
+}
+
+inline void benchSubdivisionMesh(const char *name, const SubdivMesh &base, int maxLevel) {
+	printf("  %s (%d vertices, %d triangles)\n", name, base.vertexCount(), base.triangleCount());
+	for (int level = 1; level <= maxLevel; level++) {
+		BenchTimer timer;
+		LoopSubdivision surface(base, level);
+		double buildSeconds = timer.seconds();
+
+		std::vector<glm::vec3> edited = base.positions;
+		int iterations = 0;
+		timer.reset();
+		do {
+			edited[iterations % edited.size()].y += 0.001f;
+			surface.evaluate(edited);
+			benchKeep(surface.positions()[0].x);
+			iterations++;
+		} while (timer.seconds() < 0.2);
+		double evaluateSeconds = timer.seconds() / iterations;
+		surface.evaluate(base.positions);
+		float difference = benchSubdivisionStepDifference(base, level, surface);
+
+		printf("    level %d: %8d tris, %7.1f stencil entries/vertex | build %8.2f ms %7.2f Mtris/s | evaluate %7.3f ms %7.2f Mtris/s | vs level by level %.1e\n",
+			level, surface.triangleCount(), (double)surface.stencilEntries() / surface.vertexCount(),
+			buildSeconds * 1000.0, surface.triangleCount() / buildSeconds / 1e6,
+			evaluateSeconds * 1000.0, surface.triangleCount() / evaluateSeconds / 1e6, difference);
+	}
+}
+
+void benchSubdivision() {
+	printf("loop subdivision (%d threads)\n", ThreadPool::instance().threadCount());
+
+	BucketShape bucket;
+	bucket.topN = 20; bucket.bottomN = 20;
+	VectorSink bucketSoup;
+	generateBucket(bucket, bucketSoup);
+	SubdivMesh bucketBase = SubdivMesh::fromTriangleList(bucketSoup.positions);
+	bucketBase.markFaceGroupCreases(bucketFaceGroups(bucket));
+	benchSubdivisionMesh("bucket 20/20, creased rims", bucketBase, 5);
+
+	PyramidShape pyramid;
+	VectorSink pyramidSoup;
+	generatePyramid(pyramid, pyramidSoup);
+	SubdivMesh pyramidBase = SubdivMesh::fromTriangleList(pyramidSoup.positions);
+	pyramidBase.markFaceGroupCreases(pyramidFaceGroups());
+	benchSubdivisionMesh("pyramid, creased base", pyramidBase, 6);
+}
+
+#endif // !BENCH_SUBDIVISION_H
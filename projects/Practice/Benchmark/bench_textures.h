@@ -0,0 +1,117 @@
+// bench_textures.h
+//
+// The CPU side of asynchronous texture loading (image_decoder.h, mpsc_queue.h): what decoding
+// the demo's images costs the loading thread when it decodes them itself, against only queueing
+// them for decoder threads, and how long the decoders then take to deliver all of them. Also
+// the hand-over queue alone: items from 4 producer threads to one consumer, every one exactly once.
+// The images are read from the Practice project directory (run from Benchmark/ or the repo root).
+
+#ifndef BENCH_TEXTURES_H
+#define BENCH_TEXTURES_H
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "image_decoder.h"
+#include "mpsc_queue.h"
+#include "bench_utils.h"
+
+// the one stb_image implementation of the benchmark program (after image_decoder.h included the declarations)
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+inline bool benchTexturesFind(const char *name, std::string &path) {
+	const char *directories[] = { "", "../Practice/", "projects/Practice/Practice/" };
+	for (int i = 0; i < 3; i++) {
+		FILE *file = fopen((std::string(directories[i]) + name).c_str(), "rb");
+		if (file == NULL) continue;
+		fclose(file);
+		path = std::string(directories[i]) + name;
+		return true;
+	}
+	return false;
+}
+
+inline void benchTexturesDecode(const std::vector<std::string> &files, int threads) {
+	ImageDecoder decoder(threads);
+	BenchTimer timer;
+	for (size_t i = 0; i < files.size(); i++) decoder.request(files[i], (unsigned int)i);
+	double queued = timer.milliseconds();
+	int received = 0, failed = 0;
+	std::vector<char> seen(files.size(), 0);
+	while (received < (int)files.size()) {
+		DecodedImage *image = decoder.poll();
+		if (image == NULL) {
+			std::this_thread::yield();
+			continue;
+		}
+		if (image->pixels == NULL || seen[image->tag]) failed++;
+		seen[image->tag] = 1;
+		received++;
+		decoder.release(image);
+	}
+	printf("  %d decoder thread%s: loading thread busy %7.3f ms, all decoded after %7.1f ms, %d failed\n",
+		threads, threads > 1 ? "s" : " ", queued, timer.milliseconds(), failed);
+}
+
+inline void benchTexturesQueue(int producers, int perProducer) {
+	MpscQueue<long long> queue;
+	BenchTimer timer;
+	std::vector<std::thread> threads;
+	for (int p = 0; p < producers; p++) {
+		threads.push_back(std::thread([&queue, p, perProducer]() {
+			for (int i = 0; i < perProducer; i++) queue.push((long long)p * perProducer + i);
+		}));
+	}
+	long long count = 0, sum = 0, total = (long long)producers * perProducer;
+	long long value;
+	while (count < total) {
+		if (queue.pop(value)) {
+			sum += value;
+			count++;
+		}
+		else std::this_thread::yield();
+	}
+	for (size_t i = 0; i < threads.size(); i++) threads[i].join();
+	bool exact = sum == total * (total - 1) / 2 && queue.empty();
+	printf("  %d producers -> 1 consumer: %lld items in %6.1f ms, %5.1f ns per item, %s\n",
+		producers, total, timer.milliseconds(), timer.milliseconds() * 1e6 / total, exact ? "every item once" : "ITEMS LOST OR REPEATED");
+}
+
+void benchTextures() {
+	const char *names[] = { "awesomeface.bmp", "container.bmp", "byungjin.bmp" };
+	std::vector<std::string> files;
+	for (int i = 0; i < 3; i++) {
+		std::string path;
+		if (benchTexturesFind(names[i], path)) files.push_back(path);
+	}
+	if (files.empty()) {
+		printf("texture decoding: the Practice images were not found, skipped\n");
+	}
+	else {
+		// a material-heavy model: 20 textures per image
+		std::vector<std::string> requests;
+		for (int copy = 0; copy < 20; copy++) requests.insert(requests.end(), files.begin(), files.end());
+		printf("texture decoding, %d files (%d hardware threads)\n", (int)requests.size(), (int)std::thread::hardware_concurrency());
+
+		BenchTimer timer;
+		size_t bytes = 0;
+		for (size_t i = 0; i < requests.size(); i++) {
+			int width, height, channels;
+			unsigned char *pixels = stbi_load(requests[i].c_str(), &width, &height, &channels, 0);
+			if (pixels != NULL) bytes += (size_t)width * height * channels;
+			stbi_image_free(pixels);
+		}
+		printf("  synchronous:       loading thread busy %7.1f ms (%.0f MB decoded)\n", timer.milliseconds(), bytes / 1e6);
+		benchTexturesDecode(requests, 1);
+		benchTexturesDecode(requests, 2);
+		benchTexturesDecode(requests, 4);
+	}
+
+	printf("decoded image hand-over queue\n");
+	benchTexturesQueue(1, 1000000);
+	benchTexturesQueue(4, 250000);
+}
+
+#endif // !BENCH_TEXTURES_H
@@ -0,0 +1,48 @@
+// bench_utils.h
+//
+// Small helpers shared by the headless benchmarks.
+
+#ifndef BENCH_UTILS_H
+#define BENCH_UTILS_H
+
+#include <chrono>
+#include <cstdio>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+class BenchTimer {
+public:
+	BenchTimer() {
+		reset();
+	}
+
+	void reset() {
+		start = std::chrono::high_resolution_clock::now();
+	}
+
+	// elapsed time since construction or the last reset()
+	double seconds() const {
+		return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	double milliseconds() const {
+		return seconds() * 1000.0;
+	}
+
+private:
+	std::chrono::high_resolution_clock::time_point start;
+};
+
+// keeps the optimizer from dropping work whose result is never used
+inline void benchKeep(float value) {
+#ifdef _MSC_VER
+	volatile float sink = value;
+	(void)sink;
+	_ReadWriteBarrier();
+#else
+	asm volatile("" : : "g"(&value) : "memory");	// value must be in memory here
+#endif
+}
+
+#endif // !BENCH_UTILS_H
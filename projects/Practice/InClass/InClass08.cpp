@@ -7,6 +7,8 @@
 #include <cmath>
 #include <shader.h>
 #include <cube.h>
+#include <scene.h>
+#include <scene_renderer.h>
 #include <arcball.h>
 #include <cstdlib>
 #define STB_IMAGE_IMPLEMENTATION
@@ -29,7 +31,13 @@ static unsigned int diffuseMap, specularMap;
 float BACKGRAOUND_COLOR[4] = { 0.5f, 0.5f, 0.5f, 1.0f };
 unsigned int SCR_WIDTH = 1600;
 unsigned int SCR_HEIGHT = 800;
-Cube *cube, *lamp;
+Cube *cube; // mesh asset: owns the cube buffers every entity draws
+
+// scene: entities with transform, mesh and material components (scene.h)
+World scene;
+SceneRenderer *sceneRenderer;
+std::vector<DrawBatch> drawBatches;
+Entity cubeEntity; // follows the model arcball
 
 // glm variables
 glm::mat4 projection, view, model;
@@ -94,7 +102,12 @@ int main()
 	lampShader->setMat4("view", view);
 
 	cube = new Cube();
-	lamp = new Cube();
+	sceneRenderer = new SceneRenderer();
+	MeshHandle cubeMesh = MeshHandle::elements(cube->buffers->VAO, 36);
+	scene.create(Transform(lightPos, lightSize), WorldMatrix(), cubeMesh, Material(lampShader));
+	cubeEntity = scene.create(Transform(), WorldMatrix(), cubeMesh, Material(globalShader));
+	scene.create(Transform(glm::vec3(1.0f, -1.0f, -1.0f)), WorldMatrix(), cubeMesh, Material(globalShader));
+	scene.create(Transform(glm::vec3(-1.5f, 2.0f, 1.0f)), WorldMatrix(), cubeMesh, Material(globalShader));
 
 	while (!glfwWindowShouldClose(window)) {
 		render();
@@ -193,43 +206,22 @@ void render()
 	view = glm::lookAt(camPosition, camTarget, camUp);
 	view = view * camArcBall.createRotationMatrix();
 
-	// lamp
 	lampShader->use();
 	lampShader->setMat4("view", view);
-	model = glm::mat4(1.0f);
-	model = glm::translate(model, lightPos);
-	model = glm::scale(model, lightSize);
-	lampShader->setMat4("model", model);
-	lamp->draw(lampShader);
-
-	// cubes
 	globalShader->use();
 	globalShader->setMat4("view", view);
+
 	// texture
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, diffuseMap);
 	glActiveTexture(GL_TEXTURE1);
 	glBindTexture(GL_TEXTURE_2D, specularMap);
 
-	// cube1
-	model = glm::mat4(1.0f);
-	model = model * modelArcBall.createRotationMatrix();
-	globalShader->setMat4("model", model);
-	cube->draw(globalShader);
-
-	// cube2
-	model = glm::mat4(1.0f);
-	model = glm::translate(model, glm::vec3(1.0f, -1.0f, -1.0f));
-	globalShader->setMat4("model", model);
-	cube->draw(globalShader);
-
-	// cube3
-	model = glm::mat4(1.0f);
-	model = glm::translate(model, glm::vec3(-1.5f, 2.0f, 1.0f));
-	globalShader->setMat4("model", model);
-	cube->draw(globalShader);
-	
-	
+	// lamp and cubes
+	scene.get<Transform>(cubeEntity)->rotation = glm::quat_cast(modelArcBall.createRotationMatrix());
+	updateWorldMatrices(scene);
+	gatherDrawBatches(scene, drawBatches);
+	sceneRenderer->submit(drawBatches);
 
 	glfwSwapBuffers(window);
 }
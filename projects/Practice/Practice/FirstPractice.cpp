@@ -7,12 +7,24 @@
 #include <cmath>
 #include <shader.h>
 #include <cube.h>
+#include "static_primitive.h"
 #include <arcball.h>
 #include <cstdlib>
+#include <algorithm>
 #include "pyramid.h"
 #include "bucket.h"
+#include "bucket_lod.h"
+#include "subdivided_mesh.h"
 #include "fighter_plane.h"
+#include "fighter_fleet.h"
+#include "boids.h"
+#include "particles.h"
+#include "particle_renderer.h"
+#include "scene.h"
+#include "scene_renderer.h"
+#include "scene_index.h"
 #include "paper2.h"
+#include "texture_loader.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
@@ -24,18 +36,35 @@ void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
 void cursor_position_callback(GLFWwindow *window, double x, double y);
 void render();
 void loadTexture();
+void setWingPoses(float time);
 
 // Global Variables
 GLFWwindow *window = NULL;
 Shader *globalShader = NULL;
 Shader *lampShader = NULL;
+Shader *instancedShader = NULL;
+Shader *impostorShader = NULL;
+Shader *particleShader = NULL;
 unsigned int SCR_WIDTH = 1600;
 unsigned int SCR_HEIGHT = 800;
 float BACKGRAOUND_COLOR[4] = { 0.5f, 0.5f, 0.5f, 1.0f };
+// mesh assets: they own the GL buffers the scene entities draw
 Pyramid *pyramid;
-Cube *lamp;
+StaticPrimitive< StaticCube<> > lamp;	// compile-time cube (constexpr_mesh.h), uploaded on first use
 Bucket *bucket;
 Fighter_plane *fighter_plane;
+FighterFleet *fleet;
+Cube *streetCube;	// the buildings and crates of the street
+OccluderMesh streetOccluder;
+
+// scene: entities with transform, mesh and material components (scene.h)
+World scene;
+SceneRenderer *sceneRenderer;
+std::vector<DrawBatch> drawBatches;
+SceneIndex sceneIndex;
+OcclusionBuffer occlusion;
+Entity pyramidEntity, lampEntity, bucketEntity, planeEntity;
+std::vector<Entity> streetEntities;
 Paper2 *paper;
 
 // glm variables
@@ -52,6 +81,8 @@ bool arcballCamRot = true;
 
 // for texture
 static unsigned int texture; // Array of texture ids.
+TextureLoader *textureLoader;
+const size_t TEXTURE_UPLOAD_BUDGET = 8 << 20; // bytes of decoded textures uploaded per frame
 
 // for lighting
 glm::vec3 lightSize(0.2f, 0.2f, 0.2f);
@@ -64,6 +95,31 @@ float specularPower = 32.0f;
 // for fighter plane location
 float plane_x, plane_y, plane_z;
 
+// for the instanced fleet (FLEET_SIDE x FLEET_SIDE planes), hidden until key 4
+const int FLEET_SIDE = 100;
+bool showFleet = false;
+bool flapWings = false;
+
+// the fleet as a flock (G toggles): agent i is fleet->planes[i]
+Flock flock;
+bool flocking = false;
+double flockTime = 0.0;
+
+// a row of buckets running away from the camera (key 6), each drawn at the level its screen size needs
+const int LOD_ROW = 24;
+BucketLOD *lodBucket;
+bool showLodRow = false;
+std::vector<int> lodLevels;	// buckets drawn per level in the last frame, finest first
+
+// the bucket Loop-subdivided twice (key 7): 48 sides on the top rim, past Bucket::MAX
+SubdividedMesh *smoothBucket;
+bool showSmoothBucket = false;
+
+// what the fighter plane's gun fires (space)
+ParticlePool bullets(100000);
+ParticleRenderer *particleRenderer;
+double particleTime = 0.0;
+
 int main()
 {
 	window = glAllInit();
@@ -71,6 +127,10 @@ int main()
 	// shader loading and compile (by calling the constructor)
 	globalShader = new Shader("globalShader.vs", "globalShader.fs");
 	lampShader = new Shader("lamp.vs", "lamp.fs");
+	// the fleet: instanced.vs plus the part poses of the baked plane (M flaps the wings)
+	instancedShader = new Shader("composite.vs", "globalShader.fs");
+	impostorShader = new Shader("impostor.vs", "impostor.fs");
+	particleShader = new Shader("particle.vs", "particle.fs");
 
 	// projection and view matrix and lightening
 	globalShader->use();
@@ -86,6 +146,23 @@ int main()
 	globalShader->setFloat("specularStrength", specularStrength);
 	globalShader->setFloat("specularPower", specularPower);
 
+	// instanced shader: same lighting as the global shader
+	instancedShader->use();
+	instancedShader->setMat4("projection", projection);
+	instancedShader->setVec3("lightColor", lightColor);
+	instancedShader->setVec3("lightPos", lightPos);
+	instancedShader->setVec3("viewPos", camPosition);
+	instancedShader->setFloat("ambientStrength", ambientStrength);
+	instancedShader->setFloat("specularStrength", specularStrength);
+	instancedShader->setFloat("specularPower", specularPower);
+
+	// impostor shader: the lighting is baked into the impostor views
+	impostorShader->use();
+	impostorShader->setMat4("projection", projection);
+
+	particleShader->use();
+	particleShader->setMat4("projection", projection);
+
 	// lamp shader
 	lampShader->use();
 	lampShader->setMat4("projection", projection);
@@ -96,10 +173,62 @@ int main()
 
 	// create a new pyramid
 	pyramid = new Pyramid(1.0f, 5.0f);
-	lamp = new Cube();
 	bucket = new Bucket(12, 6, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, false, false);
+	lodBucket = new BucketLOD(20, 20, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, false, false);
+	smoothBucket = SubdividedMesh::fromBucket(bucket->getShape(), 2);
 	fighter_plane = new Fighter_plane();
+	fleet = new FighterFleet();
+	for (int i = 0; i < FLEET_SIDE * FLEET_SIDE; i++) {
+		float x = (i % FLEET_SIDE - FLEET_SIDE * 0.5f) * 0.5f;
+		float y = (i / FLEET_SIDE - FLEET_SIDE * 0.5f) * 0.5f;
+		glm::mat4 plane_model = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, -20.0f));
+		plane_model = glm::scale(plane_model, glm::vec3(0.05f, 0.05f, 0.05f));
+		fleet->planes.push_back(InstanceData(plane_model, glm::vec4((float)(i % 7) / 6.0f, 0.5f, 1.0f, 1.0f)));
+		flock.add(glm::vec3(x, y, -20.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+	}
+	// flock at the fleet's scale, around the scene objects at the origin
+	flock.neighbourRadius = 1.0f;
+	flock.separationRadius = 0.3f;
+	flock.minSpeed = 1.0f;
+	flock.maxSpeed = 3.0f;
+	flock.bounds = AABB(glm::vec3(-30.0f, -30.0f, -40.0f), glm::vec3(30.0f, 30.0f, 0.0f));
+	flock.obstacles.push_back(BoundingSphere(glm::vec3(0.0f), 3.0f));
+	// far planes of the fleet as impostors; the bake leaves its own view / projection on the shader
+	fleet->bakeImpostor(globalShader);
+	globalShader->use();
+	globalShader->setMat4("projection", projection);
+	globalShader->setMat4("view", view);
+	globalShader->setVec3("viewPos", camPosition);
 	paper = new Paper2(5.0f, 4.0f);
+	particleRenderer = new ParticleRenderer();
+	bullets.gravity = glm::vec3(0.0f, -2.0f, 0.0f);
+
+	// scene entities; the pyramid, bucket and fighter plane start hidden (keys 1, 2, 3)
+	sceneRenderer = new SceneRenderer();
+	lampEntity = scene.create(Transform(lightPos, lightSize), WorldMatrix(), MeshHandle::elements(lamp.getVAO(), StaticCube<>::Data::indexCount),
+		Material(lampShader), LocalBounds(lamp.getBounds()));
+	pyramidEntity = scene.create(Transform(), WorldMatrix(), MeshHandle::arrays(pyramid->getVAO(), pyramid->getTriangleNum() * 3),
+		Material(globalShader), LocalBounds(pyramid->getBounds()), Hidden());
+	bucketEntity = scene.create(Transform(), WorldMatrix(), MeshHandle::arrays(bucket->getVAO(), bucket->getTriangleNum() * 3),
+		Material(globalShader), LocalBounds(bucket->getBounds()), Hidden());
+	planeEntity = scene.create(Transform(glm::vec3(0.0f), glm::vec3(0.3f)), WorldMatrix(),
+		MeshHandle::elements(fighter_plane->getBaked()->getVAO(), fighter_plane->getBaked()->getTriangleNum() * 3),
+		Material(globalShader), LocalBounds(fighter_plane->getBaked()->getBounds()), Hidden());
+
+	// a street behind the scene (key 5): a wall of two buildings, the occluders, and a yard of
+	// crates behind it, of which only the ones past the wall's ends are drawn
+	streetCube = new Cube();
+	streetOccluder = OccluderMesh::box(streetCube->getBounds());
+	MeshHandle streetMesh = MeshHandle::elements(streetCube->buffers->VAO, 36);
+	for (int i = 0; i < 2; i++) {
+		streetEntities.push_back(scene.create(Transform(glm::vec3(i == 0 ? -2.0f : 2.0f, 0.0f, -4.0f), glm::vec3(4.0f, 5.0f, 1.0f)), WorldMatrix(),
+			streetMesh, Material(globalShader), LocalBounds(streetCube->getBounds()), Occluder(&streetOccluder)));
+	}
+	for (int i = 0; i < 96; i++) {
+		glm::vec3 position(-5.5f + (i % 12), -2.0f, -7.0f - (i / 12));
+		streetEntities.push_back(scene.create(Transform(position, glm::vec3(0.4f)), WorldMatrix(), streetMesh, Material(globalShader),
+			LocalBounds(streetCube->getBounds())));
+	}
 
 
 	while (!glfwWindowShouldClose(window)) {
@@ -154,81 +283,89 @@ GLFWwindow *glAllInit()
 
 void loadTexture() {
 
-	// Create texture ids.
-	glGenTextures(1, &texture);
+	// decoded in the background: a grey placeholder until render() uploads the image
+	textureLoader = new TextureLoader();
+	texture = textureLoader->request("awesomeface.bmp", GL_CLAMP);
 
 	// All upcomming GL_TEXTURE_2D operations now on "texture" object
 	glBindTexture(GL_TEXTURE_2D, texture);
-
-	// Set texture parameters for wrapping.
-	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
-
-	// Set texture parameters for filtering.
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-	int width, height, nrChannels;
-	unsigned char *image = stbi_load("awesomeface.bmp", &width, &height, &nrChannels, 0);
-	if (!image) {
-		printf("texture %s loading error ... \n", "container.bmp");
-	}
-	else printf("texture %s loaded\n", "container.bmp");
-
-	GLenum format;
-	if (nrChannels == 1) format = GL_RED;
-	else if (nrChannels == 3) format = GL_RGB;
-	else if (nrChannels == 4) format = GL_RGBA;
-
-	glBindTexture(GL_TEXTURE_2D, texture);
-	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, image);
-	glGenerateMipmap(GL_TEXTURE_2D);
 }
 
 void render()
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	drawStats().reset();
+	textureLoader->update(TEXTURE_UPLOAD_BUDGET);
 
 	// arcball view
 	view = glm::lookAt(camPosition, camTarget, camUp);
 	view = view * camArcBall.createRotationMatrix();
 
-	// pyramid
 	globalShader->use();
 	globalShader->setMat4("view", view);
-	model = modelArcBall.createRotationMatrix();
-	globalShader->setMat4("model", model);
-	// pyramid->draw(globalShader);
-
-	// lamp
 	lampShader->use();
 	lampShader->setMat4("view", view);
-	model = glm::mat4(1.0f);
-	model = glm::translate(model, lightPos);
-	model = glm::scale(model, lightSize);
-	lampShader->setMat4("model", model);
-	lamp->draw(lampShader);
-
-	// bucket
-	/*
-	globalShader->use();
-	globalShader->setMat4("view", view);
-	model = modelArcBall.createRotationMatrix();
-	globalShader->setMat4("model", model);
-	bucket->draw(globalShader);
-	*/
 
-	// fighter plane
-	/*
-	globalShader->use();
-	globalShader->setMat4("view", view);
-	model = modelArcBall.createRotationMatrix();
-	model = glm::rotate(model, glm::radians(90.f), glm::vec3(1.0f, 0.0f, 0.0f));
-	model = glm::scale(model, glm::vec3(0.3f, 0.3f, 0.3f));
-	globalShader->setMat4("model", model);
-	fighter_plane->draw(globalShader, model);
-	*/
+	// scene entities: the pyramid, bucket and fighter plane follow the model arcball
+	glm::quat modelRotation = glm::quat_cast(modelArcBall.createRotationMatrix());
+	scene.get<Transform>(pyramidEntity)->rotation = modelRotation;
+	scene.get<Transform>(bucketEntity)->rotation = modelRotation;
+	scene.get<Transform>(planeEntity)->rotation = modelRotation * glm::angleAxis(glm::radians(90.f), glm::vec3(1.0f, 0.0f, 0.0f));
+	updateWorldMatrices(scene);
+	sceneIndex.update(scene);
+	// entities with an Occluder component hide the ones behind them
+	rasterizeOccluders(scene, occlusion, projection * view);
+	gatherDrawBatches(scene, drawBatches, occlusion, projection * view);
+	sceneRenderer->submit(drawBatches);
+
+	// fighter fleet, shown by key 4 (instanced, parts baked: 1 draw call for all planes; B toggles the baking),
+	// planes farther than fleet->impostor_distance as impostors (1 more call); G lets them flock
+	if (showFleet && flocking) {
+		double now = glfwGetTime();
+		flock.step((float)std::min(now - flockTime, 0.05));
+		flockTime = now;
+		// the plane's nose is its -y axis: turned to +z, the direction a flock agent flies
+		flock.writeInstances(&fleet->planes[0], glm::rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f)), 0.05f);
+	}
+	if (showFleet) {
+		glm::mat4 fleetView = view * modelArcBall.createRotationMatrix();
+		glm::vec3 fleetCamera = glm::vec3(glm::inverse(fleetView)[3]);
+		instancedShader->use();
+		instancedShader->setMat4("view", fleetView);
+		// part poses index the baked plane's part ids: the separate parts have none
+		bool flap = flapWings && fleet->baked_parts;
+		StaticComposite::setAnimateParts(instancedShader, flap);
+		if (flap) setWingPoses((float)glfwGetTime());
+		impostorShader->use();
+		impostorShader->setMat4("view", fleetView);
+		impostorShader->setVec3("viewPos", fleetCamera);
+		fleet->draw(instancedShader, impostorShader, projection * fleetView, fleetCamera);
+	}
+
+	// LOD row: one level per bucket, from its projected size
+	if (showLodRow) {
+		lodLevels.assign(lodBucket->getLevelCount(), 0);
+		for (int i = 0; i < LOD_ROW; i++) {
+			glm::mat4 lod_model = glm::translate(glm::mat4(1.0f), glm::vec3(-3.0f, -1.5f, -2.0f - 4.0f * i));
+			lod_model = glm::scale(lod_model, glm::vec3(0.3f));
+			lodLevels[lodBucket->draw(globalShader, lod_model, view, projection, (float)SCR_HEIGHT)]++;
+		}
+	}
+
+	// subdivided bucket, next to the plain one; it turns with the model arcball
+	if (showSmoothBucket) {
+		globalShader->use();
+		globalShader->setMat4("model", glm::translate(glm::mat4(1.0f), glm::vec3(3.0f, 0.0f, 0.0f)) * modelArcBall.createRotationMatrix());
+		smoothBucket->draw(globalShader);
+	}
+
+	// bullets: one point sprite draw
+	double now = glfwGetTime();
+	bullets.update((float)std::min(now - particleTime, 0.05));
+	particleTime = now;
+	particleShader->use();
+	particleShader->setMat4("view", view);
+	particleRenderer->draw(particleShader, bullets, glm::vec4(1.0f, 0.9f, 0.4f, 1.0f), glm::vec4(1.0f, 0.2f, 0.0f, 0.0f), 0.05f);
 
 	// paper
 	globalShader->use();
@@ -239,6 +376,23 @@ void render()
 	glfwSwapBuffers(window);
 }
 
+// the fleet's wings (part ids 1 and 2) swing about the plane's nose axis where they join the body
+void setWingPoses(float time)
+{
+	Fighter_plane *plane = fleet->getPrototype();
+	glm::vec3 root((plane->shape.bodyStart + plane->shape.bodyEnd) * 0.5f, 0.0f, 0.0f);
+	float angle = 0.3f * std::sin(time * 6.0f);
+	glm::mat4 poses[StaticComposite::MAX_POSED_PARTS];
+	for (int part = 0; part < StaticComposite::MAX_POSED_PARTS; part++) poses[part] = glm::mat4(1.0f);
+	for (int part = 1; part <= 2; part++) {
+		glm::vec3 hinge = part == 1 ? root : -root;
+		poses[part] = glm::translate(glm::mat4(1.0f), hinge);
+		poses[part] = glm::rotate(poses[part], part == 1 ? angle : -angle, glm::vec3(0.0f, 1.0f, 0.0f));
+		poses[part] = glm::translate(poses[part], -hinge);
+	}
+	StaticComposite::setPartPoses(instancedShader, poses, StaticComposite::MAX_POSED_PARTS);
+}
+
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
 // ---------------------------------------------------------------------------------------------
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
@@ -277,6 +431,92 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 		else if (key == GLFW_KEY_F) {
 			paper->forceModeSwitch();
 		}
+		else if (key == GLFW_KEY_1 || key == GLFW_KEY_2 || key == GLFW_KEY_3) {
+			Entity entity = key == GLFW_KEY_1 ? pyramidEntity : (key == GLFW_KEY_2 ? bucketEntity : planeEntity);
+			if (scene.has<Hidden>(entity)) scene.remove<Hidden>(entity);
+			else scene.add(entity, Hidden());
+		}
+		else if (key == GLFW_KEY_4) {
+			showFleet = !showFleet;
+			std::cout << "FLEET: " << (showFleet ? "shown" : "hidden") << ", " << fleet->planes.size() << " planes" << std::endl;
+		}
+		else if (key == GLFW_KEY_5) {
+			bool shown = scene.has<Hidden>(streetEntities[0]);
+			for (size_t i = 0; i < streetEntities.size(); i++) {
+				if (shown) scene.remove<Hidden>(streetEntities[i]);
+				else scene.add(streetEntities[i], Hidden());
+			}
+			std::cout << "STREET: " << (shown ? "shown" : "hidden") << std::endl;
+		}
+		else if (key == GLFW_KEY_6) {
+			showLodRow = !showLodRow;
+			std::cout << "LOD: row of " << LOD_ROW << " buckets " << (showLodRow ? "shown" : "hidden") << std::endl;
+		}
+		else if (key == GLFW_KEY_7) {
+			showSmoothBucket = !showSmoothBucket;
+			std::cout << "SUBDIVISION: bucket " << (showSmoothBucket ? "shown" : "hidden") << ", " << smoothBucket->getTriangleNum()
+				<< " triangles" << std::endl;
+		}
+		else if (key == GLFW_KEY_M) {
+			flapWings = !flapWings;
+			std::cout << "FLEET: wings " << (flapWings ? "flapping" : "still") << std::endl;
+		}
+		else if (key == GLFW_KEY_B) {
+			fleet->baked_parts = !fleet->baked_parts;
+			std::cout << "FLEET: " << (fleet->baked_parts ? "baked parts" : "separate parts") << std::endl;
+		}
+		else if (key == GLFW_KEY_SPACE) {
+			// a burst from the fighter plane's gun (key 3 shows the plane)
+			const glm::mat4 &plane = scene.get<WorldMatrix>(planeEntity)->value;
+			ParticleSpawn spawn;
+			spawn.position = glm::vec3(plane * glm::vec4(fighter_plane->getMuzzlePosition(), 1.0f));
+			spawn.velocity = glm::normalize(glm::vec3(plane * glm::vec4(fighter_plane->getMuzzleDirection(), 0.0f))) * 8.0f;
+			spawn.spread = 0.03f;
+			spawn.lifetime = 2.0f;
+			spawn.lifetimeJitter = 0.5f;
+			bullets.emit(64, spawn);
+		}
+		else if (key == GLFW_KEY_G) {
+			// the flock is the fleet: flocking shows it
+			flocking = !flocking;
+			if (flocking) showFleet = true;
+			flockTime = glfwGetTime();
+			std::cout << "FLOCK: " << (flocking ? "on" : "off") << std::endl;
+		}
+		else if (key == GLFW_KEY_P) {
+			// pick along the view direction
+			glm::mat4 camera = glm::inverse(view);
+			float distance;
+			Entity picked = sceneIndex.raycast(glm::vec3(camera[3]), -glm::vec3(camera[2]), distance);
+			const char *name = picked == lampEntity ? "lamp" : picked == pyramidEntity ? "pyramid" :
+				picked == bucketEntity ? "bucket" : picked == planeEntity ? "fighter plane" :
+				std::find(streetEntities.begin(), streetEntities.end(), picked) != streetEntities.end() ? "street" : "nothing";
+			std::cout << "PICK: " << name;
+			if (picked != Entity()) std::cout << " at " << distance;
+			std::cout << std::endl;
+		}
+		else if (key == GLFW_KEY_D) {
+			std::cout << "DRAW: " << drawStats().drawCalls << " draw calls, " << drawStats().instances << " objects, "
+				<< drawStats().triangles << " triangles in the last frame" << std::endl;
+			std::cout << "CULL: " << drawStats().culled << " of " << drawStats().cullTested << " culled in "
+				<< drawStats().cullMilliseconds << " ms" << std::endl;
+			std::cout << "OCCLUSION: " << drawStats().occluded << " of " << drawStats().occlusionTested << " hidden in "
+				<< drawStats().occlusionMilliseconds << " ms" << std::endl;
+			const ParticleStats &particles = bullets.getStats();
+			std::cout << "PARTICLES: " << particles.live << " live, integrate " << particles.integrateMilliseconds << " ms, compact "
+				<< particles.compactMilliseconds << " ms, write " << particles.writeMilliseconds << " ms" << std::endl;
+			std::cout << "TEXTURES: " << textureLoader->getUploadedCount() << " uploaded, " << textureLoader->pendingCount()
+				<< " pending, last upload " << textureLoader->getUpdateMilliseconds() << " ms" << std::endl;
+			if (showLodRow) {
+				std::cout << "LOD: buckets per level (finest first):";
+				for (size_t i = 0; i < lodLevels.size(); i++) std::cout << " " << lodLevels[i];
+				std::cout << std::endl;
+			}
+			if (showFleet && flocking) {
+				std::cout << "FLOCK: " << flock.size() << " agents, sort " << flock.getSortMilliseconds() << " ms, update "
+					<< flock.getUpdateMilliseconds() << " ms" << std::endl;
+			}
+		}
 	}
 }
 
@@ -0,0 +1,75 @@
+// bucket_lod.h
+//
+// A Bucket with a chain of tessellation levels (see lod.h). Every level is an ordinary Bucket,
+// so levels are shared through GeometryCache like any other bucket; each draw picks one level
+// from the size of the bucket's bounding sphere on screen.
+//
+// Vertex shader: the location (0: position attrib (vec3), 1: normal (vec3), 2: color (vec4), 3: texture (vec2))
+
+#ifndef BUCKET_LOD_H
+#define BUCKET_LOD_H
+
+#include <vector>
+#include "bucket.h"
+#include "lod.h"
+
+class BucketLOD {
+public:
+	float pixels_per_edge = 8.0f; // one rim edge per this many pixels of projected circumference
+
+	BucketLOD(int top_n, int bottom_n, float top_radius, float bottom_radius, float top_ratio, float bottom_ratio, float height,
+		bool colorMode, bool flatNormals, int max_levels = 4) {
+		BucketShape shape;
+		shape.topN = top_n; shape.bottomN = bottom_n;
+		shape.topRadius = top_radius; shape.bottomRadius = bottom_radius;
+		shape.topRatio = top_ratio; shape.bottomRatio = bottom_ratio;
+		shape.height = height;
+		shape.flatNormals = flatNormals;
+
+		chain = bucketLodChain(shape, max_levels);
+		for (int i = 0; i < (int)chain.size(); i++) {
+			levels.push_back(new Bucket(chain[i].topN, chain[i].bottomN, top_radius, bottom_radius, top_ratio, bottom_ratio, height,
+				colorMode, flatNormals));
+		}
+		bounding_radius = bucketBoundingRadius(shape);
+	}
+
+	~BucketLOD() {
+		for (int i = 0; i < (int)levels.size(); i++) delete levels[i];
+	}
+
+	// level for a bucket placed by model, seen through view/projection on a viewport_height pixel high viewport
+	int selectLevel(const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection, float viewport_height) {
+		glm::vec3 center = glm::vec3(model[3]);
+		float scale = glm::max(glm::length(glm::vec3(model[0])), glm::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+		float radius = projectedSphereRadius(center, bounding_radius * scale, view, projection, viewport_height);
+		return selectBucketLevel(chain, radius, pixels_per_edge);
+	}
+
+	// sets "model" and draws the selected level; returns the level drawn
+	int draw(Shader *shader, const glm::mat4 &model, const glm::mat4 &view, const glm::mat4 &projection, float viewport_height) {
+		int level = selectLevel(model, view, projection, viewport_height);
+		shader->use();
+		shader->setMat4("model", model);
+		levels[level]->draw(shader);
+		return level;
+	}
+
+	int getLevelCount() {
+		return (int)levels.size();
+	}
+
+	Bucket *getLevel(int level) {
+		return levels[level];
+	}
+
+private:
+	std::vector<BucketShape> chain;
+	std::vector<Bucket*> levels;
+	float bounding_radius;
+
+	BucketLOD(const BucketLOD &);
+	BucketLOD &operator=(const BucketLOD &);
+};
+
+#endif // !BUCKET_LOD_H
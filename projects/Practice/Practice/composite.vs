@@ -0,0 +1,36 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec4 aColor;
+layout (location = 3) in vec2 aTexCoord;
+layout (location = 4) in mat4 aInstanceModel; // locations 4-7
+layout (location = 8) in vec4 aInstanceColor;
+layout (location = 9) in uint aPartId;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec4 toColor;
+out vec2 toTexCoord;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// optional part animation of a baked composite (static_composite.h); parts from
+// MAX_POSED_PARTS up (a part id is up to 255) always draw in the rest pose
+const int MAX_POSED_PARTS = 8;
+uniform bool animateParts;
+uniform mat4 partPose[MAX_POSED_PARTS];
+
+void main()
+{
+	mat4 instanceModel = aInstanceModel * model;
+	if (animateParts && int(aPartId) < MAX_POSED_PARTS) instanceModel = instanceModel * partPose[aPartId];
+	FragPos = vec3(instanceModel * vec4(aPos,1.0));
+	// rotation and uniform scale only: no per-vertex inverse (the fragment shader normalizes)
+	Normal = mat3(instanceModel) * aNormal;
+    toColor = aColor * aInstanceColor;
+    toTexCoord = vec2(aTexCoord.x, aTexCoord.y);
+
+	gl_Position = projection * view * vec4(FragPos,1.0);
+}
@@ -0,0 +1,125 @@
+// fighter_fleet.h
+//
+// Many Fighter_planes drawn with instancing: one draw call for the whole fleet, whatever its size
+// (the parts are baked into one mesh, see Fighter_plane::getBaked; 4 calls with baked_parts off). Fill `planes` with one model matrix and colour per plane, then draw():
+//
+//     FighterFleet *fleet = new FighterFleet();
+//     fleet->planes.push_back(InstanceData(model, glm::vec4(1.0f)));
+//     fleet->draw(instancedShader);
+//
+// draw(shader, projection * view) first drops the planes outside the view frustum (frustum.h).
+// After bakeImpostor(), draw(shader, impostorShader, projection * view, cameraPosition) draws the
+// planes farther than impostor_distance as impostors (impostor.h): one quad each, one more call.
+//
+// Vertex shader: instanced.vs (0-3: the mesh attributes, 4-7: instance model (mat4), 8: instance color (vec4))
+// or composite.vs, which also poses the baked plane's parts (StaticComposite::setPartPoses)
+// Fragment shader: globalShader.fs
+// Impostors: impostor.vs / impostor.fs
+
+#ifndef FIGHTER_FLEET_H
+#define FIGHTER_FLEET_H
+
+#include <vector>
+#include "shader.h"
+#include "fighter_plane.h"
+#include "instance_buffer.h"
+#include "frustum.h"
+#include "impostor.h"
+
+class FighterFleet {
+public:
+	std::vector<InstanceData> planes;
+	bool baked_parts = true;
+	float impostor_distance = 40.0f;
+
+	FighterFleet() {
+		this->prototype = new Fighter_plane();
+		this->instances = new InstanceBuffer();
+		this->impostor_instances = new InstanceBuffer();
+		this->impostor = NULL;
+	}
+
+	~FighterFleet() {
+		delete prototype; delete instances; delete impostor_instances; delete impostor;
+	}
+
+	// renders the impostor views of one plane with a non-instanced shader (globalShader) and its
+	// current lighting; sets the shader's view / projection / viewPos (see impostor.h)
+	void bakeImpostor(Shader *shader) {
+		if (impostor == NULL) impostor = new ImpostorAtlas();
+		StaticComposite *baked = prototype->getBaked();
+		impostor->bake(shader, prototype->getBoundingSphere(), [baked](Shader *bakeShader) {
+			bakeShader->setMat4("model", glm::mat4(1.0f));
+			baked->draw(bakeShader);
+		});
+	}
+
+	// uploads `planes` (one buffer per frame for all parts) and draws them
+	void draw(Shader *shader) {
+		instances->upload(planes.empty() ? NULL : &planes[0], (int)planes.size());
+		drawInstances(shader);
+	}
+
+	// only the planes whose bounding sphere touches the view frustum
+	void draw(Shader *shader, const glm::mat4 &viewProjection) {
+		cullPlanes(viewProjection);
+		instances->upload(visible_planes.empty() ? NULL : &visible_planes[0], (int)visible_planes.size());
+		drawInstances(shader);
+	}
+
+	// as above, the visible planes beyond impostor_distance from the camera as impostors (once baked)
+	void draw(Shader *shader, Shader *impostorShader, const glm::mat4 &viewProjection, const glm::vec3 &cameraPosition) {
+		if (impostor == NULL || !impostor->isBaked()) {
+			draw(shader, viewProjection);
+			return;
+		}
+		cullPlanes(viewProjection);
+		near_planes.clear();
+		far_planes.clear();
+		splitByDistance(visible_planes.empty() ? NULL : &visible_planes[0], (int)visible_planes.size(), prototype->getBoundingSphere().center,
+			cameraPosition, impostor_distance, near_planes, far_planes);
+		instances->upload(near_planes.empty() ? NULL : &near_planes[0], (int)near_planes.size());
+		drawInstances(shader);
+		impostor_instances->upload(far_planes.empty() ? NULL : &far_planes[0], (int)far_planes.size());
+		impostor->draw(impostorShader, *impostor_instances);
+	}
+
+	// the plane whose part meshes and offsets every instance uses
+	Fighter_plane *getPrototype() {
+		return prototype;
+	}
+
+private:
+	Fighter_plane *prototype;
+	InstanceBuffer *instances;
+	FrustumCuller culler;
+	std::vector<InstanceData> visible_planes, near_planes, far_planes;
+	InstanceBuffer *impostor_instances;
+	ImpostorAtlas *impostor;
+
+	// visible_planes = the planes whose bounding sphere touches the view frustum
+	void cullPlanes(const glm::mat4 &viewProjection) {
+		BoundingSphere local = prototype->getBoundingSphere();
+		int count = (int)planes.size();
+		culler.resize(count);
+		parallelFor(0, count, 4096, [&](int begin, int end) {
+			for (int i = begin; i < end; i++) culler.set(i, local.transformed(planes[i].model));
+		});
+		culler.cull(viewProjection);
+
+		visible_planes.clear();
+		for (int i = 0; i < count; i++) {
+			if (culler.isVisible(i)) visible_planes.push_back(planes[i]);
+		}
+	}
+
+	void drawInstances(Shader *shader) {
+		if (baked_parts) prototype->getBaked()->drawInstanced(shader, *instances);
+		else prototype->drawInstanced(shader, *instances);
+	}
+
+	FighterFleet(const FighterFleet &);
+	FighterFleet &operator=(const FighterFleet &);
+};
+
+#endif // !FIGHTER_FLEET_H
@@ -15,63 +15,130 @@
 #include <glm/gtc/type_ptr.hpp>
 #include "shader.h"
 #include "bucket.h"
+#include "transform_hierarchy.h"
+#include "instance_buffer.h"
+#include "bounds.h"
+#include "mesh_merge.h"
+#include "static_composite.h"
+#include "fighter_shape.h"
 
 class Fighter_plane {
 public:
 	Bucket *left_wing, *right_wing, *body, *gun;
-	float wing_length, wing_start, wing_end;
-	float body_length, body_start, body_end;
-	float gun_length, gun_start, gun_end;
-	float wing_radian;
+	FighterShape shape;	// part sizes and placements (fighter_shape.h), shared with headless code
 	glm::mat4 model;
 
 	Fighter_plane() {
-		this->wing_length = 3.0f; this->wing_start = 1.0f; this->wing_end = 0.3f;
-		this->body_length = 3.0f; this->body_start = 2.0f; this->body_end = 1.0f;
-		this->gun_length = 0.5f; this->gun_start = 0.1f; this->gun_end = 0.1f;
+		this->left_wing = makePart(shape.wing());
+		this->right_wing = makePart(shape.wing());
+		this->body = makePart(shape.body());
+		this->gun = makePart(shape.gun());
 
-		this->left_wing = new Bucket(12, 3, wing_start, wing_end, 0.3, 0.1, wing_length, false, false);
-		this->right_wing = new Bucket(12, 3, wing_start, wing_end, 0.3, 0.1, wing_length, false, false);
-		this->body = new Bucket(16, 8, body_start, body_end, 0.3, 0.1, body_length, false, false);
-		this->gun = new Bucket(20, 20, gun_start, gun_end, 1.0f, 1.0f, gun_length, false, false);
+		this->baked = NULL;
+		buildHierarchy();
+	}
 
-		this->wing_radian = atan(body_length / (body_start - body_end));
+	~Fighter_plane() {
+		delete left_wing; delete right_wing; delete body; delete gun;
+		delete baked;
 	}
 
 	void draw(Shader *shader, glm::mat4 model) {
-		// body
-		glm::mat4 body_model = glm::mat4(model);
-		shader->setMat4("model", body_model);
-		glBindVertexArray(body->getVAO());
-		glDrawArrays(GL_TRIANGLES, 0, body->getTriangleNum() * 3);
-		glBindVertexArray(0);
+		// only the root moves between draws; the part offsets are set once in the constructor
+		parts.setLocal(root, model);
+		parts.update();
 
-		// left wing
-		glm::mat4 left_wing_model = glm::mat4(model);
-		left_wing_model = glm::translate(left_wing_model, glm::vec3((body_start+body_end)*0.5f, 0.0f, 0.0f));
-		left_wing_model = glm::rotate(left_wing_model, wing_radian, glm::vec3(0.0f, 0.0f, 1.0f));
-		shader->setMat4("model", left_wing_model);
-		glBindVertexArray(left_wing->getVAO());
-		glDrawArrays(GL_TRIANGLES, 0, left_wing->getTriangleNum() * 3);
-		glBindVertexArray(0);
-		
-		// right wing
-		glm::mat4 right_wing_model = glm::mat4(model);
-		right_wing_model = glm::translate(right_wing_model, glm::vec3(-(body_start + body_end)*0.5f, 0.0f, 0.0f));
-		right_wing_model = glm::rotate(right_wing_model, -wing_radian, glm::vec3(0.0f, 0.0f, 1.0f));
-		shader->setMat4("model", right_wing_model);
-		glBindVertexArray(right_wing->getVAO());
-		glDrawArrays(GL_TRIANGLES, 0, right_wing->getTriangleNum() * 3);
-		glBindVertexArray(0);
+		drawPart(shader, body, body_node);
+		drawPart(shader, left_wing, left_wing_node);
+		drawPart(shader, right_wing, right_wing_node);
+		drawPart(shader, gun, gun_node);
+	}
+
+	// every plane of a fleet in one instanced draw per part (shader: instanced.vs);
+	// each instance supplies the plane's model matrix and colour
+	void drawInstanced(Shader *shader, const InstanceBuffer &instances) {
+		shader->use();
+		drawPartInstanced(shader, body, body_node, instances);
+		drawPartInstanced(shader, left_wing, left_wing_node, instances);
+		drawPartInstanced(shader, right_wing, right_wing_node, instances);
+		drawPartInstanced(shader, gun, gun_node, instances);
+	}
+
+	// The parts never move relative to each other: pre-transformed into one mesh they draw with
+	// one call. Part ids: 0 body, 1 left wing, 2 right wing, 3 gun.
+	MergedMesh mergeParts() {
+		return shape.merge();
+	}
+
+	// the merged parts on the GPU, made on first use
+	StaticComposite *getBaked() {
+		if (baked == NULL) baked = new StaticComposite(mergeParts());
+		return baked;
+	}
+
+	// same picture as draw(), one draw call
+	void drawBaked(Shader *shader, glm::mat4 model) {
+		shader->use();
+		shader->setMat4("model", model);
+		getBaked()->draw(shader);
+	}
+
+	// model-space sphere around all parts
+	BoundingSphere getBoundingSphere() {
+		BoundingSphere sphere = body->getBoundingSphere().transformed(parts.getLocal(body_node));
+		sphere.extend(left_wing->getBoundingSphere().transformed(parts.getLocal(left_wing_node)));
+		sphere.extend(right_wing->getBoundingSphere().transformed(parts.getLocal(right_wing_node)));
+		sphere.extend(gun->getBoundingSphere().transformed(parts.getLocal(gun_node)));
+		return sphere;
+	}
+
+	// model-space tip of the gun, and the direction it fires in (the nose, -y)
+	glm::vec3 getMuzzlePosition() {
+		return glm::vec3(parts.getLocal(gun_node) * glm::vec4(0.0f, -shape.gunLength * 0.5f, 0.0f, 1.0f));
+	}
+
+	glm::vec3 getMuzzleDirection() {
+		return glm::normalize(glm::vec3(parts.getLocal(gun_node) * glm::vec4(0.0f, -1.0f, 0.0f, 0.0f)));
+	}
+
+	// part transforms relative to the plane's model matrix
+	TransformHierarchy &getHierarchy() {
+		return parts;
+	}
 
-		// gun
-		glm::mat4 gun_model = glm::mat4(model);
-		gun_model = glm::translate(gun_model, glm::vec3(0.0f, -body_length*0.5f, 0.0f));
-		shader->setMat4("model", gun_model);
-		glBindVertexArray(gun->getVAO());
-		glDrawArrays(GL_TRIANGLES, 0, gun->getTriangleNum() * 3);
+private:
+	TransformHierarchy parts;
+	StaticComposite *baked;
+	int root, body_node, left_wing_node, right_wing_node, gun_node;
+
+	Fighter_plane(const Fighter_plane &);
+	Fighter_plane &operator=(const Fighter_plane &);
+
+	void buildHierarchy() {
+		glm::mat4 identity = glm::mat4(1.0f);
+		root = parts.addNode(TransformHierarchy::NO_PARENT, identity);
+		body_node = parts.addNode(root, identity);
+		left_wing_node = parts.addNode(root, shape.leftWingOffset());
+		right_wing_node = parts.addNode(root, shape.rightWingOffset());
+		gun_node = parts.addNode(root, shape.gunOffset());
+	}
+
+	static Bucket *makePart(const BucketShape &part) {
+		return new Bucket(part.topN, part.bottomN, part.topRadius, part.bottomRadius, part.topRatio, part.bottomRatio, part.height,
+			false, part.flatNormals);
+	}
+
+	void drawPart(Shader *shader, Bucket *part, int node) {
+		shader->setMat4("model", parts.getWorld(node));
+		glBindVertexArray(part->getVAO());
+		glDrawArrays(GL_TRIANGLES, 0, part->getTriangleNum() * 3);
 		glBindVertexArray(0);
+		drawStats().add(1, part->getTriangleNum());
 	}
 
+	void drawPartInstanced(Shader *shader, Bucket *part, int node, const InstanceBuffer &instances) {
+		shader->setMat4("model", parts.getLocal(node));
+		instances.drawArrays(part->getVAO(), part->getTriangleNum() * 3);
+	}
 };
 #endif // !FIGHTER_PLANE_H
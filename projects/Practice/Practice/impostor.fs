@@ -0,0 +1,26 @@
+#version 330 core
+in vec2 frameLocal[3];
+flat in vec2 frameCell[3];
+flat in vec3 frameWeights;
+in vec4 toColor;
+out vec4 FragColor;
+
+uniform sampler2D atlas;
+uniform int gridSize;
+
+// nothing outside the frame: the neighbouring views must not bleed in
+vec4 sampleFrame(vec2 local, vec2 cell)
+{
+	if (any(lessThan(local, vec2(0.0))) || any(greaterThan(local, vec2(1.0)))) return vec4(0.0);
+	return texture(atlas, (cell + local) / float(gridSize));
+}
+
+void main()
+{
+	vec4 color = sampleFrame(frameLocal[0], frameCell[0]) * frameWeights.x +
+	             sampleFrame(frameLocal[1], frameCell[1]) * frameWeights.y +
+	             sampleFrame(frameLocal[2], frameCell[2]) * frameWeights.z;
+	if (color.a < 0.5) discard;
+	// the baked views are lit already
+	FragColor = vec4(color.rgb / color.a, 1.0) * toColor;
+}
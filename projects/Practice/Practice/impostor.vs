@@ -0,0 +1,77 @@
+#version 330 core
+layout (location = 0) in vec2 aCorner;
+layout (location = 4) in mat4 aInstanceModel; // locations 4-7
+layout (location = 8) in vec4 aInstanceColor;
+
+// per view: where the fragment falls inside the view's frame ([0, 1] on the frame), and the frame
+out vec2 frameLocal[3];
+flat out vec2 frameCell[3];
+flat out vec3 frameWeights;
+out vec4 toColor;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 viewPos;
+// the atlas (impostor.h): gridSize x gridSize views of the sphere boundsCenter / boundsRadius (model space)
+uniform int gridSize;
+uniform vec3 boundsCenter;
+uniform float boundsRadius;
+
+// octahedral mapping, as octahedral.h
+vec2 octahedralEncode(vec3 d)
+{
+	d /= abs(d.x) + abs(d.y) + abs(d.z);
+	vec2 p = d.xz;
+	if (d.y < 0.0) p = (1.0 - abs(d.zx)) * vec2(d.x >= 0.0 ? 1.0 : -1.0, d.z >= 0.0 ? 1.0 : -1.0);
+	return p * 0.5 + 0.5;
+}
+
+vec3 octahedralDecode(vec2 uv)
+{
+	vec2 p = uv * 2.0 - 1.0;
+	vec3 d = vec3(p.x, 1.0 - abs(p.x) - abs(p.y), p.y);
+	if (d.y < 0.0) d.xz = (1.0 - abs(p.yx)) * vec2(p.x >= 0.0 ? 1.0 : -1.0, p.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(d);
+}
+
+void main()
+{
+	// rotation and uniform scale only
+	mat3 rotationScale = mat3(aInstanceModel);
+	float scale = length(rotationScale[0]);
+	mat3 toModel = transpose(rotationScale) / (scale * scale);
+	vec3 center = vec3(aInstanceModel * vec4(boundsCenter, 1.0));
+
+	// camera-facing quad around the bounding sphere
+	vec3 cameraRight = vec3(view[0][0], view[1][0], view[2][0]);
+	vec3 cameraUp = vec3(view[0][1], view[1][1], view[2][1]);
+	vec3 worldPos = center + (cameraRight * aCorner.x + cameraUp * aCorner.y) * (boundsRadius * scale);
+
+	// the three baked views around the direction to the camera
+	vec3 direction = normalize(toModel * (viewPos - center));
+	float last = float(gridSize - 1);
+	vec2 grid = octahedralEncode(direction) * last;
+	vec2 base = clamp(floor(grid), vec2(0.0), vec2(last - 1.0));
+	vec2 f = grid - base;
+	if (f.x + f.y <= 1.0) {
+		frameCell[0] = base; frameCell[1] = base + vec2(1.0, 0.0); frameCell[2] = base + vec2(0.0, 1.0);
+		frameWeights = vec3(1.0 - f.x - f.y, f.x, f.y);
+	}
+	else {
+		frameCell[0] = base + vec2(1.0); frameCell[1] = base + vec2(0.0, 1.0); frameCell[2] = base + vec2(1.0, 0.0);
+		frameWeights = vec3(f.x + f.y - 1.0, 1.0 - f.x, 1.0 - f.y);
+	}
+
+	// each view sees the quad corner where it projects onto that view's image plane
+	vec3 local = toModel * (worldPos - center);
+	for (int k = 0; k < 3; k++) {
+		vec3 frameDirection = octahedralDecode(frameCell[k] / last);
+		vec3 hint = abs(frameDirection.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+		vec3 right = normalize(cross(-frameDirection, hint));
+		vec3 up = cross(right, -frameDirection);
+		frameLocal[k] = vec2(dot(local, right), dot(local, up)) / (2.0 * boundsRadius) + 0.5;
+	}
+
+	toColor = aInstanceColor;
+	gl_Position = projection * view * vec4(worldPos, 1.0);
+}
@@ -0,0 +1,29 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec4 aColor;
+layout (location = 3) in vec2 aTexCoord;
+layout (location = 4) in mat4 aInstanceModel; // locations 4-7
+layout (location = 8) in vec4 aInstanceColor;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec4 toColor;
+out vec2 toTexCoord;
+
+// the part (mesh) offset inside one instance; the instance matrix is applied after it
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+	mat4 instanceModel = aInstanceModel * model;
+	FragPos = vec3(instanceModel * vec4(aPos,1.0));
+	// rotation and uniform scale only: no per-vertex inverse (the fragment shader normalizes)
+	Normal = mat3(instanceModel) * aNormal;
+    toColor = aColor * aInstanceColor;
+    toTexCoord = vec2(aTexCoord.x, aTexCoord.y);
+
+	gl_Position = projection * view * vec4(FragPos,1.0);
+}
@@ -15,6 +15,8 @@
 #include <glm/gtc/type_ptr.hpp>
 #include "shader.h"
 #include "MyUtils.h"
+#include "procedural.h"
+#include "normals.h"
 
 class Paper {
 public:
@@ -110,64 +112,13 @@ private:
 	}
 	void updateBuffers() {
 		// -----------------------------
-		// vertices
-		for (int w = 0; w < WIDTH; w++) {
-			int w_base = w * HEIGHT * 4 * 3 * 3;
-			for (int h = 0; h < HEIGHT; h++) {
-				int h_base = h * 4 * 3 * 3;
-				// bottom triangle
-				vertices[w_base + h_base] = w * box_width - width * 0.5f;
-				vertices[w_base + h_base + 1] = h * box_height - height * 0.5f;
-				vertices[w_base + h_base + 2] = 0.0f;
-				vertices[w_base + h_base + 3] = (w + 1.0f) * box_width - width * 0.5f;
-				vertices[w_base + h_base + 4] = h * box_height - height * 0.5f;
-				vertices[w_base + h_base + 5] = 0.0f;
-				vertices[w_base + h_base + 6] = (w + 0.5f) * box_width - width * 0.5f;
-				vertices[w_base + h_base + 7] = (h + 0.5f) * box_height - height * 0.5f;
-				vertices[w_base + h_base + 8] = 0.0f;
-				// right triangle
-				vertices[w_base + h_base + 9] = (w + 1.0f) * box_width - width * 0.5f;
-				vertices[w_base + h_base + 10] = h * box_height - height * 0.5f;
-				vertices[w_base + h_base + 11] = 0.0f;
-				vertices[w_base + h_base + 12] = (w + 1.0f) * box_width - width * 0.5f;
-				vertices[w_base + h_base + 13] = (h + 1.0f) * box_height - height * 0.5f;
-				vertices[w_base + h_base + 14] = 0.0f;
-				vertices[w_base + h_base + 15] = (w + 0.5f) * box_width - width * 0.5f;
-				vertices[w_base + h_base + 16] = (h + 0.5f) * box_height - height * 0.5f;
-				vertices[w_base + h_base + 17] = 0.0f;
-				// top triangle
-				vertices[w_base + h_base + 18] = (w + 1.0f) * box_width - width * 0.5f;
-				vertices[w_base + h_base + 19] = (h + 1.0f) * box_height - height * 0.5f;
-				vertices[w_base + h_base + 20] = 0.0f;
-				vertices[w_base + h_base + 21] = w * box_width - width * 0.5f;
-				vertices[w_base + h_base + 22] = (h + 1.0f) * box_height - height * 0.5f;
-				vertices[w_base + h_base + 23] = 0.0f;
-				vertices[w_base + h_base + 24] = (w + 0.5f) * box_width - width * 0.5f;
-				vertices[w_base + h_base + 25] = (h + 0.5f) * box_height - height * 0.5f;
-				vertices[w_base + h_base + 26] = 0.0f;
-				// left triangle
-				vertices[w_base + h_base + 27] = w * box_width - width * 0.5f;
-				vertices[w_base + h_base + 28] = (h + 1.0f) * box_height - height * 0.5f;
-				vertices[w_base + h_base + 29] = 0.0f;
-				vertices[w_base + h_base + 30] = w * box_width - width * 0.5f;
-				vertices[w_base + h_base + 31] = h * box_height - height * 0.5f;
-				vertices[w_base + h_base + 32] = 0.0f;
-				vertices[w_base + h_base + 33] = (w + 0.5f) * box_width - width * 0.5f;
-				vertices[w_base + h_base + 34] = (h + 0.5f) * box_height - height * 0.5f;
-				vertices[w_base + h_base + 35] = 0.0f;
-			}
-		}
-		// -----------------------------
-		// normals
-		if (flatNormals) {
-			for (int i = 0; i < NUM_OF_TOTAL_TRIANGLES; i++) {
-				float* normal = get_normal(vertices[i * 9], vertices[i * 9 + 1], vertices[i * 9 + 2], vertices[i * 9 + 3], vertices[i * 9 + 4], vertices[i * 9 + 5], vertices[i * 9 + 6], vertices[i * 9 + 7], vertices[i * 9 + 8]);
-				normals[i * 9] = normal[0]; normals[i * 9 + 1] = normal[1]; normals[i * 9 + 2] = normal[2];
-				normals[i * 9 + 3] = normal[0]; normals[i * 9 + 4] = normal[1]; normals[i * 9 + 5] = normal[2];
-				normals[i * 9 + 6] = normal[0]; normals[i * 9 + 7] = normal[1]; normals[i * 9 + 8] = normal[2];
-			}
-		}
-		
+		// vertices, normals and texture coordinates (procedural.h)
+		PaperShape shape;
+		shape.width = width; shape.height = height;
+		shape.cols = WIDTH; shape.rows = HEIGHT;
+		ArraySink mesh(vertices, flatNormals ? normals : NULL, texcoords, NUM_OF_TOTAL_TRIANGLES * 3);
+		generatePaper(shape, mesh);
+
 		// -----------------------------
 		// colors
 		if (colorMode) {
@@ -201,13 +152,6 @@ private:
 			}
 		}
 
-		// -----------------------------
-		// textures
-		for (int i = 0; i < NUM_OF_TOTAL_TRIANGLES * 3; i++) {
-			texcoords[i * 2] = (vertices[i * 3] + width * 0.5f) / width;
-			texcoords[i * 2 + 1] = -(vertices[i * 3 + 1] + height * 0.5f) / height + 1.0f;
-		}
-
 		glBindVertexArray(VAO);
 
 		glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
@@ -258,14 +202,10 @@ private:
 				}
 			}
 		}
-		// normals
+		// normals: one per triangle, facing away from (0, 0, -10) like before (normals.h)
 		if (flatNormals) {
-			for (int i = 0; i < NUM_OF_TOTAL_TRIANGLES; i++) {
-				float* normal = get_normal(vertices[i * 9], vertices[i * 9 + 1], vertices[i * 9 + 2], vertices[i * 9 + 3], vertices[i * 9 + 4], vertices[i * 9 + 5], vertices[i * 9 + 6], vertices[i * 9 + 7], vertices[i * 9 + 8]);
-				normals[i * 9] = normal[0]; normals[i * 9 + 1] = normal[1]; normals[i * 9 + 2] = normal[2];
-				normals[i * 9 + 3] = normal[0]; normals[i * 9 + 4] = normal[1]; normals[i * 9 + 5] = normal[2];
-				normals[i * 9 + 6] = normal[0]; normals[i * 9 + 7] = normal[1]; normals[i * 9 + 8] = normal[2];
-			}
+			glm::vec3 away(0.0f, 0.0f, -10.0f);
+			computeFaceNormals(vertices, NUM_OF_TOTAL_TRIANGLES, normals, 3, &away);
 		}
 
 		glBindVertexArray(VAO);
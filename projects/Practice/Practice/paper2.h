@@ -15,6 +15,9 @@
 #include <glm/gtc/type_ptr.hpp>
 #include "shader.h"
 #include "MyUtils.h"
+#include "procedural.h"
+#include "normals.h"
+#include "bounds.h"
 
 class Paper2 {
 public:
@@ -72,6 +75,15 @@ public:
 		*/
 	}
 
+	// model-space bounds of the sheet as last uploaded (follows the deformation)
+	AABB getBounds() {
+		return bounds;
+	}
+
+	BoundingSphere getBoundingSphere() {
+		return BoundingSphere::fromAABB(bounds);
+	}
+
 	void forceModeSwitch() {
 		forceMode = !forceMode;
 		pastTime = glfwGetTime();
@@ -100,6 +112,8 @@ private:
 	float currentTime;
 	float pastTime;
 	float status[HEIGHT][WIDTH][4] = { 0.0f }; // [x, y, z, force]
+	// bounds of vertices
+	AABB bounds;
 
 	void initCoord() {
 		// center coordinates
@@ -143,6 +157,14 @@ private:
 			}
 		}
 	}
+	// four triangles per box around its center, from the current corner and center coordinates
+	template <typename Sink>
+	void generateSheet(Sink &out) {
+		generateFanGrid(WIDTH, HEIGHT, width, height,
+			[this](int h, int w) { return glm::vec3(corner_coord[h][w][0], corner_coord[h][w][1], corner_coord[h][w][2]); },
+			[this](int h, int w) { return glm::vec3(center_coord[h][w][0], center_coord[h][w][1], center_coord[h][w][2]); },
+			out);
+	}
 	void createBuffers() {
 
 		glGenVertexArrays(1, &VAO);
@@ -174,65 +196,10 @@ private:
 	}
 	void initBuffers() {
 		// -----------------------------
-		// vertices
-		for (int w = 0; w < WIDTH; w++) {
-			int w_base = w * HEIGHT * 4 * 3 * 3;
-			for (int h = 0; h < HEIGHT; h++) {
-				int h_base = h * 4 * 3 * 3;
-				// bottom triangle
-				vertices[w_base + h_base] = corner_coord[h][w][0];
-				vertices[w_base + h_base + 1] = corner_coord[h][w][1];
-				vertices[w_base + h_base + 2] = corner_coord[h][w][2];
-				vertices[w_base + h_base + 3] = corner_coord[h][w + 1][0];
-				vertices[w_base + h_base + 4] = corner_coord[h][w + 1][1];
-				vertices[w_base + h_base + 5] = corner_coord[h][w + 1][2];
-				vertices[w_base + h_base + 6] = center_coord[h][w][0];
-				vertices[w_base + h_base + 7] = center_coord[h][w][1];
-				vertices[w_base + h_base + 8] = center_coord[h][w][2];
-				//std::cout << (vertices[w_base + h_base + 6] + width * 0.5f) / box_width << std::endl;
-				//std::cout << vertices[w_base + h_base] << std::endl;
-				// right triangle
-				vertices[w_base + h_base + 9] = corner_coord[h][w + 1][0];;
-				vertices[w_base + h_base + 10] = corner_coord[h][w + 1][1];;
-				vertices[w_base + h_base + 11] = corner_coord[h][w + 1][2];;
-				vertices[w_base + h_base + 12] = corner_coord[h + 1][w + 1][0];
-				vertices[w_base + h_base + 13] = corner_coord[h + 1][w + 1][1];
-				vertices[w_base + h_base + 14] = corner_coord[h + 1][w + 1][2];
-				vertices[w_base + h_base + 15] = center_coord[h][w][0];
-				vertices[w_base + h_base + 16] = center_coord[h][w][1];
-				vertices[w_base + h_base + 17] = center_coord[h][w][2];
-				// top triangle
-				vertices[w_base + h_base + 18] = corner_coord[h + 1][w + 1][0];
-				vertices[w_base + h_base + 19] = corner_coord[h + 1][w + 1][1];
-				vertices[w_base + h_base + 20] = corner_coord[h + 1][w + 1][2];
-				vertices[w_base + h_base + 21] = corner_coord[h + 1][w][0];
-				vertices[w_base + h_base + 22] = corner_coord[h + 1][w][1];
-				vertices[w_base + h_base + 23] = corner_coord[h + 1][w][2];
-				vertices[w_base + h_base + 24] = center_coord[h][w][0];
-				vertices[w_base + h_base + 25] = center_coord[h][w][1];
-				vertices[w_base + h_base + 26] = center_coord[h][w][2];
-				// left triangle
-				vertices[w_base + h_base + 27] = corner_coord[h + 1][w][0];
-				vertices[w_base + h_base + 28] = corner_coord[h + 1][w][1];
-				vertices[w_base + h_base + 29] = corner_coord[h + 1][w][2];
-				vertices[w_base + h_base + 30] = corner_coord[h][w][0];
-				vertices[w_base + h_base + 31] = corner_coord[h][w][1];
-				vertices[w_base + h_base + 32] = corner_coord[h][w][2];
-				vertices[w_base + h_base + 33] = center_coord[h][w][0];
-				vertices[w_base + h_base + 34] = center_coord[h][w][1];
-				vertices[w_base + h_base + 35] = center_coord[h][w][2];
-			}
-		}
-		// -----------------------------
-		// normals
-		if (flatNormals) {
-			for (int i = 0; i < NUM_OF_TOTAL_TRIANGLES; i++) {
-				float* normal = get_normal(vertices[i * 9], vertices[i * 9 + 1], vertices[i * 9 + 2], vertices[i * 9 + 3], vertices[i * 9 + 4], vertices[i * 9 + 5], vertices[i * 9 + 6], vertices[i * 9 + 7], vertices[i * 9 + 8]);
-				normals[i * 9] = normal[0]; normals[i * 9 + 1] = normal[1]; normals[i * 9 + 2] = normal[2];
-				normals[i * 9 + 3] = normal[0]; normals[i * 9 + 4] = normal[1]; normals[i * 9 + 5] = normal[2];
-				normals[i * 9 + 6] = normal[0]; normals[i * 9 + 7] = normal[1]; normals[i * 9 + 8] = normal[2];
-			}
-		}
+		// vertices, normals and texture coordinates (procedural.h)
+		ArraySink mesh(vertices, flatNormals ? normals : NULL, texcoords, NUM_OF_TOTAL_TRIANGLES * 3);
+		generateSheet(mesh);
+		bounds = AABB::fromPoints(vertices, NUM_OF_TOTAL_TRIANGLES * 3);
 
 		// -----------------------------
 		// colors
@@ -267,13 +234,6 @@ private:
 			}
 		}
 
-		// -----------------------------
-		// textures
-		for (int i = 0; i < NUM_OF_TOTAL_TRIANGLES * 3; i++) {
-			texcoords[i * 2] = (vertices[i * 3] + width * 0.5f) / width;
-			texcoords[i * 2 + 1] = -(vertices[i * 3 + 1] + height * 0.5f) / height + 1.0f;
-		}
-
 		glBindVertexArray(VAO);
 
 		glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
@@ -304,63 +264,15 @@ private:
 	}
 	void updateBuffers() {
 		// -----------------------------
-		// vertices
-		for (int w = 0; w < WIDTH; w++) {
-			int w_base = w * HEIGHT * 4 * 3 * 3;
-			for (int h = 0; h < HEIGHT; h++) {
-				int h_base = h * 4 * 3 * 3;
-				// bottom triangle
-				vertices[w_base + h_base] = corner_coord[h][w][0];
-				vertices[w_base + h_base + 1] = corner_coord[h][w][1];
-				vertices[w_base + h_base + 2] = corner_coord[h][w][2];
-				vertices[w_base + h_base + 3] = corner_coord[h][w + 1][0];
-				vertices[w_base + h_base + 4] = corner_coord[h][w + 1][1];
-				vertices[w_base + h_base + 5] = corner_coord[h][w + 1][2];
-				vertices[w_base + h_base + 6] = center_coord[h][w][0];
-				vertices[w_base + h_base + 7] = center_coord[h][w][1];
-				vertices[w_base + h_base + 8] = center_coord[h][w][2];
-				// right triangle
-				vertices[w_base + h_base + 9] = corner_coord[h][w + 1][0];;
-				vertices[w_base + h_base + 10] = corner_coord[h][w + 1][1];;
-				vertices[w_base + h_base + 11] = corner_coord[h][w + 1][2];;
-				vertices[w_base + h_base + 12] = corner_coord[h + 1][w + 1][0];
-				vertices[w_base + h_base + 13] = corner_coord[h + 1][w + 1][1];
-				vertices[w_base + h_base + 14] = corner_coord[h + 1][w + 1][2];
-				vertices[w_base + h_base + 15] = center_coord[h][w][0];
-				vertices[w_base + h_base + 16] = center_coord[h][w][1];
-				vertices[w_base + h_base + 17] = center_coord[h][w][2];
-				// top triangle
-				vertices[w_base + h_base + 18] = corner_coord[h + 1][w + 1][0];
-				vertices[w_base + h_base + 19] = corner_coord[h + 1][w + 1][1];
-				vertices[w_base + h_base + 20] = corner_coord[h + 1][w + 1][2];
-				vertices[w_base + h_base + 21] = corner_coord[h + 1][w][0];
-				vertices[w_base + h_base + 22] = corner_coord[h + 1][w][1];
-				vertices[w_base + h_base + 23] = corner_coord[h + 1][w][2];
-				vertices[w_base + h_base + 24] = center_coord[h][w][0];
-				vertices[w_base + h_base + 25] = center_coord[h][w][1];
-				vertices[w_base + h_base + 26] = center_coord[h][w][2];
-				// left triangle
-				vertices[w_base + h_base + 27] = corner_coord[h + 1][w][0];
-				vertices[w_base + h_base + 28] = corner_coord[h + 1][w][1];
-				vertices[w_base + h_base + 29] = corner_coord[h + 1][w][2];
-				vertices[w_base + h_base + 30] = corner_coord[h][w][0];
-				vertices[w_base + h_base + 31] = corner_coord[h][w][1];
-				vertices[w_base + h_base + 32] = corner_coord[h][w][2];
-				vertices[w_base + h_base + 33] = center_coord[h][w][0];
-				vertices[w_base + h_base + 34] = center_coord[h][w][1];
-				vertices[w_base + h_base + 35] = center_coord[h][w][2];
-			}
-		}
-		// -----------------------------
-		// normals
+		// vertices, then their normals in one batch (normals.h), facing away from (0, 0, -10)
+		// like paper.h's; texture coordinates stay as they were at initBuffers
+		ArraySink mesh(vertices, NULL, NULL, NUM_OF_TOTAL_TRIANGLES * 3);
+		generateSheet(mesh);
 		if (flatNormals) {
-			for (int i = 0; i < NUM_OF_TOTAL_TRIANGLES; i++) {
-				float* normal = get_normal(vertices[i * 9], vertices[i * 9 + 1], vertices[i * 9 + 2], vertices[i * 9 + 3], vertices[i * 9 + 4], vertices[i * 9 + 5], vertices[i * 9 + 6], vertices[i * 9 + 7], vertices[i * 9 + 8]);
-				normals[i * 9] = normal[0]; normals[i * 9 + 1] = normal[1]; normals[i * 9 + 2] = normal[2];
-				normals[i * 9 + 3] = normal[0]; normals[i * 9 + 4] = normal[1]; normals[i * 9 + 5] = normal[2];
-				normals[i * 9 + 6] = normal[0]; normals[i * 9 + 7] = normal[1]; normals[i * 9 + 8] = normal[2];
-			}
+			glm::vec3 away(0.0f, 0.0f, -10.0f);
+			computeFaceNormals(vertices, NUM_OF_TOTAL_TRIANGLES, normals, 3, &away);
 		}
+		bounds = AABB::fromPoints(vertices, NUM_OF_TOTAL_TRIANGLES * 3);
 
 		glBindVertexArray(VAO);
 
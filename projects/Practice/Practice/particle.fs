@@ -0,0 +1,16 @@
+#version 330 core
+in float life;
+out vec4 FragColor;
+
+uniform vec4 startColor;
+uniform vec4 endColor;
+
+void main()
+{
+	// round sprites, softer towards the rim
+	vec2 offset = gl_PointCoord * 2.0 - 1.0;
+	float radius = dot(offset, offset);
+	if (radius > 1.0) discard;
+	vec4 color = mix(startColor, endColor, clamp(life, 0.0, 1.0));
+	FragColor = vec4(color.rgb, color.a * (1.0 - radius * radius));
+}
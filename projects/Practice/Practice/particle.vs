@@ -0,0 +1,19 @@
+#version 330 core
+layout (location = 0) in vec4 aParticle; // xyz: position, w: age / lifetime
+
+out float life;
+
+uniform mat4 view;
+uniform mat4 projection;
+// world-space diameter of a sprite, and the viewport height in pixels to turn it into pixels
+uniform float pointSize;
+uniform float viewportHeight;
+
+void main()
+{
+	vec4 eye = view * vec4(aParticle.xyz, 1.0);
+	gl_Position = projection * eye;
+	// projection[1][1] = cot(fovy / 2)
+	gl_PointSize = max(1.0, pointSize * projection[1][1] * 0.5 * viewportHeight / max(-eye.z, 0.001));
+	life = aParticle.w;
+}
@@ -0,0 +1,120 @@
+// subdivided_mesh.h
+//
+// Draws a Loop-subdivided primitive (see subdivision.h). The stencils are built once; after
+// editing base vertices, update() re-evaluates them and re-uploads the vertex buffer.
+//
+//     SubdividedMesh *smooth = SubdividedMesh::fromBucket(bucket->getShape(), 3);
+//     smooth->draw(shader);
+//
+// Vertex shader: the location (0: position attrib (vec3), 1: normal (vec3), 2: color (vec4), 3: texture (vec2))
+
+#ifndef SUBDIVIDED_MESH_H
+#define SUBDIVIDED_MESH_H
+
+#include <vector>
+#include "shader.h"
+#include "procedural.h"
+#include "subdivision.h"
+#include "vertex_layout.h"
+#include "draw_stats.h"
+
+class SubdividedMesh {
+public:
+	glm::vec4 color = glm::vec4(1.0f);
+
+	SubdividedMesh(const SubdivMesh &base, int levels) : surface(base, levels) {
+		base_positions = base.positions;
+		createBuffers();
+		update();
+	}
+
+	// bucket with sharp rims
+	static SubdividedMesh *fromBucket(const BucketShape &shape, int levels) {
+		VectorSink soup;
+		generateBucket(shape, soup);
+		SubdivMesh base = SubdivMesh::fromTriangleList(soup.positions);
+		base.markFaceGroupCreases(bucketFaceGroups(shape));
+		return new SubdividedMesh(base, levels);
+	}
+
+	// pyramid with a sharp base
+	static SubdividedMesh *fromPyramid(const PyramidShape &shape, int levels) {
+		VectorSink soup;
+		generatePyramid(shape, soup);
+		SubdivMesh base = SubdivMesh::fromTriangleList(soup.positions);
+		base.markFaceGroupCreases(pyramidFaceGroups());
+		return new SubdividedMesh(base, levels);
+	}
+
+	~SubdividedMesh() {
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &VBO);
+		glDeleteBuffers(1, &EBO);
+	}
+
+	// base (control) vertices; edit them and call update()
+	std::vector<glm::vec3> &getBasePositions() {
+		return base_positions;
+	}
+
+	void update() {
+		surface.evaluate(base_positions);
+
+		const std::vector<glm::vec3> &positions = surface.positions();
+		const std::vector<glm::vec3> &normals = surface.normals();
+		parallelFor(0, (int)vertices.size(), 4096, [&](int begin, int end) {
+			for (int i = begin; i < end; i++)
+				Layout::write(vertices[i], VertexInput(positions[i], normals[i], color, glm::vec2(0.0f)));
+		});
+
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Layout::Vertex), &vertices[0]);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void draw(Shader *shader) {
+		shader->use();
+		glBindVertexArray(VAO);
+		glDrawElements(GL_TRIANGLES, surface.triangleCount() * 3, GL_UNSIGNED_INT, 0);
+		glBindVertexArray(0);
+		drawStats().add(1, surface.triangleCount());
+	}
+
+	int getTriangleNum() {
+		return surface.triangleCount();
+	}
+
+private:
+	typedef PackedVertex Layout;
+
+	LoopSubdivision surface;
+	std::vector<glm::vec3> base_positions;
+	std::vector<Layout::Vertex> vertices;
+	unsigned int VAO, VBO, EBO;
+
+	SubdividedMesh(const SubdividedMesh &);
+	SubdividedMesh &operator=(const SubdividedMesh &);
+
+	void createBuffers() {
+		vertices.resize(surface.vertexCount());
+
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+		glGenBuffers(1, &EBO);
+
+		glBindVertexArray(VAO);
+
+		// positions and normals change on update(), the topology does not
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Layout::Vertex), 0, GL_DYNAMIC_DRAW);
+		Layout::setup();
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, surface.indices().size() * sizeof(unsigned int), &surface.indices()[0], GL_STATIC_DRAW);
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+};
+
+#endif // !SUBDIVIDED_MESH_H
@@ -10,17 +10,10 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-using namespace std;
+#include "bounds.h"
+#include "mesh_import.h"
 
-struct Vertex
-{
-    // Position
-    glm::vec3 Position;
-    // Normal
-    glm::vec3 Normal;
-    // TexCoords
-    glm::vec2 TexCoords;
-};
+using namespace std;
 
 struct Texture
 {
@@ -33,9 +26,13 @@ class Mesh
 {
 public:
     /*  Mesh Data  */
+    // CPU copies of what was uploaded: kept by the vector and MeshData constructors, but empty for
+    // meshes uploaded from a mapped mesh cache (Model loads those on a cache hit). The GPU buffers
+    // and bounds are the same either way.
     vector<Vertex> vertices;
     vector<GLuint> indices;
     vector<Texture> textures;
+    AABB bounds;
     
     /*  Functions  */
     // Constructor
@@ -45,8 +42,34 @@ public:
         this->indices = indices;
         this->textures = textures;
         
+        // Model-space bounds, for culling
+        for ( GLuint i = 0; i < this->vertices.size( ); i++ )
+        {
+            this->bounds.extend( this->vertices[i].Position );
+        }
+        
         // Now that we have all the required data, set the vertex buffers and its attribute pointers.
-        this->setupMesh( );
+        this->setupMesh( this->vertices.data( ), this->vertices.size( ), this->indices.data( ), this->indices.size( ) );
+    }
+    
+    // Takes over the arrays converted on a worker thread (mesh_import.h), leaving data empty; the GL part runs here
+    Mesh( MeshData &data, const vector<Texture> &textures )
+    {
+        this->vertices.swap( data.vertices );
+        this->indices.swap( data.indices );
+        this->textures = textures;
+        this->bounds = data.bounds;
+        
+        this->setupMesh( this->vertices.data( ), this->vertices.size( ), this->indices.data( ), this->indices.size( ) );
+    }
+    
+    // Uploads straight from memory the mesh does not keep (a mapped mesh cache, mesh_cache.h): vertices and indices stay empty
+    Mesh( const Vertex *vertices, size_t vertexCount, const GLuint *indices, size_t indexCount, const AABB &bounds, const vector<Texture> &textures )
+    {
+        this->textures = textures;
+        this->bounds = bounds;
+        
+        this->setupMesh( vertices, vertexCount, indices, indexCount );
     }
     
     // Render the mesh
@@ -87,7 +110,7 @@ public:
         
         // Draw mesh
         glBindVertexArray( this->VAO );
-        glDrawElements( GL_TRIANGLES, this->indices.size( ), GL_UNSIGNED_INT, 0 );
+        glDrawElements( GL_TRIANGLES, this->indexCount, GL_UNSIGNED_INT, 0 );
         glBindVertexArray( 0 );
         
         // Always good practice to set everything back to defaults once configured.
@@ -101,11 +124,14 @@ public:
 private:
     /*  Render data  */
     GLuint VAO, VBO, EBO;
+    GLsizei indexCount;
     
     /*  Functions    */
     // Initializes all the buffer objects/arrays
-    void setupMesh( )
+    void setupMesh( const Vertex *vertices, size_t vertexCount, const GLuint *indices, size_t indexCount )
     {
+        this->indexCount = ( GLsizei )indexCount;
+        
         // Create buffers/arrays
         glGenVertexArrays( 1, &this->VAO );
         glGenBuffers( 1, &this->VBO );
@@ -117,10 +143,10 @@ private:
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
-        glBufferData( GL_ARRAY_BUFFER, this->vertices.size( ) * sizeof( Vertex ), &this->vertices[0], GL_STATIC_DRAW );
+        glBufferData( GL_ARRAY_BUFFER, vertexCount * sizeof( Vertex ), vertices, GL_STATIC_DRAW );
         
         glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, this->EBO );
-        glBufferData( GL_ELEMENT_ARRAY_BUFFER, this->indices.size( ) * sizeof( GLuint ), &this->indices[0], GL_STATIC_DRAW );
+        glBufferData( GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof( GLuint ), indices, GL_STATIC_DRAW );
         
         // Set the vertex attribute pointers
         // Vertex Positions
@@ -6,12 +6,17 @@
 #include <iostream>
 #include <map>
 #include <vector>
+#include <chrono>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 //#include "SOIL2/SOIL2.h"
 
+// before the implementation below: it includes stb_image.h itself
+#include "texture_loader.h"
+#include "texture_cache.h"
+
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
@@ -20,19 +25,49 @@
 #include <assimp/postprocess.h>
 
 #include "Mesh.h"
+#include "mesh_import.h"
+#include "mesh_cache.h"
+#include "parallel.h"
 
 using namespace std;
 
 GLint TextureFromFile( const char *path, string directory );
 
+// Post-processing of every import; part of the mesh cache key, so changing it re-imports
+const unsigned int MODEL_IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs;
+
+// Time spent in each step of a load, in milliseconds
+struct ModelLoadTimes
+{
+    double read = 0.0;      // assimp import
+    double convert = 0.0;   // aiMesh to vertex / index arrays, on the worker pool
+    double upload = 0.0;    // textures (unless decoded in the background) and GL buffers, on the context thread
+    int meshes = 0;
+    int threads = 1;
+    bool cached = false;    // mapped from the mesh cache: read is the mapping, nothing was converted
+};
+
 class Model 
 {
 public:
     /*  Functions   */
-    // Constructor, expects a filepath to a 3D model.
-    Model( GLchar *path )
+    // Constructor, expects a filepath to a 3D model. The meshes are converted on pool (see getLoadTimes()).
+    // With a textureLoader the textures are decoded in the background and show once its update() uploaded them;
+    // without one every texture is decoded and uploaded here, before the constructor returns.
+    // With useMeshCache the meshes come from path.meshcache while it matches the file, skipping ASSIMP.
+    Model( GLchar *path, ThreadPool &pool = ThreadPool::instance( ), TextureLoader *textureLoader = NULL, bool useMeshCache = true )
+        : textureLoader( textureLoader ), useMeshCache( useMeshCache )
     {
-        this->loadModel( path );
+        this->loadModel( path, pool );
+    }
+    
+    // Gives back the textures: the cache deletes those no other model uses
+    ~Model( )
+    {
+        for ( GLuint i = 0; i < this->textures_acquired.size( ); i++ )
+        {
+            TextureCache::instance( ).release( this->textures_acquired[i] );
+        }
     }
     
     // Draws the model, and thus all its meshes
@@ -44,19 +79,57 @@ public:
         }
     }
     
+    // Model-space bounds of all meshes
+    AABB getBounds( )
+    {
+        AABB bounds;
+        for ( GLuint i = 0; i < this->meshes.size( ); i++ )
+        {
+            bounds.extend( this->meshes[i].bounds );
+        }
+        return bounds;
+    }
+    
+    const ModelLoadTimes &getLoadTimes( ) const
+    {
+        return this->loadTimes;
+    }
+    
 private:
     /*  Model Data  */
     vector<Mesh> meshes;
     string directory;
-    vector<Texture> textures_loaded;	// Stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    vector<CachedTexture *> textures_acquired;	// One reference per texture use, released with the model (TextureCache shares the files between models).
+    ModelLoadTimes loadTimes;
+    TextureLoader *textureLoader;
+    bool useMeshCache;
+    
+    Model( const Model & );
+    Model &operator=( const Model & );
     
     /*  Functions   */
     // Loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-    void loadModel( string path )
+    // A current mesh cache of the file (mesh_cache.h) is mapped instead, and a new one is written after an import.
+    void loadModel( string path, ThreadPool &pool )
     {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now( );
+        
+        // Retrieve the directory path of the filepath
+        this->directory = path.substr( 0, path.find_last_of( '/' ) );
+        
+        if( this->useMeshCache && this->loadCachedModel( path, pool ) )
+        {
+            return;
+        }
+        
+        // Stamp the source before reading it: if it is saved during the import, the cache written below is stale
+        long long sourceTime = 0;
+        unsigned long long sourceSize = 0;
+        bool stamped = fileStamp( path, sourceTime, sourceSize );
+        
         // Read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene *scene = importer.ReadFile( path, aiProcess_Triangulate | aiProcess_FlipUVs );
+        const aiScene *scene = importer.ReadFile( path, MODEL_IMPORT_FLAGS );
         
         // Check for errors
         if( !scene || scene->mFlags == AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode ) // if is Not Zero
@@ -64,146 +137,140 @@ private:
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString( ) << endl;
             return;
         }
-        // Retrieve the directory path of the filepath
-        this->directory = path.substr( 0, path.find_last_of( '/' ) );
         
-        // Process ASSIMP's root node recursively
-        this->processNode( scene->mRootNode, scene );
+        std::chrono::high_resolution_clock::time_point read = std::chrono::high_resolution_clock::now( );
+        
+        // Collect the meshes of ASSIMP's node tree recursively, then convert them all at once on the worker pool
+        vector<aiMesh *> sources;
+        this->processNode( scene->mRootNode, scene, sources );
+        vector<MeshData> data( sources.size( ) );
+        convertMeshes( sources.data( ), ( int )sources.size( ), data.data( ), pool );
+        
+        // The textures of every mesh, as its material names them
+        vector< vector<MeshCacheTexture> > textures( data.size( ) );
+        for ( GLuint i = 0; i < data.size( ); i++ )
+        {
+            textures[i] = this->materialTextures( scene, data[i].materialIndex );
+        }
+        if( this->useMeshCache && ( !stamped || !writeMeshCache( meshCachePath( path ), path, sourceTime, sourceSize, MODEL_IMPORT_FLAGS,
+                                                                  data.data( ), textures.data( ), ( int )data.size( ) ) ) )
+        {
+            cout << "ERROR::MODEL::MESH_CACHE_NOT_WRITTEN " << meshCachePath( path ) << endl;
+        }
+        std::chrono::high_resolution_clock::time_point converted = std::chrono::high_resolution_clock::now( );
+        
+        // GL calls stay on this (the context) thread, in node order
+        this->meshes.reserve( this->meshes.size( ) + data.size( ) );
+        for ( GLuint i = 0; i < data.size( ); i++ )
+        {
+            this->meshes.push_back( Mesh( data[i], this->acquireTextures( textures[i] ) ) );
+        }
+        std::chrono::high_resolution_clock::time_point uploaded = std::chrono::high_resolution_clock::now( );
+        
+        this->loadTimes.read = std::chrono::duration<double, std::milli>( read - start ).count( );
+        this->loadTimes.convert = std::chrono::duration<double, std::milli>( converted - read ).count( );
+        this->loadTimes.upload = std::chrono::duration<double, std::milli>( uploaded - converted ).count( );
+        this->loadTimes.meshes = ( int )data.size( );
+        this->loadTimes.threads = pool.threadCount( );
+        this->loadTimes.cached = false;
+    }
+    
+    // Maps the mesh cache of path and uploads straight from the mapping; false when there is no current cache
+    bool loadCachedModel( const string &path, ThreadPool &pool )
+    {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now( );
+        MeshCacheFile cache;
+        if( !cache.open( meshCachePath( path ), path, MODEL_IMPORT_FLAGS ) )
+        {
+            return false;
+        }
+        std::chrono::high_resolution_clock::time_point read = std::chrono::high_resolution_clock::now( );
+        
+        this->meshes.reserve( this->meshes.size( ) + cache.meshCount( ) );
+        for ( int i = 0; i < cache.meshCount( ); i++ )
+        {
+            this->meshes.push_back( Mesh( cache.vertices( i ), cache.vertexCount( i ), cache.indices( i ), cache.indexCount( i ),
+                                          cache.bounds( i ), this->acquireTextures( cache.textures( i ) ) ) );
+        }
+        std::chrono::high_resolution_clock::time_point uploaded = std::chrono::high_resolution_clock::now( );
+        
+        this->loadTimes.read = std::chrono::duration<double, std::milli>( read - start ).count( );
+        this->loadTimes.convert = 0.0;
+        this->loadTimes.upload = std::chrono::duration<double, std::milli>( uploaded - read ).count( );
+        this->loadTimes.meshes = cache.meshCount( );
+        this->loadTimes.threads = pool.threadCount( );
+        this->loadTimes.cached = true;
+        return true;
     }
     
-    // Processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode( aiNode* node, const aiScene* scene )
+    // Processes a node in a recursive fashion. Collects each individual mesh located at the node and repeats this process on its children nodes (if any).
+    void processNode( aiNode* node, const aiScene* scene, vector<aiMesh *> &sources )
     {
         // Process each mesh located at the current node
         for ( GLuint i = 0; i < node->mNumMeshes; i++ )
         {
             // The node object only contains indices to index the actual objects in the scene.
             // The scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            
-            this->meshes.push_back( this->processMesh( mesh, scene ) );
+            sources.push_back( scene->mMeshes[node->mMeshes[i]] );
         }
         
         // After we've processed all of the meshes (if any) we then recursively process each of the children nodes
         for ( GLuint i = 0; i < node->mNumChildren; i++ )
         {
-            this->processNode( node->mChildren[i], scene );
+            this->processNode( node->mChildren[i], scene, sources );
         }
     }
     
-    Mesh processMesh( aiMesh *mesh, const aiScene *scene )
+    // The texture files of a material, with the sampler name each is bound to
+    vector<MeshCacheTexture> materialTextures( const aiScene *scene, unsigned int materialIndex )
     {
-        // Data to fill
-        vector<Vertex> vertices;
-        vector<GLuint> indices;
-        vector<Texture> textures;
-        
-        // Walk through each of the mesh's vertices
-        for ( GLuint i = 0; i < mesh->mNumVertices; i++ )
+        vector<MeshCacheTexture> textures;
+        if( materialIndex >= scene->mNumMaterials )
         {
-            Vertex vertex;
-            glm::vec3 vector; // We declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
-            
-            // Positions
-            vector.x = mesh->mVertices[i].x;
-            vector.y = mesh->mVertices[i].y;
-            vector.z = mesh->mVertices[i].z;
-            vertex.Position = vector;
-            
-            // Normals
-            vector.x = mesh->mNormals[i].x;
-            vector.y = mesh->mNormals[i].y;
-            vector.z = mesh->mNormals[i].z;
-            vertex.Normal = vector;
-            
-            // Texture Coordinates
-            if( mesh->mTextureCoords[0] ) // Does the mesh contain texture coordinates?
-            {
-                glm::vec2 vec;
-                // A vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't
-                // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
-                vec.x = mesh->mTextureCoords[0][i].x;
-                vec.y = mesh->mTextureCoords[0][i].y;
-                vertex.TexCoords = vec;
-            }
-            else
-            {
-                vertex.TexCoords = glm::vec2( 0.0f, 0.0f );
-            }
-            
-            vertices.push_back( vertex );
+            return textures;
         }
-        
-        // Now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
-        for ( GLuint i = 0; i < mesh->mNumFaces; i++ )
+        aiMaterial* material = scene->mMaterials[materialIndex];
+        // We assume a convention for sampler names in the shaders. Each diffuse texture should be named
+        // as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER.
+        // Same applies to other texture as the following list summarizes:
+        // Diffuse: texture_diffuseN
+        // Specular: texture_specularN
+        // Normal: texture_normalN
+        aiTextureType types[2] = { aiTextureType_DIFFUSE, aiTextureType_SPECULAR };
+        const char *typeNames[2] = { "texture_diffuse", "texture_specular" };
+        for ( int type = 0; type < 2; type++ )
         {
-            aiFace face = mesh->mFaces[i];
-            // Retrieve all indices of the face and store them in the indices vector
-            for ( GLuint j = 0; j < face.mNumIndices; j++ )
+            for ( GLuint i = 0; i < material->GetTextureCount( types[type] ); i++ )
             {
-                indices.push_back( face.mIndices[j] );
+                aiString str;
+                material->GetTexture( types[type], i, &str );
+                textures.push_back( MeshCacheTexture( typeNames[type], str.C_Str( ) ) );
             }
         }
-        
-        // Process materials
-        if( mesh->mMaterialIndex >= 0 )
-        {
-            aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-            // We assume a convention for sampler names in the shaders. Each diffuse texture should be named
-            // as 'texture_diffuseN' where N is a sequential number ranging from 1 to MAX_SAMPLER_NUMBER.
-            // Same applies to other texture as the following list summarizes:
-            // Diffuse: texture_diffuseN
-            // Specular: texture_specularN
-            // Normal: texture_normalN
-            
-            // 1. Diffuse maps
-            vector<Texture> diffuseMaps = this->loadMaterialTextures( material, aiTextureType_DIFFUSE, "texture_diffuse" );
-            textures.insert( textures.end( ), diffuseMaps.begin( ), diffuseMaps.end( ) );
-            
-            // 2. Specular maps
-            vector<Texture> specularMaps = this->loadMaterialTextures( material, aiTextureType_SPECULAR, "texture_specular" );
-            textures.insert( textures.end( ), specularMaps.begin( ), specularMaps.end( ) );
-        }
-        
-        // Return a mesh object created from the extracted mesh data
-        return Mesh( vertices, indices, textures );
+        return textures;
     }
     
-    // Checks all material textures of a given type and loads the textures if they're not loaded yet.
-    // The required info is returned as a Texture struct.
-    vector<Texture> loadMaterialTextures( aiMaterial *mat, aiTextureType type, string typeName )
+    // Loads the textures no model has loaded yet. The required info is returned as Texture structs.
+    vector<Texture> acquireTextures( const vector<MeshCacheTexture> &references )
     {
         vector<Texture> textures;
         
-        for ( GLuint i = 0; i < mat->GetTextureCount( type ); i++ )
+        for ( GLuint i = 0; i < references.size( ); i++ )
         {
-            aiString str;
-            mat->GetTexture( type, i, &str );
-            
-            // Check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            GLboolean skip = false;
+            const MeshCacheTexture &reference = references[i];
             
-            for ( GLuint j = 0; j < textures_loaded.size( ); j++ )
+            // Shared with every other model that uses the same file: loaded only on the first acquire
+            CachedTexture *cached = TextureCache::instance( ).acquire( this->directory + '/' + reference.path, [&]( const string &file )
             {
-                if( textures_loaded[j].path == str )
-                {
-                    textures.push_back( textures_loaded[j] );
-                    skip = true; // A texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    
-                    break;
-                }
-            }
+                return this->textureLoader ? this->textureLoader->request( file ) : ( GLuint )TextureFromFile( reference.path.c_str( ), this->directory );
+            }, this->textureLoader );
+            this->textures_acquired.push_back( cached );
             
-            if( !skip )
-            {   // If texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile( str.C_Str( ), this->directory );
-                texture.type = typeName;
-                texture.path = str;
-                textures.push_back( texture );
-                
-                this->textures_loaded.push_back( texture );  // Store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-            }
+            Texture texture;
+            texture.id = cached->id;
+            texture.type = reference.type;
+            texture.path = aiString( reference.path );
+            textures.push_back( texture );
         }
         
         return textures;
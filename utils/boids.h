@@ -0,0 +1,391 @@
+// boids.h
+//
+// Flocking (Reynolds boids) for large swarms, GL independent. Every agent steers by separation
+// from, alignment with and cohesion towards the agents within neighbourRadius, away from
+// spherical obstacles and back into a bounding box. The state is kept as separate arrays
+// (positions and velocities per axis), and every step
+//   1. sorts the agents by the cell of a uniform grid over them (cells of neighbourRadius, x
+//      fastest) with a counting sort, so each row of cells is contiguous in the arrays,
+//   2. updates all agents in parallel (parallel.h); the neighbours of an agent are the nine
+//      runs of its 3 x 3 x 3 surrounding cells, 4 per SSE instruction where available,
+//   3. writes the new state into the arrays the sort read from (double buffered).
+//
+//     Flock flock;
+//     flock.add(position, velocity);                 // per agent, any number
+//     flock.obstacles.push_back(BoundingSphere(center, radius));
+//     flock.step(deltaTime);
+//     flock.writeInstances(&fleet->planes[0], planeFix, 0.05f);   // instance_data.h
+//
+// The sort reorders the agents; writeInstances() puts each one back at the index it was added
+// with, so per-instance colours stay with their agent.
+
+#ifndef BOIDS_H
+#define BOIDS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+#include "instance_data.h"
+#include "parallel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BOIDS_SSE 1
+#include <emmintrin.h>
+#endif
+
+#define BOIDS_PADDING 3
+
+// what an agent sees of its neighbours (the agents closer than the neighbour radius, not itself)
+struct FlockSums
+{
+    int count;
+    glm::vec3 position;     // sum of neighbour positions
+    glm::vec3 velocity;     // sum of neighbour velocities
+    glm::vec3 separation;   // sum of (agent - neighbour) / distance^2 over neighbours closer than the separation radius
+
+    FlockSums() : count(0), position(0.0f), velocity(0.0f), separation(0.0f) { }
+};
+
+// adds the agents in the runs ranges[2k] .. ranges[2k + 1] of the arrays to the sums of the agent
+// at p (itself, at distance 0, is skipped)
+inline void gatherNeighboursScalar(const float *x, const float *y, const float *z, const float *vx, const float *vy, const float *vz,
+                                   const int *ranges, int rangeCount, const glm::vec3 &p, float radiusSquared, float separationSquared,
+                                   FlockSums &sums)
+{
+    for (int r = 0; r < rangeCount; r++) {
+        for (int i = ranges[r * 2]; i < ranges[r * 2 + 1]; i++) {
+            float dx = p.x - x[i], dy = p.y - y[i], dz = p.z - z[i];
+            float d2 = dx * dx + dy * dy + dz * dz;
+            if (d2 >= radiusSquared || d2 <= 0.0f) continue;
+            sums.count++;
+            sums.position += glm::vec3(x[i], y[i], z[i]);
+            sums.velocity += glm::vec3(vx[i], vy[i], vz[i]);
+            if (d2 < separationSquared) sums.separation += glm::vec3(dx, dy, dz) / d2;
+        }
+    }
+}
+
+#ifdef BOIDS_SSE
+inline float boidsHorizontalSum(__m128 v)
+{
+    __m128 pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+}
+
+// four agents at a time, the sums kept in registers over all runs; the last 1-3 agents of a run
+// are loaded as a full group with the lanes past its end masked off, so the arrays need
+// BOIDS_PADDING readable floats after the last agent
+inline void gatherNeighboursSSE(const float *x, const float *y, const float *z, const float *vx, const float *vy, const float *vz,
+                                const int *ranges, int rangeCount, const glm::vec3 &p, float radiusSquared, float separationSquared,
+                                FlockSums &sums)
+{
+    const __m128 px = _mm_set1_ps(p.x), py = _mm_set1_ps(p.y), pz = _mm_set1_ps(p.z);
+    const __m128 r2 = _mm_set1_ps(radiusSquared), s2 = _mm_set1_ps(separationSquared), zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    const __m128 lane = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    __m128 count = zero, sx = zero, sy = zero, sz = zero, svx = zero, svy = zero, svz = zero, ex = zero, ey = zero, ez = zero;
+    for (int r = 0; r < rangeCount; r++) {
+        int begin = ranges[r * 2], end = ranges[r * 2 + 1];
+        for (int i = begin; i < end; i += 4) {
+            __m128 nx = _mm_loadu_ps(x + i), ny = _mm_loadu_ps(y + i), nz = _mm_loadu_ps(z + i);
+            __m128 valid = _mm_cmplt_ps(lane, _mm_set1_ps((float)(end - i)));
+            __m128 dx = _mm_sub_ps(px, nx), dy = _mm_sub_ps(py, ny), dz = _mm_sub_ps(pz, nz);
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            __m128 neighbour = _mm_and_ps(valid, _mm_and_ps(_mm_cmplt_ps(d2, r2), _mm_cmpgt_ps(d2, zero)));
+            if (_mm_movemask_ps(neighbour) == 0) continue;
+            count = _mm_add_ps(count, _mm_and_ps(neighbour, one));
+            sx = _mm_add_ps(sx, _mm_and_ps(neighbour, nx));
+            sy = _mm_add_ps(sy, _mm_and_ps(neighbour, ny));
+            sz = _mm_add_ps(sz, _mm_and_ps(neighbour, nz));
+            svx = _mm_add_ps(svx, _mm_and_ps(neighbour, _mm_loadu_ps(vx + i)));
+            svy = _mm_add_ps(svy, _mm_and_ps(neighbour, _mm_loadu_ps(vy + i)));
+            svz = _mm_add_ps(svz, _mm_and_ps(neighbour, _mm_loadu_ps(vz + i)));
+            // 1 / d2 of a lane at distance 0 is infinite: the mask clears it
+            __m128 crowded = _mm_and_ps(neighbour, _mm_cmplt_ps(d2, s2));
+            __m128 inverse = _mm_and_ps(crowded, _mm_div_ps(one, d2));
+            ex = _mm_add_ps(ex, _mm_mul_ps(dx, inverse));
+            ey = _mm_add_ps(ey, _mm_mul_ps(dy, inverse));
+            ez = _mm_add_ps(ez, _mm_mul_ps(dz, inverse));
+        }
+    }
+    sums.count += (int)boidsHorizontalSum(count);
+    sums.position += glm::vec3(boidsHorizontalSum(sx), boidsHorizontalSum(sy), boidsHorizontalSum(sz));
+    sums.velocity += glm::vec3(boidsHorizontalSum(svx), boidsHorizontalSum(svy), boidsHorizontalSum(svz));
+    sums.separation += glm::vec3(boidsHorizontalSum(ex), boidsHorizontalSum(ey), boidsHorizontalSum(ez));
+}
+#endif
+
+// the SIMD kernel where compiled in, otherwise the scalar one
+inline void gatherNeighboursKernel(const float *x, const float *y, const float *z, const float *vx, const float *vy, const float *vz,
+                                   const int *ranges, int rangeCount, const glm::vec3 &p, float radiusSquared, float separationSquared,
+                                   FlockSums &sums)
+{
+#ifdef BOIDS_SSE
+    gatherNeighboursSSE(x, y, z, vx, vy, vz, ranges, rangeCount, p, radiusSquared, separationSquared, sums);
+#else
+    gatherNeighboursScalar(x, y, z, vx, vy, vz, ranges, rangeCount, p, radiusSquared, separationSquared, sums);
+#endif
+}
+
+class Flock
+{
+public:
+    float neighbourRadius = 2.0f;       // also the grid cell size (larger for a very spread out flock)
+    float separationRadius = 0.7f;
+    float separationWeight = 4.0f;
+    float alignmentWeight = 1.5f;
+    float cohesionWeight = 0.8f;
+    float avoidanceWeight = 20.0f;      // per unit of depth into an obstacle's margin
+    float avoidanceMargin = 2.0f;       // obstacles push from this far outside their radius
+    float boundsWeight = 4.0f;          // per unit outside bounds
+    float minSpeed = 2.0f, maxSpeed = 6.0f;
+    float maxAcceleration = 20.0f;
+    AABB bounds = AABB(glm::vec3(-50.0f), glm::vec3(50.0f));
+    std::vector<BoundingSphere> obstacles;
+    bool simd = true;                   // false: the scalar neighbour kernel (for comparison)
+
+    Flock() : gridOrigin(0.0f), cellSize(1.0f), sortMilliseconds(0.0), updateMilliseconds(0.0) { dims[0] = dims[1] = dims[2] = 1; }
+
+    // returns the agent's index: the one writeInstances() writes it to
+    int add(const glm::vec3 &position, const glm::vec3 &velocity)
+    {
+        int id = size();
+        for (int b = 0; b < 2; b++) {
+            Agents &a = state[b];
+            // the arrays are BOIDS_PADDING longer than the agent count (see gatherNeighboursSSE)
+            a.x.resize(id + 1 + BOIDS_PADDING); a.y.resize(id + 1 + BOIDS_PADDING); a.z.resize(id + 1 + BOIDS_PADDING);
+            a.vx.resize(id + 1 + BOIDS_PADDING); a.vy.resize(id + 1 + BOIDS_PADDING); a.vz.resize(id + 1 + BOIDS_PADDING);
+            a.x[id] = position.x; a.y[id] = position.y; a.z[id] = position.z;
+            a.vx[id] = velocity.x; a.vy[id] = velocity.y; a.vz[id] = velocity.z;
+            a.id.push_back(id);
+        }
+        return id;
+    }
+
+    int size() const
+    {
+        return (int)state[0].id.size();
+    }
+
+    // moves every agent dt seconds on
+    void step(float dt)
+    {
+        typedef std::chrono::high_resolution_clock Clock;
+        Clock::time_point start = Clock::now();
+        sort();
+        Clock::time_point sorted = Clock::now();
+        update(dt);
+        Clock::time_point updated = Clock::now();
+        sortMilliseconds = std::chrono::duration<double, std::milli>(sorted - start).count();
+        updateMilliseconds = std::chrono::duration<double, std::milli>(updated - sorted).count();
+    }
+
+    // Model matrices into out[agent index]: the mesh, first turned by modelFix so its nose points
+    // along +z and its top along +y, then scaled, is aimed along the velocity. Colours are kept.
+    void writeInstances(InstanceData *out, const glm::mat4 &modelFix, float scale) const
+    {
+        const Agents &a = state[0];
+        glm::mat4 fix = modelFix;
+        fix[0] *= scale; fix[1] *= scale; fix[2] *= scale;
+        parallelFor(0, size(), 4096, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                glm::vec3 forward(a.vx[i], a.vy[i], a.vz[i]);
+                float speed = glm::length(forward);
+                forward = speed > 0.0f ? forward / speed : glm::vec3(0.0f, 0.0f, 1.0f);
+                glm::vec3 hint = std::fabs(forward.y) > 0.999f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+                glm::vec3 right = glm::normalize(glm::cross(hint, forward));
+                glm::vec3 up = glm::cross(forward, right);
+                glm::mat4 orientation(glm::vec4(right, 0.0f), glm::vec4(up, 0.0f), glm::vec4(forward, 0.0f), glm::vec4(a.x[i], a.y[i], a.z[i], 1.0f));
+                out[a.id[i]].model = orientation * fix;
+            }
+        });
+    }
+
+    glm::vec3 getPosition(int slot) const
+    {
+        return glm::vec3(state[0].x[slot], state[0].y[slot], state[0].z[slot]);
+    }
+
+    glm::vec3 getVelocity(int slot) const
+    {
+        return glm::vec3(state[0].vx[slot], state[0].vy[slot], state[0].vz[slot]);
+    }
+
+    // agent index of the agent at array slot `slot` (slots change order every step)
+    int getId(int slot) const
+    {
+        return state[0].id[slot];
+    }
+
+    // The neighbours of slot through the grid of the last step (as its update saw them, before
+    // the agents moved: the positions of that state are the sorted buffer).
+    FlockSums gatherNeighbours(int slot) const
+    {
+        const Agents &s = state[1];
+        FlockSums sums;
+        gatherGrid(s, glm::vec3(s.x[slot], s.y[slot], s.z[slot]), sums, simd);
+        return sums;
+    }
+
+    // the same by testing every agent, for checking
+    FlockSums gatherNeighboursBruteForce(int slot) const
+    {
+        const Agents &s = state[1];
+        FlockSums sums;
+        int all[2] = { 0, size() };
+        gatherNeighboursScalar(&s.x[0], &s.y[0], &s.z[0], &s.vx[0], &s.vy[0], &s.vz[0], all, 1,
+            glm::vec3(s.x[slot], s.y[slot], s.z[slot]), neighbourRadius * neighbourRadius, separationRadius * separationRadius, sums);
+        return sums;
+    }
+
+    // time the last step() spent sorting into the grid and updating the agents
+    double getSortMilliseconds() const
+    {
+        return sortMilliseconds;
+    }
+
+    double getUpdateMilliseconds() const
+    {
+        return updateMilliseconds;
+    }
+
+private:
+    struct Agents
+    {
+        std::vector<float> x, y, z, vx, vy, vz;
+        std::vector<int> id;
+    };
+
+    // state[0]: the current agents; state[1]: the same sorted by cell, read by update()
+    Agents state[2];
+    std::vector<unsigned int> cellOf, cellStart, cursor;
+    glm::vec3 gridOrigin;
+    float cellSize;
+    int dims[3];
+    double sortMilliseconds, updateMilliseconds;
+
+    // grid coordinates of p, clamped into the grid
+    void cellCoordinates(const glm::vec3 &p, int c[3]) const
+    {
+        glm::vec3 grid = (p - gridOrigin) / cellSize;
+        for (int axis = 0; axis < 3; axis++) c[axis] = std::min(std::max((int)grid[axis], 0), dims[axis] - 1);
+    }
+
+    // counting sort of state[0] by cell into state[1]; the grid covers the agents' bounds
+    void sort()
+    {
+        int count = size();
+        const Agents &a = state[0];
+        AABB box;
+        for (int i = 0; i < count; i++) box.extend(glm::vec3(a.x[i], a.y[i], a.z[i]));
+        if (count == 0) box = AABB(glm::vec3(0.0f), glm::vec3(0.0f));
+
+        // cells of neighbourRadius, larger if the agents spread too far for a table of ~2 per agent
+        gridOrigin = box.min;
+        cellSize = neighbourRadius;
+        long long cells, maxCells = std::max(4096LL, 2LL * count);
+        for (;;) {
+            cells = 1;
+            for (int axis = 0; axis < 3; axis++) {
+                dims[axis] = (int)std::min((box.max[axis] - box.min[axis]) / cellSize, 1e6f) + 1;
+                cells *= dims[axis];
+            }
+            if (cells <= maxCells) break;
+            cellSize *= 1.25f;
+        }
+        cellOf.resize(count);
+        cellStart.assign((size_t)cells + 1, 0);
+
+        parallelFor(0, count, 4096, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                int c[3];
+                cellCoordinates(glm::vec3(a.x[i], a.y[i], a.z[i]), c);
+                cellOf[i] = (unsigned int)((c[2] * dims[1] + c[1]) * dims[0] + c[0]);
+            }
+        });
+        for (int i = 0; i < count; i++) cellStart[cellOf[i] + 1]++;
+        for (long long c = 0; c < cells; c++) cellStart[c + 1] += cellStart[c];
+        cursor.assign(cellStart.begin(), cellStart.end() - 1);
+
+        Agents &s = state[1];
+        for (int i = 0; i < count; i++) {
+            unsigned int slot = cursor[cellOf[i]]++;
+            s.x[slot] = a.x[i]; s.y[slot] = a.y[i]; s.z[slot] = a.z[i];
+            s.vx[slot] = a.vx[i]; s.vy[slot] = a.vy[i]; s.vz[slot] = a.vz[i];
+            s.id[slot] = a.id[i];
+        }
+    }
+
+    // sums over the 27 cells around p: 9 rows of 3 cells, each row one contiguous run
+    void gatherGrid(const Agents &s, const glm::vec3 &p, FlockSums &sums, bool useSimd) const
+    {
+        if (cellStart.empty()) return;
+        int c[3];
+        cellCoordinates(p, c);
+        int x0 = std::max(c[0] - 1, 0), x1 = std::min(c[0] + 1, dims[0] - 1);
+        int ranges[18];
+        int rangeCount = 0;
+        for (int z = std::max(c[2] - 1, 0); z <= std::min(c[2] + 1, dims[2] - 1); z++) {
+            for (int y = std::max(c[1] - 1, 0); y <= std::min(c[1] + 1, dims[1] - 1); y++) {
+                int row = (z * dims[1] + y) * dims[0];
+                int begin = (int)cellStart[row + x0], end = (int)cellStart[row + x1 + 1];
+                if (begin == end) continue;
+                ranges[rangeCount * 2] = begin;
+                ranges[rangeCount * 2 + 1] = end;
+                rangeCount++;
+            }
+        }
+        float r2 = neighbourRadius * neighbourRadius, s2 = separationRadius * separationRadius;
+        if (useSimd) gatherNeighboursKernel(&s.x[0], &s.y[0], &s.z[0], &s.vx[0], &s.vy[0], &s.vz[0], ranges, rangeCount, p, r2, s2, sums);
+        else gatherNeighboursScalar(&s.x[0], &s.y[0], &s.z[0], &s.vx[0], &s.vy[0], &s.vz[0], ranges, rangeCount, p, r2, s2, sums);
+    }
+
+    // steers every agent of state[1] and writes it, moved, to the same slot of state[0]
+    void update(float dt)
+    {
+        const Agents &s = state[1];
+        Agents &out = state[0];
+        parallelFor(0, size(), 256, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                glm::vec3 p(s.x[i], s.y[i], s.z[i]), v(s.vx[i], s.vy[i], s.vz[i]);
+                FlockSums sums;
+                gatherGrid(s, p, sums, simd);
+
+                glm::vec3 acceleration(0.0f);
+                if (sums.count > 0) {
+                    float inverseCount = 1.0f / (float)sums.count;
+                    acceleration += separationWeight * sums.separation;
+                    acceleration += alignmentWeight * (sums.velocity * inverseCount - v);
+                    acceleration += cohesionWeight * (sums.position * inverseCount - p);
+                }
+                for (size_t o = 0; o < obstacles.size(); o++) {
+                    glm::vec3 offset = p - obstacles[o].center;
+                    float distance = glm::length(offset), reach = obstacles[o].radius + avoidanceMargin;
+                    if (distance < reach && distance > 0.0f) acceleration += offset * (avoidanceWeight * (reach - distance) / distance);
+                }
+                acceleration += boundsWeight * (glm::max(bounds.min - p, glm::vec3(0.0f)) - glm::max(p - bounds.max, glm::vec3(0.0f)));
+
+                float length = glm::length(acceleration);
+                if (length > maxAcceleration) acceleration *= maxAcceleration / length;
+                v += acceleration * dt;
+                float speed = glm::length(v);
+                if (speed > maxSpeed) v *= maxSpeed / speed;
+                else if (speed < minSpeed && speed > 0.0f) v *= minSpeed / speed;
+                p += v * dt;
+
+                out.x[i] = p.x; out.y[i] = p.y; out.z[i] = p.z;
+                out.vx[i] = v.x; out.vy[i] = v.y; out.vz[i] = v.z;
+                out.id[i] = s.id[i];
+            }
+        });
+    }
+
+    Flock(const Flock &);
+    Flock &operator=(const Flock &);
+};
+
+#endif
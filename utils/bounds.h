@@ -0,0 +1,121 @@
+// bounds.h
+//
+// Bounding volumes for the drawables, GL independent.
+// Every drawing class reports its bounds in its own (model) space; transformed() moves them to
+// world space with the model matrix the object is drawn with:
+//
+//     BoundingSphere world = cube->getBoundingSphere().transformed(model);
+//
+// AABB::transformed() keeps the box tight under rotation (the extents are re-projected on the
+// world axes); BoundingSphere::transformed() scales the radius by the largest axis scale.
+
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include <cfloat>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+struct AABB
+{
+    glm::vec3 min, max;
+
+    // empty: extend() with the first point makes it that point
+    AABB() : min(FLT_MAX), max(-FLT_MAX) { }
+    AABB(const glm::vec3 &min, const glm::vec3 &max) : min(min), max(max) { }
+
+    // from packed xyz floats (the vertex arrays of the drawing classes)
+    static AABB fromPoints(const float *xyz, int count)
+    {
+        AABB box;
+        for (int i = 0; i < count; i++) box.extend(glm::vec3(xyz[i * 3], xyz[i * 3 + 1], xyz[i * 3 + 2]));
+        return box;
+    }
+
+    bool isEmpty() const
+    {
+        return min.x > max.x;
+    }
+
+    void extend(const glm::vec3 &point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void extend(const AABB &other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    glm::vec3 center() const
+    {
+        return (min + max) * 0.5f;
+    }
+
+    glm::vec3 extent() const   // half size
+    {
+        return (max - min) * 0.5f;
+    }
+
+    float surfaceArea() const
+    {
+        glm::vec3 size = max - min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    bool overlaps(const AABB &other) const
+    {
+        return min.x <= other.max.x && max.x >= other.min.x && min.y <= other.max.y && max.y >= other.min.y &&
+               min.z <= other.max.z && max.z >= other.min.z;
+    }
+
+    AABB transformed(const glm::mat4 &model) const
+    {
+        glm::vec3 c = glm::vec3(model * glm::vec4(center(), 1.0f));
+        glm::vec3 e = extent();
+        glm::vec3 worldExtent;
+        for (int axis = 0; axis < 3; axis++) {
+            worldExtent[axis] = std::fabs(model[0][axis]) * e.x + std::fabs(model[1][axis]) * e.y + std::fabs(model[2][axis]) * e.z;
+        }
+        return AABB(c - worldExtent, c + worldExtent);
+    }
+};
+
+struct BoundingSphere
+{
+    glm::vec3 center;
+    float radius;
+
+    BoundingSphere() : center(0.0f), radius(0.0f) { }
+    BoundingSphere(const glm::vec3 &center, float radius) : center(center), radius(radius) { }
+
+    // the sphere around the box (not the smallest one around the points inside it)
+    static BoundingSphere fromAABB(const AABB &box)
+    {
+        return BoundingSphere(box.center(), glm::length(box.extent()));
+    }
+
+    BoundingSphere transformed(const glm::mat4 &model) const
+    {
+        float scaleSquared = glm::max(glm::max(glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+                                               glm::dot(glm::vec3(model[1]), glm::vec3(model[1]))),
+                                      glm::dot(glm::vec3(model[2]), glm::vec3(model[2])));
+        return BoundingSphere(glm::vec3(model * glm::vec4(center, 1.0f)), radius * std::sqrt(scaleSquared));
+    }
+
+    // grows this sphere to also hold other
+    void extend(const BoundingSphere &other)
+    {
+        float distance = glm::length(other.center - center);
+        if (distance + other.radius <= radius) return;
+        if (distance + radius <= other.radius) { *this = other; return; }
+        float newRadius = (distance + radius + other.radius) * 0.5f;
+        center += (other.center - center) * ((newRadius - radius) / distance);
+        radius = newRadius;
+    }
+};
+
+#endif
@@ -0,0 +1,502 @@
+// bvh.h
+//
+// Bounding volume hierarchy over scene objects for culling, picking and proximity queries,
+// GL independent. Objects are ids 0..count-1 with a world-space AABB each (bounds.h).
+//
+//     BVH bvh;
+//     bvh.build(&boxes[0], count);                // binned SAH, up to 4 objects per leaf
+//     bvh.setBounds(id, movedBox);                // objects move...
+//     bvh.commit();                               // ...refit (or rebuild when it got too loose)
+//     bvh.queryFrustum(Frustum::fromMatrix(projection * view), visible);
+//     int hit = bvh.raycast(origin, direction, distance);
+//
+// commit() refits only the paths above moved objects while few moved, and all nodes bottom-up
+// otherwise. Refitting keeps the tree shape, so after large motion the boxes overlap more and
+// queries slow down: when the SAH cost of the refitted tree exceeds rebuildFactor times the cost
+// right after the last build, commit() rebuilds instead.
+// From depth MEDIAN_DEPTH on the build splits at the centroid median instead of by SAH, so skewed scenes
+// (e.g. objects spaced further apart the further out they are) cannot outgrow the query stacks.
+
+#ifndef BVH_H
+#define BVH_H
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+#include "frustum.h"
+
+class BVH
+{
+public:
+    enum { LEAF_SIZE = 4, BINS = 12 };
+
+    float rebuildFactor = 1.5f;
+
+    BVH() : buildCost(0.0f), rebuilds(0) { }
+
+    void build(const AABB *bounds, int count)
+    {
+        boxes.assign(bounds, bounds + count);
+        rebuild();
+    }
+
+    // world bounds of one object; takes effect at commit()
+    void setBounds(int object, const AABB &box)
+    {
+        boxes[object] = box;
+        if (!moved[object]) {
+            moved[object] = 1;
+            movedObjects.push_back(object);
+        }
+    }
+
+    const AABB &getBounds(int object) const
+    {
+        return boxes[object];
+    }
+
+    // brings the tree up to date with setBounds(); returns true if it was rebuilt
+    bool commit()
+    {
+        if (movedObjects.empty()) return false;
+        if (movedObjects.size() * 8 < boxes.size()) {
+            for (size_t i = 0; i < movedObjects.size(); i++) refitPath(leafOf[movedObjects[i]]);
+        }
+        else {
+            refitAll();
+        }
+        for (size_t i = 0; i < movedObjects.size(); i++) moved[movedObjects[i]] = 0;
+        movedObjects.clear();
+
+        if (cost() > buildCost * rebuildFactor) {
+            rebuild();
+            return true;
+        }
+        return false;
+    }
+
+    // rebuilds from the current bounds
+    void rebuild()
+    {
+        int count = (int)boxes.size();
+        items.resize(count);
+        for (int i = 0; i < count; i++) {
+            items[i].box = boxes[i];
+            items[i].centroid = boxes[i].center();
+            items[i].object = i;
+        }
+        order.resize(count);
+        leafOf.assign(count, -1);
+        moved.assign(count, 0);
+        movedObjects.clear();
+        nodes.clear();
+        parents.clear();
+        nodes.reserve(count > 0 ? 2 * (count / LEAF_SIZE + 1) : 1);
+        parents.reserve(nodes.capacity());
+        if (count > 0) {
+            newNode(-1);
+            split(0, 0, count, 0);
+        }
+        buildCost = cost();
+        rebuilds++;
+    }
+
+    // SAH cost: sum over the nodes of (node area / root area) * objects (leaves) or 1 (inner nodes)
+    float cost() const
+    {
+        if (nodes.empty()) return 0.0f;
+        float rootArea = nodes[0].bounds.surfaceArea();
+        if (rootArea <= 0.0f) return 0.0f;
+        float total = 0.0f;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            total += nodes[i].bounds.surfaceArea() / rootArea * (nodes[i].isLeaf() ? (float)nodes[i].count : 1.0f);
+        }
+        return total;
+    }
+
+    int objectCount() const { return (int)boxes.size(); }
+    int nodeCount() const { return (int)nodes.size(); }
+    int rebuildCount() const { return rebuilds; }
+
+    // Query callbacks get object ids; the out-vector versions append to out.
+
+    // objects whose box touches the frustum; subtrees entirely inside are taken without testing
+    template <typename Fn>
+    void queryFrustum(const Frustum &frustum, Fn fn) const
+    {
+        if (nodes.empty()) return;
+        int stack[STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node &node = nodes[stack[--top]];
+            int classification = classify(frustum, node.bounds);
+            if (classification < 0) continue;
+            if (classification > 0 || node.isLeaf()) {
+                bool inside = classification > 0;
+                for (int i = node.first; i < node.first + node.count; i++) {
+                    if (inside || frustum.intersects(boxes[order[i]])) fn(order[i]);
+                }
+                continue;
+            }
+            push(stack, top, node.left);
+        }
+    }
+
+    void queryFrustum(const Frustum &frustum, std::vector<int> &out) const
+    {
+        queryFrustum(frustum, [&out](int object) { out.push_back(object); });
+    }
+
+    template <typename Fn>
+    void queryAABB(const AABB &box, Fn fn) const
+    {
+        if (nodes.empty()) return;
+        int stack[STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node &node = nodes[stack[--top]];
+            if (!node.bounds.overlaps(box)) continue;
+            if (node.isLeaf()) {
+                for (int i = node.first; i < node.first + node.count; i++) {
+                    if (boxes[order[i]].overlaps(box)) fn(order[i]);
+                }
+                continue;
+            }
+            push(stack, top, node.left);
+        }
+    }
+
+    void queryAABB(const AABB &box, std::vector<int> &out) const
+    {
+        queryAABB(box, [&out](int object) { out.push_back(object); });
+    }
+
+    template <typename Fn>
+    void querySphere(const glm::vec3 &center, float radius, Fn fn) const
+    {
+        if (nodes.empty()) return;
+        float radiusSquared = radius * radius;
+        int stack[STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node &node = nodes[stack[--top]];
+            if (distanceSquared(node.bounds, center) > radiusSquared) continue;
+            if (node.isLeaf()) {
+                for (int i = node.first; i < node.first + node.count; i++) {
+                    if (distanceSquared(boxes[order[i]], center) <= radiusSquared) fn(order[i]);
+                }
+                continue;
+            }
+            push(stack, top, node.left);
+        }
+    }
+
+    void querySphere(const glm::vec3 &center, float radius, std::vector<int> &out) const
+    {
+        querySphere(center, radius, [&out](int object) { out.push_back(object); });
+    }
+
+    // every object whose box the ray enters before maxDistance: fn(object, entryDistance)
+    template <typename Fn>
+    void queryRay(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, Fn fn) const
+    {
+        if (nodes.empty()) return;
+        glm::vec3 inverse = inverseDirection(direction);
+        int stack[STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node &node = nodes[stack[--top]];
+            float entry;
+            if (!rayHitsBox(node.bounds, origin, inverse, maxDistance, entry)) continue;
+            if (node.isLeaf()) {
+                for (int i = node.first; i < node.first + node.count; i++) {
+                    if (rayHitsBox(boxes[order[i]], origin, inverse, maxDistance, entry)) fn(order[i], entry);
+                }
+                continue;
+            }
+            push(stack, top, node.left);
+        }
+    }
+
+    // the object whose box the ray enters first (picking), -1 for none; distance gets the entry distance
+    int raycast(const glm::vec3 &origin, const glm::vec3 &direction, float &distance, float maxDistance = FLT_MAX) const
+    {
+        int best = -1;
+        distance = maxDistance;
+        if (nodes.empty()) return best;
+        glm::vec3 inverse = inverseDirection(direction);
+        int stack[STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node &node = nodes[stack[--top]];
+            float entry;
+            if (!rayHitsBox(node.bounds, origin, inverse, distance, entry)) continue;
+            if (node.isLeaf()) {
+                for (int i = node.first; i < node.first + node.count; i++) {
+                    if (rayHitsBox(boxes[order[i]], origin, inverse, distance, entry) && entry < distance) {
+                        distance = entry;
+                        best = order[i];
+                    }
+                }
+                continue;
+            }
+            // nearer child last, so it is visited first and shrinks distance for the other one
+            float leftEntry, rightEntry;
+            bool hitLeft = rayHitsBox(nodes[node.left].bounds, origin, inverse, distance, leftEntry);
+            bool hitRight = rayHitsBox(nodes[node.left + 1].bounds, origin, inverse, distance, rightEntry);
+            assert(top + 2 <= STACK_SIZE);
+            if (hitLeft && hitRight) {
+                bool leftFirst = leftEntry <= rightEntry;
+                stack[top++] = leftFirst ? node.left + 1 : node.left;
+                stack[top++] = leftFirst ? node.left : node.left + 1;
+            }
+            else if (hitLeft) stack[top++] = node.left;
+            else if (hitRight) stack[top++] = node.left + 1;
+        }
+        return best;
+    }
+
+private:
+    // a traversal holds at most one pending sibling per level plus two children: with median
+    // splits from MEDIAN_DEPTH on, no tree of up to 2^31 objects is deep enough to fill STACK_SIZE
+    enum { STACK_SIZE = 128, MEDIAN_DEPTH = 64 };
+
+    struct Node
+    {
+        AABB bounds;
+        int left;       // first of the two children (the second is left + 1), -1 for a leaf
+        int first;      // the node's objects are order[first, first + count), for inner nodes too
+        int count;
+
+        bool isLeaf() const { return left < 0; }
+    };
+
+    // the build partitions copies of the boxes rather than indices to them, so each pass over
+    // a range reads memory in order instead of jumping around the whole scene
+    struct BuildItem
+    {
+        AABB box;
+        glm::vec3 centroid;
+        int object;
+    };
+
+    std::vector<AABB> boxes;            // by object
+    std::vector<int> order;             // objects sorted so each subtree is a range
+    std::vector<BuildItem> items;       // build input, sorted along with order
+    std::vector<Node> nodes;            // children after their parent
+    std::vector<int> parents;
+    std::vector<int> leafOf;            // by object
+    std::vector<unsigned char> moved;   // by object
+    std::vector<int> movedObjects;
+    float buildCost;
+    int rebuilds;
+
+    int newNode(int parent)
+    {
+        Node node;
+        node.left = -1; node.first = 0; node.count = 0;
+        nodes.push_back(node);
+        parents.push_back(parent);
+        return (int)nodes.size() - 1;
+    }
+
+    static void push(int *stack, int &top, int left)
+    {
+        assert(top + 2 <= STACK_SIZE);
+        stack[top++] = left + 1;
+        stack[top++] = left;
+    }
+
+    AABB rangeBounds(int first, int count) const
+    {
+        AABB box;
+        for (int i = first; i < first + count; i++) box.extend(boxes[order[i]]);
+        return box;
+    }
+
+    // makes node `index` (at depth `depth`) cover order[first, first + count), splitting it by
+    // binned SAH, or at the centroid median along the widest axis from MEDIAN_DEPTH on
+    void split(int index, int first, int count, int depth)
+    {
+        AABB box, centroidBox;
+        for (int i = first; i < first + count; i++) {
+            box.extend(items[i].box);
+            centroidBox.extend(items[i].centroid);
+        }
+        nodes[index].first = first;
+        nodes[index].count = count;
+        nodes[index].bounds = box;
+        if (count <= LEAF_SIZE) {
+            makeLeaf(index);
+            return;
+        }
+        if (depth >= MEDIAN_DEPTH) {
+            glm::vec3 size = centroidBox.max - centroidBox.min;
+            int axis = size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2);
+            int middle = first + count / 2;
+            std::nth_element(&items[first], &items[middle], &items[first] + count, [axis](const BuildItem &a, const BuildItem &b) {
+                return a.centroid[axis] < b.centroid[axis];
+            });
+            splitAt(index, first, count, middle, depth);
+            return;
+        }
+
+        // one pass bins the objects along all three axes
+        glm::vec3 lo = centroidBox.min, size = centroidBox.max - centroidBox.min;
+        glm::vec3 scale(size.x > 1e-12f ? BINS / size.x : 0.0f, size.y > 1e-12f ? BINS / size.y : 0.0f, size.z > 1e-12f ? BINS / size.z : 0.0f);
+        AABB binBox[3][BINS];
+        int binCount[3][BINS] = { { 0 } };
+        for (int i = first; i < first + count; i++) {
+            const glm::vec3 &c = items[i].centroid;
+            for (int axis = 0; axis < 3; axis++) {
+                int bin = std::min(BINS - 1, (int)((c[axis] - lo[axis]) * scale[axis]));
+                binCount[axis][bin]++;
+                binBox[axis][bin].extend(items[i].box);
+            }
+        }
+
+        int bestAxis = -1, bestBin = 0;
+        float bestCost = FLT_MAX;
+        for (int axis = 0; axis < 3; axis++) {
+            if (scale[axis] == 0.0f) continue;
+            // sweep from the right to get the right side of every split plane
+            float rightArea[BINS];
+            int rightCount[BINS];
+            AABB accumulated;
+            int accumulatedCount = 0;
+            for (int b = BINS - 1; b > 0; b--) {
+                accumulated.extend(binBox[axis][b]);
+                accumulatedCount += binCount[axis][b];
+                rightArea[b] = accumulated.isEmpty() ? 0.0f : accumulated.surfaceArea();
+                rightCount[b] = accumulatedCount;
+            }
+            accumulated = AABB();
+            accumulatedCount = 0;
+            for (int b = 0; b < BINS - 1; b++) {
+                accumulated.extend(binBox[axis][b]);
+                accumulatedCount += binCount[axis][b];
+                if (accumulatedCount == 0 || rightCount[b + 1] == 0) continue;
+                float splitCost = accumulated.surfaceArea() * accumulatedCount + rightArea[b + 1] * rightCount[b + 1];
+                if (splitCost < bestCost) {
+                    bestCost = splitCost;
+                    bestAxis = axis;
+                    bestBin = b;
+                }
+            }
+        }
+
+        int middle;
+        if (bestAxis < 0) {
+            // all centroids in one point: halve the range
+            middle = first + count / 2;
+        }
+        else {
+            int axis = bestAxis, bin = bestBin;
+            float axisLo = lo[axis], axisScale = scale[axis];
+            BuildItem *split = std::partition(&items[first], &items[first] + count, [&](const BuildItem &item) {
+                return std::min(BINS - 1, (int)((item.centroid[axis] - axisLo) * axisScale)) <= bin;
+            });
+            middle = (int)(split - &items[0]);
+            if (middle == first || middle == first + count) middle = first + count / 2;
+        }
+        splitAt(index, first, count, middle, depth);
+    }
+
+    void splitAt(int index, int first, int count, int middle, int depth)
+    {
+        int left = newNode(index);
+        newNode(index);
+        nodes[index].left = left;
+        split(left, first, middle - first, depth + 1);
+        split(left + 1, middle, first + count - middle, depth + 1);
+    }
+
+    void makeLeaf(int index)
+    {
+        nodes[index].left = -1;
+        for (int i = nodes[index].first; i < nodes[index].first + nodes[index].count; i++) {
+            order[i] = items[i].object;
+            leafOf[order[i]] = index;
+        }
+    }
+
+    // recomputes the bounds from a leaf up to the root, stopping where nothing changes
+    void refitPath(int index)
+    {
+        while (index >= 0) {
+            Node &node = nodes[index];
+            AABB box = node.isLeaf() ? rangeBounds(node.first, node.count) : unionOf(nodes[node.left].bounds, nodes[node.left + 1].bounds);
+            if (box.min == node.bounds.min && box.max == node.bounds.max) return;
+            node.bounds = box;
+            index = parents[index];
+        }
+    }
+
+    void refitAll()
+    {
+        for (int i = (int)nodes.size() - 1; i >= 0; i--) {
+            Node &node = nodes[i];
+            node.bounds = node.isLeaf() ? rangeBounds(node.first, node.count) : unionOf(nodes[node.left].bounds, nodes[node.left + 1].bounds);
+        }
+    }
+
+    static AABB unionOf(const AABB &a, const AABB &b)
+    {
+        AABB box = a;
+        box.extend(b);
+        return box;
+    }
+
+    // -1 outside, 0 crossing, 1 inside every plane
+    static int classify(const Frustum &frustum, const AABB &box)
+    {
+        glm::vec3 c = box.center(), e = box.extent();
+        int result = 1;
+        for (int i = 0; i < 6; i++) {
+            glm::vec3 n = glm::vec3(frustum.planes[i]);
+            float reach = std::fabs(n.x) * e.x + std::fabs(n.y) * e.y + std::fabs(n.z) * e.z;
+            float distance = glm::dot(n, c) + frustum.planes[i].w;
+            if (distance < -reach) return -1;
+            if (distance < reach) result = 0;
+        }
+        return result;
+    }
+
+    static float distanceSquared(const AABB &box, const glm::vec3 &point)
+    {
+        glm::vec3 d = glm::max(glm::max(box.min - point, point - box.max), glm::vec3(0.0f));
+        return glm::dot(d, d);
+    }
+
+    static glm::vec3 inverseDirection(const glm::vec3 &direction)
+    {
+        return glm::vec3(direction.x != 0.0f ? 1.0f / direction.x : FLT_MAX,
+                         direction.y != 0.0f ? 1.0f / direction.y : FLT_MAX,
+                         direction.z != 0.0f ? 1.0f / direction.z : FLT_MAX);
+    }
+
+    // slab test; entry is where the ray enters the box (0 when it starts inside)
+    static bool rayHitsBox(const AABB &box, const glm::vec3 &origin, const glm::vec3 &inverse, float maxDistance, float &entry)
+    {
+        glm::vec3 t0 = (box.min - origin) * inverse;
+        glm::vec3 t1 = (box.max - origin) * inverse;
+        glm::vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+        float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+        entry = enter;
+        return enter <= exit;
+    }
+};
+
+#endif
@@ -0,0 +1,339 @@
+// constexpr_mesh.h
+//
+// Compile-time versions of the procedural primitives in procedural.h, for shapes whose
+// parameters are all known when compiling. The vertex and index arrays are built by constexpr
+// functions and stored as `static constexpr` data, so they live in read-only memory and cost
+// nothing at run time:
+//
+//     StaticBucket<12, 6>::data.positions     // 108 vertices of a unit bucket
+//     StaticPyramid<>::data.normals           // unit pyramid
+//     StaticCube<>::data.indices              // unit cube, 24 vertices and 36 indices
+//
+// Float parameters cannot be template arguments, so they come from a shape type with
+// static constexpr members (see UnitBucketShape / UnitPyramidShape / UnitCubeShape).
+// static_primitive.h uploads such data once and draws it without any per-instance memory.
+
+#ifndef CONSTEXPR_MESH_H
+#define CONSTEXPR_MESH_H
+
+// -----------------------------------------------------------------------------
+// constexpr math (std::sin / std::sqrt are not constexpr)
+// -----------------------------------------------------------------------------
+
+constexpr double CT_PI = 3.14159265358979323846;
+
+constexpr double ctSin(double x)
+{
+    while (x > CT_PI) x -= 2.0 * CT_PI;
+    while (x < -CT_PI) x += 2.0 * CT_PI;
+    double term = x, sum = x;
+    for (int i = 1; i < 10; i++) {
+        term *= -x * x / ((2 * i) * (2 * i + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double ctCos(double x)
+{
+    return ctSin(x + CT_PI * 0.5);
+}
+
+constexpr double ctSqrt(double v)
+{
+    if (v <= 0.0) return 0.0;
+    double r = v > 1.0 ? v : 1.0;
+    for (int i = 0; i < 64; i++) {
+        double next = 0.5 * (r + v / r);
+        if (next == r) break;
+        r = next;
+    }
+    return r;
+}
+
+struct CtVec3
+{
+    float x, y, z;
+};
+
+constexpr CtVec3 ctSub(CtVec3 a, CtVec3 b) { return CtVec3{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+constexpr float ctDot(CtVec3 a, CtVec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+constexpr CtVec3 ctCross(CtVec3 a, CtVec3 b) { return CtVec3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+constexpr CtVec3 ctNormalize(CtVec3 v)
+{
+    float length = (float)ctSqrt(ctDot(v, v));
+    return length > 0.0f ? CtVec3{ v.x / length, v.y / length, v.z / length } : v;
+}
+
+// normal of triangle abc scaled by twice its area, oriented away from the origin
+constexpr CtVec3 ctOutwardCross(CtVec3 a, CtVec3 b, CtVec3 c)
+{
+    CtVec3 n = ctCross(ctSub(b, a), ctSub(c, a));
+    return ctDot(n, a) < 0.0f ? CtVec3{ -n.x, -n.y, -n.z } : n;
+}
+
+// unit normal of triangle abc, oriented away from the origin (same as outwardNormal in procedural.h)
+constexpr CtVec3 ctOutwardNormal(CtVec3 a, CtVec3 b, CtVec3 c)
+{
+    return ctNormalize(ctOutwardCross(a, b, c));
+}
+
+// -----------------------------------------------------------------------------
+// Fixed-size mesh storage, filled like a procedural.h sink
+// -----------------------------------------------------------------------------
+
+template <int VERTICES, int INDICES>
+struct ConstexprMesh
+{
+    static const int vertexCount = VERTICES;
+    static const int indexCount = INDICES;
+
+    float positions[VERTICES * 3];
+    float normals[VERTICES * 3];
+    float texcoords[VERTICES * 2];
+    unsigned int indices[INDICES > 0 ? INDICES : 1];
+    int written;
+
+    constexpr ConstexprMesh() : positions(), normals(), texcoords(), indices(), written(0) { }
+
+    constexpr void vertex(CtVec3 p, CtVec3 n, float u, float v)
+    {
+        positions[written * 3] = p.x; positions[written * 3 + 1] = p.y; positions[written * 3 + 2] = p.z;
+        normals[written * 3] = n.x; normals[written * 3 + 1] = n.y; normals[written * 3 + 2] = n.z;
+        texcoords[written * 2] = u; texcoords[written * 2 + 1] = v;
+        written++;
+    }
+
+    // flat: all three vertices get the face normal (smoothNormals() can average them afterwards)
+    constexpr void triangle(CtVec3 a, CtVec3 b, CtVec3 c,
+                            float ua, float va, float ub, float vb, float uc, float vc)
+    {
+        CtVec3 n = ctOutwardNormal(a, b, c);
+        vertex(a, n, ua, va);
+        vertex(b, n, ub, vb);
+        vertex(c, n, uc, vc);
+    }
+
+    constexpr CtVec3 position(int i) const
+    {
+        return CtVec3{ positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2] };
+    }
+
+    // Smooth normals the way generateBucket makes them (HalfEdgeMesh::cornerNormals): every vertex
+    // of triangles [first, end) gets the normalized area-weighted sum of the faces in that range
+    // sharing its position. Triangles outside the range (another smoothing group) keep theirs.
+    constexpr void smoothNormals(int first, int end)
+    {
+        CtVec3 faces[VERTICES / 3] = {};
+        for (int t = first; t < end; t++) faces[t] = ctOutwardCross(position(t * 3), position(t * 3 + 1), position(t * 3 + 2));
+        CtVec3 smooth[VERTICES] = {};
+        for (int v = first * 3; v < end * 3; v++) {
+            CtVec3 p = position(v), sum = { 0.0f, 0.0f, 0.0f };
+            for (int t = first; t < end; t++) {
+                bool around = false;
+                for (int k = 0; k < 3; k++) {
+                    CtVec3 q = position(t * 3 + k);
+                    around = around || (q.x == p.x && q.y == p.y && q.z == p.z);
+                }
+                if (around) sum = CtVec3{ sum.x + faces[t].x, sum.y + faces[t].y, sum.z + faces[t].z };
+            }
+            smooth[v] = ctDot(sum, sum) > 0.0f ? ctNormalize(sum) : ctNormalize(faces[v / 3]);
+        }
+        for (int v = first * 3; v < end * 3; v++) {
+            normals[v * 3] = smooth[v].x; normals[v * 3 + 1] = smooth[v].y; normals[v * 3 + 2] = smooth[v].z;
+        }
+    }
+};
+
+// -----------------------------------------------------------------------------
+// Bucket (see generateBucket in procedural.h)
+// -----------------------------------------------------------------------------
+
+struct UnitBucketShape
+{
+    static constexpr float topRadius = 1.0f, bottomRadius = 1.0f;
+    static constexpr float topRatio = 1.0f, bottomRatio = 1.0f;
+    static constexpr float height = 1.0f;
+    static constexpr bool flatNormals = true;
+};
+
+template <int TOP_N, int BOTTOM_N, typename Shape>
+struct BucketCounts
+{
+    static_assert(BOTTOM_N >= 3 && TOP_N >= BOTTOM_N && TOP_N % BOTTOM_N == 0,
+                  "TOP_N should be BOTTOM_N * some natural number, and BOTTOM_N at least 3");
+    static const int RATIO = TOP_N / BOTTOM_N;
+    static const int TRIANGLES = TOP_N + BOTTOM_N + BOTTOM_N * (RATIO + 1);
+    typedef ConstexprMesh<TRIANGLES * 3, 0> Data;
+};
+
+template <int TOP_N, int BOTTOM_N, typename Shape>
+constexpr typename BucketCounts<TOP_N, BOTTOM_N, Shape>::Data buildStaticBucket()
+{
+    typedef BucketCounts<TOP_N, BOTTOM_N, Shape> Counts;
+    typename Counts::Data mesh;
+    const int ratio = Counts::RATIO;
+    const float yTop = Shape::height * 0.5f, yBottom = -Shape::height * 0.5f;
+
+    // sin/cos of every rim vertex, computed once
+    double topSin[TOP_N] = {}, topCos[TOP_N] = {}, bottomSin[BOTTOM_N] = {}, bottomCos[BOTTOM_N] = {};
+    for (int i = 0; i < TOP_N; i++) {
+        topSin[i] = ctSin(2.0 * CT_PI * i / TOP_N);
+        topCos[i] = ctCos(2.0 * CT_PI * i / TOP_N);
+    }
+    for (int i = 0; i < BOTTOM_N; i++) {
+        bottomSin[i] = ctSin(2.0 * CT_PI * i / BOTTOM_N);
+        bottomCos[i] = ctCos(2.0 * CT_PI * i / BOTTOM_N);
+    }
+    CtVec3 topRim[TOP_N] = {}, bottomRim[BOTTOM_N] = {};
+    for (int i = 0; i < TOP_N; i++)
+        topRim[i] = CtVec3{ (float)(topSin[i] * Shape::topRadius), yTop, (float)(topCos[i] * Shape::topRadius * Shape::topRatio) };
+    for (int i = 0; i < BOTTOM_N; i++)
+        bottomRim[i] = CtVec3{ (float)(bottomSin[i] * Shape::bottomRadius), yBottom, (float)(bottomCos[i] * Shape::bottomRadius * Shape::bottomRatio) };
+
+    // top and bottom polygons
+    for (int i = 0; i < TOP_N; i++) {
+        int j = (i + 1) % TOP_N;
+        mesh.triangle(topRim[i], topRim[j], CtVec3{ 0.0f, yTop, 0.0f },
+                      (float)(topSin[i] + 1) * 0.5f, (float)(topCos[i] + 1) * 0.5f,
+                      (float)(topSin[j] + 1) * 0.5f, (float)(topCos[j] + 1) * 0.5f, 0.5f, 0.5f);
+    }
+    for (int i = 0; i < BOTTOM_N; i++) {
+        int j = (i + 1) % BOTTOM_N;
+        mesh.triangle(bottomRim[i], bottomRim[j], CtVec3{ 0.0f, yBottom, 0.0f },
+                      (float)(bottomSin[i] + 1) * 0.5f, (float)(bottomCos[i] + 1) * 0.5f,
+                      (float)(bottomSin[j] + 1) * 0.5f, (float)(bottomCos[j] + 1) * 0.5f, 0.5f, 0.5f);
+    }
+
+    // sides: the top rim starts `middle` edges before the first bottom vertex
+    const int middle = ratio / 2;
+    int top = 0;
+    for (int bottom = 0; bottom < BOTTOM_N; bottom++) {
+        CtVec3 b1 = bottomRim[bottom], b2 = bottomRim[(bottom + 1) % BOTTOM_N];
+        float u1 = (float)bottom / BOTTOM_N, u2 = (float)(bottom + 1) / BOTTOM_N;
+        for (; top <= middle + bottom * ratio; top++) {
+            mesh.triangle(topRim[(top - middle + TOP_N) % TOP_N], topRim[(top + 1 - middle + TOP_N) % TOP_N], b1,
+                          (float)top / TOP_N, 1.0f, (float)(top + 1) / TOP_N, 1.0f, u1, 0.0f);
+        }
+        mesh.triangle(topRim[(top - middle + TOP_N) % TOP_N], b1, b2,
+                      (float)top / TOP_N, 1.0f, u1, 0.0f, u2, 0.0f);
+        for (; top < ratio + bottom * ratio; top++) {
+            mesh.triangle(topRim[(top - middle + TOP_N) % TOP_N], topRim[(top + 1 - middle + TOP_N) % TOP_N], b2,
+                          (float)top / TOP_N, 1.0f, (float)(top + 1) / TOP_N, 1.0f, u2, 0.0f);
+        }
+    }
+
+    // smooth sides; each cap is flat, its own smoothing group (bucketFaceGroups in procedural.h)
+    if (!Shape::flatNormals) mesh.smoothNormals(TOP_N + BOTTOM_N, Counts::TRIANGLES);
+    return mesh;
+}
+
+template <int TOP_N, int BOTTOM_N, typename Shape = UnitBucketShape>
+struct StaticBucket
+{
+    typedef typename BucketCounts<TOP_N, BOTTOM_N, Shape>::Data Data;
+    static const int TRIANGLES = BucketCounts<TOP_N, BOTTOM_N, Shape>::TRIANGLES;
+    static constexpr Data data = buildStaticBucket<TOP_N, BOTTOM_N, Shape>();
+};
+
+template <int TOP_N, int BOTTOM_N, typename Shape>
+constexpr typename StaticBucket<TOP_N, BOTTOM_N, Shape>::Data StaticBucket<TOP_N, BOTTOM_N, Shape>::data;
+
+// -----------------------------------------------------------------------------
+// Pyramid (see generatePyramid in procedural.h)
+// -----------------------------------------------------------------------------
+
+struct UnitPyramidShape
+{
+    static constexpr float bottomLine = 1.0f;
+    static constexpr float height = 1.0f;
+};
+
+template <typename Shape>
+constexpr ConstexprMesh<18, 0> buildStaticPyramid()
+{
+    ConstexprMesh<18, 0> mesh;
+    const float corner[4][2] = { { -1.0f, -1.0f }, { +1.0f, -1.0f }, { +1.0f, +1.0f }, { -1.0f, +1.0f } };
+    const float cornerUV[4][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+    const float half = Shape::bottomLine * 0.5f, top = Shape::height * 0.5f;
+
+    for (int side = 0; side < 4; side++) {
+        int next = (side + 1) % 4;
+        mesh.triangle(CtVec3{ 0.0f, top, 0.0f },
+                      CtVec3{ corner[side][0] * half, -top, corner[side][1] * half },
+                      CtVec3{ corner[next][0] * half, -top, corner[next][1] * half },
+                      0.5f, 0.5f, cornerUV[side][0], cornerUV[side][1], cornerUV[next][0], cornerUV[next][1]);
+    }
+    const CtVec3 down = { 0.0f, -1.0f, 0.0f };
+    mesh.vertex(CtVec3{ -half, -top, -half }, down, 0.0f, 0.0f);
+    mesh.vertex(CtVec3{ half, -top, -half }, down, 1.0f, 0.0f);
+    mesh.vertex(CtVec3{ half, -top, half }, down, 1.0f, 1.0f);
+    mesh.vertex(CtVec3{ -half, -top, -half }, down, 0.0f, 0.0f);
+    mesh.vertex(CtVec3{ -half, -top, half }, down, 0.0f, 1.0f);
+    mesh.vertex(CtVec3{ half, -top, half }, down, 1.0f, 1.0f);
+    return mesh;
+}
+
+template <typename Shape = UnitPyramidShape>
+struct StaticPyramid
+{
+    typedef ConstexprMesh<18, 0> Data;
+    static constexpr Data data = buildStaticPyramid<Shape>();
+};
+
+template <typename Shape>
+constexpr ConstexprMesh<18, 0> StaticPyramid<Shape>::data;
+
+// -----------------------------------------------------------------------------
+// Unit cube (see generateCube in procedural.h and cube.h)
+// -----------------------------------------------------------------------------
+
+struct UnitCubeShape
+{
+    static constexpr float size = 1.0f;
+};
+
+template <typename Shape>
+constexpr ConstexprMesh<24, 36> buildStaticCube()
+{
+    ConstexprMesh<24, 36> mesh;
+    const float positions[72] = {
+        .5f, .5f, .5f,  -.5f, .5f, .5f,  -.5f,-.5f, .5f,  .5f,-.5f, .5f, // v0,v1,v2,v3 (front)
+        .5f, .5f, .5f,   .5f,-.5f, .5f,   .5f,-.5f,-.5f,  .5f, .5f,-.5f, // v0,v3,v4,v5 (right)
+        .5f, .5f, .5f,   .5f, .5f,-.5f,  -.5f, .5f,-.5f, -.5f, .5f, .5f, // v0,v5,v6,v1 (top)
+        -.5f, .5f, .5f,  -.5f, .5f,-.5f,  -.5f,-.5f,-.5f, -.5f,-.5f, .5f, // v1,v6,v7,v2 (left)
+        -.5f,-.5f,-.5f,   .5f,-.5f,-.5f,   .5f,-.5f, .5f, -.5f,-.5f, .5f, // v7,v4,v3,v2 (bottom)
+        .5f,-.5f,-.5f,  -.5f,-.5f,-.5f,  -.5f, .5f,-.5f,  .5f, .5f,-.5f  // v4,v7,v6,v5 (back)
+    };
+    const float normals[18] = { 0, 0, 1,   1, 0, 0,   0, 1, 0,   -1, 0, 0,   0,-1, 0,   0, 0,-1 };
+    const float texcoords[48] = {
+        1, 0,   0, 0,   0, 1,   1, 1,   0, 0,   0, 1,   1, 1,   1, 0,
+        1, 1,   1, 0,   0, 0,   0, 1,   1, 0,   0, 0,   0, 1,   1, 1,
+        0, 1,   1, 1,   1, 0,   0, 0,   0, 1,   1, 1,   1, 0,   0, 0
+    };
+    const float s = Shape::size;
+    for (int i = 0; i < 24; i++) {
+        mesh.vertex(CtVec3{ positions[i * 3] * s, positions[i * 3 + 1] * s, positions[i * 3 + 2] * s },
+                    CtVec3{ normals[(i / 4) * 3], normals[(i / 4) * 3 + 1], normals[(i / 4) * 3 + 2] },
+                    texcoords[i * 2], texcoords[i * 2 + 1]);
+    }
+    for (int side = 0; side < 6; side++) {
+        unsigned int base = side * 4;
+        mesh.indices[side * 6] = base;         mesh.indices[side * 6 + 1] = base + 1; mesh.indices[side * 6 + 2] = base + 2;
+        mesh.indices[side * 6 + 3] = base + 2; mesh.indices[side * 6 + 4] = base + 3; mesh.indices[side * 6 + 5] = base;
+    }
+    return mesh;
+}
+
+template <typename Shape = UnitCubeShape>
+struct StaticCube
+{
+    typedef ConstexprMesh<24, 36> Data;
+    static constexpr Data data = buildStaticCube<Shape>();
+};
+
+template <typename Shape>
+constexpr ConstexprMesh<24, 36> StaticCube<Shape>::data;
+
+#endif
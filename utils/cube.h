@@ -18,69 +18,41 @@
 #define CUBE_H
 
 #include "shader.h"
+#include "geometry_cache.h"
+#include "procedural.h"
+#include "vertex_layout.h"
+#include "instance_buffer.h"
+#include "draw_stats.h"
+#include "bounds.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
 class Cube {
 public:
     
-    // vertex position array
-    GLfloat cubeVertices[72]  = { // initialized as size = 1 for each dimension, 72 elements
-        .5f, .5f, .5f,  -.5f, .5f, .5f,  -.5f,-.5f, .5f,  .5f,-.5f, .5f, // v0,v1,v2,v3 (front)
-        .5f, .5f, .5f,   .5f,-.5f, .5f,   .5f,-.5f,-.5f,  .5f, .5f,-.5f, // v0,v3,v4,v5 (right)
-        .5f, .5f, .5f,   .5f, .5f,-.5f,  -.5f, .5f,-.5f, -.5f, .5f, .5f, // v0,v5,v6,v1 (top)
-        -.5f, .5f, .5f,  -.5f, .5f,-.5f,  -.5f,-.5f,-.5f, -.5f,-.5f, .5f, // v1,v6,v7,v2 (left)
-        -.5f,-.5f,-.5f,   .5f,-.5f,-.5f,   .5f,-.5f, .5f, -.5f,-.5f, .5f, // v7,v4,v3,v2 (bottom)
-        .5f,-.5f,-.5f,  -.5f,-.5f,-.5f,  -.5f, .5f,-.5f,  .5f, .5f,-.5f  // v4,v7,v6,v5 (back)
-    };
-    
-    // normal array
-    GLfloat cubeNormals[72] = {  // 72 elements
-        0, 0, 1,   0, 0, 1,   0, 0, 1,   0, 0, 1,  // v0,v1,v2,v3 (front)
-        1, 0, 0,   1, 0, 0,   1, 0, 0,   1, 0, 0,  // v0,v3,v4,v5 (right)
-        0, 1, 0,   0, 1, 0,   0, 1, 0,   0, 1, 0,  // v0,v5,v6,v1 (top)
-        -1, 0, 0,  -1, 0, 0,  -1, 0, 0,  -1, 0, 0,  // v1,v6,v7,v2 (left)
-        0,-1, 0,   0,-1, 0,   0,-1, 0,   0,-1, 0,  // v7,v4,v3,v2 (bottom)
-        0, 0,-1,   0, 0,-1,   0, 0,-1,   0, 0,-1   // v4,v7,v6,v5 (back)
-    };
+    // colour array: initialized as RGBA sollid color for each face, 96 elements
+    // (positions, normals, texture coords and indices come from generateCube() in procedural.h)
+    static const GLfloat *cubeColors() {
+        static const GLfloat colors[96] = {
+            1, 0, 0, 1,   1, 0, 0, 1,   1, 0, 0, 1,   1, 0, 0, 1, // v0,v1,v2,v3 (front)
+            1, 1, 0, 1,   1, 1, 0, 1,   1, 1, 0, 1,   1, 1, 0, 1, // v0,v3,v4,v5 (right)
+            0, 1, 0, 1,   0, 1, 0, 1,   0, 1, 0, 1,   0, 1, 0, 1, // v0,v5,v6,v1 (top)
+            0, 1, 1, 1,   0, 1, 1, 1,   0, 1, 1, 1,   0, 1, 1, 1, // v1,v6,v7,v2 (left)
+            0, 0, 1, 1,   0, 0, 1, 1,   0, 0, 1, 1,   0, 0, 1, 1, // v7,v4,v3,v2 (bottom)
+            1, 0, 1, 1,   1, 0, 1, 1,   1, 0, 1, 1,   1, 0, 1, 1  // v4,v7,v6,v5 (back)
+        };
+        return colors;
+    }
     
-    // colour array
-    GLfloat cubeColors[96] = { // initialized as RGBA sollid color for each face, 96 elements
-        1, 0, 0, 1,   1, 0, 0, 1,   1, 0, 0, 1,   1, 0, 0, 1, // v0,v1,v2,v3 (front)
-        1, 1, 0, 1,   1, 1, 0, 1,   1, 1, 0, 1,   1, 1, 0, 1, // v0,v3,v4,v5 (right)
-        0, 1, 0, 1,   0, 1, 0, 1,   0, 1, 0, 1,   0, 1, 0, 1, // v0,v5,v6,v1 (top)
-        0, 1, 1, 1,   0, 1, 1, 1,   0, 1, 1, 1,   0, 1, 1, 1, // v1,v6,v7,v2 (left)
-        0, 0, 1, 1,   0, 0, 1, 1,   0, 0, 1, 1,   0, 0, 1, 1, // v7,v4,v3,v2 (bottom)
-        1, 0, 1, 1,   1, 0, 1, 1,   1, 0, 1, 1,   1, 0, 1, 1  // v4,v7,v6,v5 (back)
-    };
+    // vertex format of the cube (see vertex_layout.h)
+    typedef PackedVertex Layout;
     
-    // texture coord array
-    GLfloat cubeTexCoords[48] = { // 48 elements
-        1, 0,   0, 0,   0, 1,   1, 1,               // v0,v1,v2,v3 (front)
-        0, 0,   0, 1,   1, 1,   1, 0,               // v0,v3,v4,v5 (right)
-        1, 1,   1, 0,   0, 0,   0, 1,               // v0,v5,v6,v1 (top)
-        1, 0,   0, 0,   0, 1,   1, 1,               // v1,v6,v7,v2 (left)
-        0, 1,   1, 1,   1, 0,   0, 0,               // v7,v4,v3,v2 (bottom)
-        0, 1,   1, 1,   1, 0,   0, 0                // v4,v7,v6,v5 (back)
-    };
+    // VAO, VBO (VBO[0]) and EBO of the unit cube, one immutable set shared by every Cube
+    GeometryBuffers *buffers;
     
-    // index array for glDrawElements()
-    // A cube requires 36 indices = 6 sides * 2 tris * 3 verts
-    GLuint cubeIndices[36] = { // 36 elements
-        0, 1, 2,   2, 3, 0,    // v0-v1-v2, v2-v3-v0 (front)
-        4, 5, 6,   6, 7, 4,    // v0-v3-v4, v4-v5-v0 (right)
-        8, 9,10,  10,11, 8,    // v0-v5-v6, v6-v1-v0 (top)
-        12,13,14,  14,15,12,    // v1-v6-v7, v7-v2-v1 (left)
-        16,17,18,  18,19,16,    // v7-v4-v3, v3-v2-v7 (bottom)
-        20,21,22,  22,23,20     // v4-v7-v6, v6-v5-v4 (back)
-    };
-
-    unsigned int VAO;
-    unsigned int VBO;
-    unsigned int EBO;
-    
-    unsigned int vSize = sizeof(cubeVertices);
-    unsigned int nSize = sizeof(cubeNormals);
-    unsigned int cSize = sizeof(cubeColors);
-    unsigned int tSize = sizeof(cubeTexCoords);
+    // placement of this cube, applied as a model matrix instead of rewriting the vertices
+    glm::mat4 transform = glm::mat4(1.0f);
     
     Cube() {
         initBuffers();
@@ -92,58 +64,103 @@ public:
         initBuffers();
     };
     
+    ~Cube() {
+        GeometryCache::instance().release(buffers);
+    };
+    
     void initBuffers() {
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
+        buffers = GeometryCache::instance().acquire(GeometryKey("cube", {}), [this](GeometryBuffers &b) { uploadBuffers(b); });
+    };
+    
+    void uploadBuffers(GeometryBuffers &b) {
+        GLfloat cubeVertices[72], cubeNormals[72], cubeTexCoords[48];
+        GLuint cubeIndices[36];
+        ArraySink mesh(cubeVertices, cubeNormals, cubeTexCoords, 24, cubeIndices, 36);
+        generateCube(CubeShape(), mesh);
+        b.count = mesh.indexCount;
+        
+        // interleave into the cube's vertex format
+        Layout::Vertex vertices[24];
+        for (int i = 0; i < 24; i++) {
+            Layout::write(vertices[i], VertexInput(glm::make_vec3(&cubeVertices[i * 3]), glm::make_vec3(&cubeNormals[i * 3]),
+                                                   glm::make_vec4(&cubeColors()[i * 4]), glm::make_vec2(&cubeTexCoords[i * 2])));
+        }
         
-        glBindVertexArray(VAO);
+        glGenVertexArrays(1, &b.VAO);
+        glGenBuffers(1, &b.VBO[0]);
+        glGenBuffers(1, &b.EBO);
         
-        // copy vertex attrib data to VBO
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vSize+nSize+cSize+tSize, 0, GL_STATIC_DRAW); // reserve space
-        glBufferSubData(GL_ARRAY_BUFFER, 0, vSize, cubeVertices);                  // copy verts at offset 0
-        glBufferSubData(GL_ARRAY_BUFFER, vSize, nSize, cubeNormals);               // copy norms after verts
-        glBufferSubData(GL_ARRAY_BUFFER, vSize+nSize, cSize, cubeColors);          // copy cols after norms
-        glBufferSubData(GL_ARRAY_BUFFER, vSize+nSize+cSize, tSize, cubeTexCoords); // copy texs after cols
+        glBindVertexArray(b.VAO);
+        
+        // copy vertex data to VBO
+        glBindBuffer(GL_ARRAY_BUFFER, b.VBO[0]);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
         
         // copy index data to EBO
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, b.EBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cubeIndices), cubeIndices, GL_STATIC_DRAW);
         
         // attribute position initialization
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0);  // position attrib
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)vSize); // normal attrib
-        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(vSize+nSize)); //color attrib
-        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)(vSize+nSize+cSize)); // tex coord
-        glEnableVertexAttribArray(0);
-        glEnableVertexAttribArray(1);
-        glEnableVertexAttribArray(2);
-        glEnableVertexAttribArray(3);
+        Layout::setup();
         
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
     };
     
-    void draw(Shader *shader) {
+    // draws with "model" = parent * transform; pass the matrix that would otherwise have been set
+    // as "model" (a draw(shader) that kept the caller's "model" would have to read it back from GL)
+    void draw(Shader *shader, const glm::mat4 &parent) {
         shader->use();
-        glBindVertexArray(VAO);
+        shader->setMat4("model", parent * transform);
+        glBindVertexArray(buffers->VAO);
         glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
         glBindVertexArray(0);
+        drawStats().add(1, 12);
     };
     
-    void translate(float dx, float dy, float dz) {
-        for (int i = 0; i < 72; i++) {
-            if (i % 3 == 0) cubeVertices[i] += dx;
-            else if (i % 3 == 1) cubeVertices[i] += dy;
-            else if (i % 3 == 2) cubeVertices[i] += dz;
+    // draws the shared mesh once per model matrix: one VAO bind and one uniform lookup
+    // for the whole batch, and no buffers per cube
+    void drawMany(Shader *shader, const glm::mat4 *models, int count) {
+        shader->use();
+        int modelLoc = shader->getUniformLocation("model");
+        glBindVertexArray(buffers->VAO);
+        for (int i = 0; i < count; i++) {
+            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, &models[i][0][0]);
+            glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
+            drawStats().add(1, 12);
         }
+        glBindVertexArray(0);
+    };
+    
+    // every instance in one draw call (shader: instanced.vs); the transform is applied inside
+    // each instance, before the instance's model matrix
+    void drawInstanced(Shader *shader, const InstanceBuffer &instances) {
+        shader->use();
+        shader->setMat4("model", transform);
+        instances.drawElements(buffers->VAO, 36);
+    };
+    
+    // bounds of the shared unit cube, before the transform (world: getBounds().transformed(parent * transform))
+    AABB getBounds() const {
+        return AABB(glm::vec3(-0.5f), glm::vec3(0.5f));
+    };
+    
+    BoundingSphere getBoundingSphere() const {
+        return BoundingSphere::fromAABB(getBounds());
+    };
+    
+    // translate/scale change the transform, in world space like the old vertex rewriting
+    void translate(float dx, float dy, float dz) {
+        transform = glm::translate(glm::mat4(1.0f), glm::vec3(dx, dy, dz)) * transform;
     };
     
     void scale(float s) {
-        for (int i = 0; i < 72; i++)
-            cubeVertices[i] *= s;
+        transform = glm::scale(glm::mat4(1.0f), glm::vec3(s)) * transform;
     };
+    
+private:
+    Cube(const Cube &);
+    Cube &operator=(const Cube &);
 };
 
 
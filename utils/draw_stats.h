@@ -0,0 +1,54 @@
+// draw_stats.h
+//
+// Per-frame counters of what the drawing classes submit to GL.
+// Reset once per frame, read after the frame's draws:
+//
+//     drawStats().reset();
+//     ... draw ...
+//     std::cout << drawStats().drawCalls << " draw calls" << std::endl;
+
+#ifndef DRAW_STATS_H
+#define DRAW_STATS_H
+
+struct DrawStats
+{
+    long drawCalls;
+    long instances;     // objects drawn (1 per plain draw call, the instance count for instanced ones)
+    long triangles;
+    long cullTested;    // bounds tested by frustum culling (frustum.h)
+    long culled;        // ... and found outside
+    double cullMilliseconds;
+    long occlusionTested;   // bounds tested against the occluders (occlusion.h)
+    long occluded;          // ... and found hidden
+    double occlusionMilliseconds;   // rasterizing the occluders and testing
+
+    DrawStats() { reset(); }
+
+    void reset()
+    {
+        drawCalls = 0;
+        instances = 0;
+        triangles = 0;
+        cullTested = 0;
+        culled = 0;
+        cullMilliseconds = 0.0;
+        occlusionTested = 0;
+        occluded = 0;
+        occlusionMilliseconds = 0.0;
+    }
+
+    void add(long instanceCount, long trianglesPerInstance)
+    {
+        drawCalls++;
+        instances += instanceCount;
+        triangles += instanceCount * trianglesPerInstance;
+    }
+};
+
+inline DrawStats &drawStats()
+{
+    static DrawStats stats;
+    return stats;
+}
+
+#endif
@@ -0,0 +1,397 @@
+// ecs.h
+//
+// A small archetype entity-component system, GL independent.
+// An entity is an id; its components live in the archetype for its exact set of component
+// types, one dense array (std::vector<T>) per type, so a system walks plain arrays instead of
+// chasing object pointers. Adding or removing a component moves the entity's row to another
+// archetype.
+//
+//     World world;
+//     Entity e = world.create(Transform(), Velocity());
+//     world.add(e, WorldMatrix());
+//     world.each<Transform, Velocity>([&](Transform &t, Velocity &v) { t.position += v.linear * dt; });
+//     world.parallelEach<Transform, WorldMatrix>(4096, [](Transform &t, WorldMatrix &m) { ... });
+//
+// Components must be default constructible and copyable; at most 64 component types.
+// Do not create, destroy, add or remove while iterating: rows would move under the loop.
+
+#ifndef ECS_H
+#define ECS_H
+
+#include <cstdlib>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include "parallel.h"
+
+typedef unsigned long long ComponentMask;
+
+inline int nextComponentId()
+{
+    static int next = 0;
+    if (next >= 64) {
+        std::cout << "ECS: more than 64 component types" << std::endl;
+        exit(-1);
+    }
+    return next++;
+}
+
+// a process-wide id per component type, assigned on first use
+template <typename T>
+inline int componentId()
+{
+    static const int id = nextComponentId();
+    return id;
+}
+
+template <typename... Cs>
+struct MaskOf
+{
+    static ComponentMask get() { return 0; }
+};
+
+template <typename First, typename... Rest>
+struct MaskOf<First, Rest...>
+{
+    static ComponentMask get() { return (1ull << componentId<First>()) | MaskOf<Rest...>::get(); }
+};
+
+// the bits of the given component types
+template <typename... Cs>
+inline ComponentMask maskOf()
+{
+    return MaskOf<Cs...>::get();
+}
+
+// generation tells a destroyed entity's id apart from a later one that reuses the index
+struct Entity
+{
+    unsigned int index;
+    unsigned int generation;
+
+    Entity() : index(0xffffffffu), generation(0) { }
+    Entity(unsigned int index, unsigned int generation) : index(index), generation(generation) { }
+
+    bool operator==(const Entity &other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity &other) const { return !(*this == other); }
+};
+
+class ComponentColumn
+{
+public:
+    virtual ~ComponentColumn() { }
+    virtual ComponentColumn *emptyCopy() const = 0;
+    virtual void pushDefault() = 0;
+    virtual void pushFrom(const ComponentColumn &source, int row) = 0;
+    virtual void swapRemove(int row) = 0;
+    virtual void reserve(int count) = 0;
+};
+
+template <typename T>
+class TypedColumn : public ComponentColumn
+{
+public:
+    std::vector<T> values;
+
+    ComponentColumn *emptyCopy() const { return new TypedColumn<T>(); }
+    void pushDefault() { values.push_back(T()); }
+    void pushFrom(const ComponentColumn &source, int row) { values.push_back(static_cast<const TypedColumn<T> &>(source).values[row]); }
+    void reserve(int count) { values.reserve(count); }
+
+    void swapRemove(int row)
+    {
+        if (row != (int)values.size() - 1) values[row] = values.back();
+        values.pop_back();
+    }
+};
+
+// all entities with exactly the component types in mask
+class Archetype
+{
+public:
+    ComponentMask mask;
+    std::vector<Entity> entities;           // row -> entity
+    ComponentColumn *columns[64];           // by component id, NULL for types not in mask
+
+    explicit Archetype(ComponentMask mask) : mask(mask)
+    {
+        for (int i = 0; i < 64; i++) columns[i] = NULL;
+    }
+
+    ~Archetype()
+    {
+        for (int i = 0; i < 64; i++) delete columns[i];
+    }
+
+    int size() const
+    {
+        return (int)entities.size();
+    }
+
+    template <typename T>
+    T *column()
+    {
+        std::vector<T> &values = static_cast<TypedColumn<T> *>(columns[componentId<T>()])->values;
+        return values.empty() ? NULL : &values[0];
+    }
+
+    void reserve(int count)
+    {
+        entities.reserve(count);
+        for (int i = 0; i < 64; i++) if (columns[i] != NULL) columns[i]->reserve(count);
+    }
+
+    // removes row by moving the last row into it; returns the entity that now sits at row
+    // (an invalid Entity if row was the last one)
+    Entity swapRemove(int row)
+    {
+        for (int i = 0; i < 64; i++) if (columns[i] != NULL) columns[i]->swapRemove(row);
+        Entity moved;
+        if (row != size() - 1) {
+            entities[row] = entities.back();
+            moved = entities[row];
+        }
+        entities.pop_back();
+        return moved;
+    }
+
+private:
+    Archetype(const Archetype &);
+    Archetype &operator=(const Archetype &);
+};
+
+class World
+{
+public:
+    World() { }
+
+    ~World()
+    {
+        for (size_t i = 0; i < archetypes.size(); i++) delete archetypes[i];
+    }
+
+    template <typename... Cs>
+    Entity create(const Cs &... values)
+    {
+        ComponentMask mask = maskOf<Cs...>();
+        Archetype *archetype = findArchetype(mask);
+        if (archetype == NULL) {
+            archetype = newArchetype(mask);
+            int unused[] = { 0, (archetype->columns[componentId<Cs>()] = new TypedColumn<Cs>(), 0)... };
+            (void)unused;
+        }
+        Entity entity = allocate();
+        int row = archetype->size();
+        archetype->entities.push_back(entity);
+        int unused[] = { 0, (static_cast<TypedColumn<Cs> *>(archetype->columns[componentId<Cs>()])->values.push_back(values), 0)... };
+        (void)unused;
+        records[entity.index].archetype = archetype;
+        records[entity.index].row = row;
+        return entity;
+    }
+
+    void destroy(Entity entity)
+    {
+        if (!isAlive(entity)) return;
+        Record &record = records[entity.index];
+        removeRow(record.archetype, record.row);
+        record.archetype = NULL;
+        record.generation++;
+        freeIndices.push_back(entity.index);
+        living--;
+    }
+
+    bool isAlive(Entity entity) const
+    {
+        return entity.index < records.size() && records[entity.index].generation == entity.generation &&
+               records[entity.index].archetype != NULL;
+    }
+
+    template <typename T>
+    bool has(Entity entity) const
+    {
+        return isAlive(entity) && (records[entity.index].archetype->mask & maskOf<T>()) != 0;
+    }
+
+    // NULL when the entity is gone or has no T; valid until the next structural change
+    template <typename T>
+    T *get(Entity entity)
+    {
+        if (!has<T>(entity)) return NULL;
+        const Record &record = records[entity.index];
+        return &record.archetype->column<T>()[record.row];
+    }
+
+    // adds T (or overwrites it when the entity already has one)
+    template <typename T>
+    void add(Entity entity, const T &value = T())
+    {
+        if (!isAlive(entity)) return;
+        if (has<T>(entity)) {
+            *get<T>(entity) = value;
+            return;
+        }
+        Archetype *source = records[entity.index].archetype;
+        ComponentMask mask = source->mask | maskOf<T>();
+        Archetype *target = findArchetype(mask);
+        if (target == NULL) {
+            target = newArchetype(mask);
+            copyColumns(source, target);
+            target->columns[componentId<T>()] = new TypedColumn<T>();
+        }
+        moveRow(entity, target);
+        *get<T>(entity) = value;
+    }
+
+    template <typename T>
+    void remove(Entity entity)
+    {
+        if (!has<T>(entity)) return;
+        Archetype *source = records[entity.index].archetype;
+        ComponentMask mask = source->mask & ~maskOf<T>();
+        Archetype *target = findArchetype(mask);
+        if (target == NULL) {
+            target = newArchetype(mask);
+            copyColumns(source, target);
+        }
+        moveRow(entity, target);
+    }
+
+    // fn(count, entities, Cs *columns...) once per archetype that has all Cs and none of exclude
+    template <typename... Cs, typename Fn>
+    void eachChunk(Fn fn, ComponentMask exclude = 0)
+    {
+        ComponentMask required = maskOf<Cs...>();
+        for (size_t i = 0; i < archetypes.size(); i++) {
+            Archetype *archetype = archetypes[i];
+            if ((archetype->mask & required) != required || (archetype->mask & exclude) != 0 || archetype->size() == 0) continue;
+            fn(archetype->size(), &archetype->entities[0], archetype->template column<Cs>()...);
+        }
+    }
+
+    // fn(Cs &...) for every matching entity
+    template <typename... Cs, typename Fn>
+    void each(Fn fn, ComponentMask exclude = 0)
+    {
+        eachChunk<Cs...>([&](int count, const Entity *, Cs *... columns) {
+            for (int row = 0; row < count; row++) fn(columns[row]...);
+        }, exclude);
+    }
+
+    // as each(), rows of an archetype in parallel chunks of grain (fn must not touch other rows)
+    template <typename... Cs, typename Fn>
+    void parallelEach(int grain, Fn fn, ComponentMask exclude = 0)
+    {
+        eachChunk<Cs...>([&](int count, const Entity *, Cs *... columns) {
+            parallelFor(0, count, grain, [&](int begin, int end) {
+                for (int row = begin; row < end; row++) fn(columns[row]...);
+            });
+        }, exclude);
+    }
+
+    // room for count more entities of exactly Cs (avoids regrowing the columns while filling a scene)
+    template <typename... Cs>
+    void reserve(int count)
+    {
+        ComponentMask mask = maskOf<Cs...>();
+        Archetype *archetype = findArchetype(mask);
+        if (archetype == NULL) {
+            archetype = newArchetype(mask);
+            int unused[] = { 0, (archetype->columns[componentId<Cs>()] = new TypedColumn<Cs>(), 0)... };
+            (void)unused;
+        }
+        archetype->reserve(archetype->size() + count);
+        records.reserve(records.size() + count);
+    }
+
+    int entityCount() const
+    {
+        return living;
+    }
+
+    int archetypeCount() const
+    {
+        return (int)archetypes.size();
+    }
+
+private:
+    struct Record
+    {
+        Archetype *archetype;
+        int row;
+        unsigned int generation;
+    };
+
+    std::vector<Archetype *> archetypes;
+    std::unordered_map<ComponentMask, Archetype *> byMask;
+    std::vector<Record> records;            // by entity index
+    std::vector<unsigned int> freeIndices;
+    int living = 0;
+
+    World(const World &);
+    World &operator=(const World &);
+
+    Entity allocate()
+    {
+        living++;
+        if (!freeIndices.empty()) {
+            unsigned int index = freeIndices.back();
+            freeIndices.pop_back();
+            return Entity(index, records[index].generation);
+        }
+        Record record;
+        record.archetype = NULL;
+        record.row = 0;
+        record.generation = 0;
+        records.push_back(record);
+        return Entity((unsigned int)records.size() - 1, 0);
+    }
+
+    Archetype *findArchetype(ComponentMask mask) const
+    {
+        std::unordered_map<ComponentMask, Archetype *>::const_iterator found = byMask.find(mask);
+        return found == byMask.end() ? NULL : found->second;
+    }
+
+    Archetype *newArchetype(ComponentMask mask)
+    {
+        Archetype *archetype = new Archetype(mask);
+        archetypes.push_back(archetype);
+        byMask[mask] = archetype;
+        return archetype;
+    }
+
+    // empty columns in target for every type both archetypes share
+    static void copyColumns(const Archetype *source, Archetype *target)
+    {
+        for (int i = 0; i < 64; i++) {
+            if (source->columns[i] != NULL && (target->mask & (1ull << i)) != 0) target->columns[i] = source->columns[i]->emptyCopy();
+        }
+    }
+
+    void removeRow(Archetype *archetype, int row)
+    {
+        Entity moved = archetype->swapRemove(row);
+        if (moved.index != 0xffffffffu) records[moved.index].row = row;
+    }
+
+    // moves the entity's row to target; components target has and source does not get defaults
+    void moveRow(Entity entity, Archetype *target)
+    {
+        Record &record = records[entity.index];
+        Archetype *source = record.archetype;
+        int row = target->size();
+        for (int i = 0; i < 64; i++) {
+            if (target->columns[i] == NULL) continue;
+            if (source->columns[i] != NULL) target->columns[i]->pushFrom(*source->columns[i], record.row);
+            else target->columns[i]->pushDefault();
+        }
+        target->entities.push_back(entity);
+        removeRow(source, record.row);
+        record.archetype = target;
+        record.row = row;
+    }
+};
+
+#endif
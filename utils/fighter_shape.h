@@ -0,0 +1,109 @@
+// fighter_shape.h
+//
+// The fighter plane's geometry, GL independent: the generator parameters of its four bucket parts
+// (procedural.h) and where each part sits in the plane. Fighter_plane builds its Buckets and part
+// hierarchy from it, and code without a context bakes the same mesh (mesh_merge.h):
+//
+//     FighterShape shape;
+//     MergedMesh plane = shape.merge();           // parts 0 body, 1 left wing, 2 right wing, 3 gun
+//     int triangles = plane.triangleCount();
+//     AABB bounds = shape.getBounds();
+
+#ifndef FIGHTER_SHAPE_H
+#define FIGHTER_SHAPE_H
+
+#include <cmath>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "procedural.h"
+#include "mesh_merge.h"
+#include "bounds.h"
+
+struct FighterShape
+{
+    float wingLength = 3.0f, wingStart = 1.0f, wingEnd = 0.3f;  // height, top and bottom radius
+    float bodyLength = 3.0f, bodyStart = 2.0f, bodyEnd = 1.0f;
+    float gunLength = 0.5f, gunStart = 0.1f, gunEnd = 0.1f;
+
+    BucketShape wing() const
+    {
+        return part(12, 3, wingStart, wingEnd, 0.3f, 0.1f, wingLength);
+    }
+
+    BucketShape body() const
+    {
+        return part(16, 8, bodyStart, bodyEnd, 0.3f, 0.1f, bodyLength);
+    }
+
+    BucketShape gun() const
+    {
+        return part(20, 20, gunStart, gunEnd, 1.0f, 1.0f, gunLength);
+    }
+
+    // the wings lean along the body's slope
+    float wingRadian() const
+    {
+        return std::atan(bodyLength / (bodyStart - bodyEnd));
+    }
+
+    // part placements relative to the plane (the body is at the plane's origin)
+    glm::mat4 leftWingOffset() const
+    {
+        glm::mat4 offset = glm::translate(glm::mat4(1.0f), glm::vec3((bodyStart + bodyEnd) * 0.5f, 0.0f, 0.0f));
+        return glm::rotate(offset, wingRadian(), glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+
+    glm::mat4 rightWingOffset() const
+    {
+        glm::mat4 offset = glm::translate(glm::mat4(1.0f), glm::vec3(-(bodyStart + bodyEnd) * 0.5f, 0.0f, 0.0f));
+        return glm::rotate(offset, -wingRadian(), glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+
+    glm::mat4 gunOffset() const
+    {
+        return glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -bodyLength * 0.5f, 0.0f));
+    }
+
+    // every part pre-transformed into one mesh; part ids: 0 body, 1 left wing, 2 right wing, 3 gun
+    MergedMesh merge() const
+    {
+        MergedMesh merged;
+        addPart(merged, body(), glm::mat4(1.0f));
+        addPart(merged, wing(), leftWingOffset());
+        addPart(merged, wing(), rightWingOffset());
+        addPart(merged, gun(), gunOffset());
+        return merged;
+    }
+
+    // model-space bounds of the merged mesh
+    AABB getBounds() const
+    {
+        MergedMesh merged = merge();
+        AABB bounds;
+        for (int i = 0; i < merged.vertexCount(); i++) bounds.extend(merged.positions[i]);
+        return bounds;
+    }
+
+private:
+    static BucketShape part(int topN, int bottomN, float topRadius, float bottomRadius, float topRatio, float bottomRatio, float height)
+    {
+        BucketShape shape;
+        shape.topN = topN; shape.bottomN = bottomN;
+        shape.topRadius = topRadius; shape.bottomRadius = bottomRadius;
+        shape.topRatio = topRatio; shape.bottomRatio = bottomRatio;
+        shape.height = height;
+        shape.flatNormals = false;
+        return shape;
+    }
+
+    static void addPart(MergedMesh &merged, const BucketShape &shape, const glm::mat4 &offset)
+    {
+        VectorSink mesh;
+        generateBucket(shape, mesh);
+        merged.addPart(mesh, offset);
+    }
+};
+
+#endif
@@ -0,0 +1,214 @@
+// frustum.h
+//
+// View frustum culling against bounding spheres (bounds.h), GL independent.
+// The six planes come straight from projection * view; a FrustumCuller keeps the world-space
+// spheres of a scene as separate x / y / z / radius arrays and tests them in batches: chunks in
+// parallel (parallel.h), 4 spheres per SSE instruction inside a chunk where available.
+//
+//     FrustumCuller culler;
+//     for (...) culler.add(object->getBoundingSphere().transformed(model));
+//     culler.cull(projection * view);
+//     for (int i = 0; i < culler.size(); i++) if (culler.isVisible(i)) draw object i;
+//
+// Each cull() records the tested / culled counts and its time in drawStats() (draw_stats.h).
+
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+#include "draw_stats.h"
+#include "parallel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_SSE 1
+#include <emmintrin.h>
+#endif
+
+struct Frustum
+{
+    // left, right, bottom, top, near, far: dot(plane.xyz, p) + plane.w >= 0 inside, xyz unit length
+    glm::vec4 planes[6];
+
+    // the planes of clip space pulled back through a projection * view (* model) matrix
+    static Frustum fromMatrix(const glm::mat4 &m)
+    {
+        Frustum frustum;
+        glm::vec4 row[4];
+        for (int i = 0; i < 4; i++) row[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+        frustum.planes[0] = row[3] + row[0];
+        frustum.planes[1] = row[3] - row[0];
+        frustum.planes[2] = row[3] + row[1];
+        frustum.planes[3] = row[3] - row[1];
+        frustum.planes[4] = row[3] + row[2];
+        frustum.planes[5] = row[3] - row[2];
+        for (int i = 0; i < 6; i++) frustum.planes[i] /= glm::length(glm::vec3(frustum.planes[i]));
+        return frustum;
+    }
+
+    // false only when the sphere is completely outside one plane (may keep a few invisible ones)
+    bool intersects(const BoundingSphere &sphere) const
+    {
+        for (int i = 0; i < 6; i++) {
+            if (glm::dot(glm::vec3(planes[i]), sphere.center) + planes[i].w < -sphere.radius) return false;
+        }
+        return true;
+    }
+
+    bool intersects(const AABB &box) const
+    {
+        glm::vec3 c = box.center(), e = box.extent();
+        for (int i = 0; i < 6; i++) {
+            glm::vec3 n = glm::vec3(planes[i]);
+            float reach = std::fabs(n.x) * e.x + std::fabs(n.y) * e.y + std::fabs(n.z) * e.z;
+            if (glm::dot(n, c) + planes[i].w < -reach) return false;
+        }
+        return true;
+    }
+};
+
+// spheres [begin, end) one at a time; visible[i] = 1 or 0, returns the visible count
+inline int cullSpheresScalar(const Frustum &frustum, const float *x, const float *y, const float *z, const float *r,
+                             int begin, int end, unsigned char *visible)
+{
+    int count = 0;
+    for (int i = begin; i < end; i++) {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; p++) {
+            const glm::vec4 &plane = frustum.planes[p];
+            inside = plane.x * x[i] + plane.y * y[i] + plane.z * z[i] + plane.w >= -r[i];
+        }
+        visible[i] = inside ? 1 : 0;
+        count += visible[i];
+    }
+    return count;
+}
+
+#ifdef FRUSTUM_SSE
+// spheres [begin, end), four at a time (the remainder goes through the scalar loop)
+inline int cullSpheresSSE(const Frustum &frustum, const float *x, const float *y, const float *z, const float *r,
+                          int begin, int end, unsigned char *visible)
+{
+    __m128 px[6], py[6], pz[6], pw[6];
+    for (int p = 0; p < 6; p++) {
+        px[p] = _mm_set1_ps(frustum.planes[p].x); py[p] = _mm_set1_ps(frustum.planes[p].y);
+        pz[p] = _mm_set1_ps(frustum.planes[p].z); pw[p] = _mm_set1_ps(frustum.planes[p].w);
+    }
+    const __m128 zero = _mm_setzero_ps();
+    int count = 0;
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 sx = _mm_loadu_ps(x + i), sy = _mm_loadu_ps(y + i), sz = _mm_loadu_ps(z + i);
+        __m128 negativeRadius = _mm_sub_ps(zero, _mm_loadu_ps(r + i));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px[p], sx), _mm_mul_ps(py[p], sy)),
+                                         _mm_add_ps(_mm_mul_ps(pz[p], sz), pw[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+        }
+        int mask = _mm_movemask_ps(inside);
+        for (int k = 0; k < 4; k++) {
+            visible[i + k] = (unsigned char)((mask >> k) & 1);
+            count += visible[i + k];
+        }
+    }
+    return count + cullSpheresScalar(frustum, x, y, z, r, i, end, visible);
+}
+#endif
+
+// the SIMD kernel where compiled in, otherwise the scalar one
+inline int cullSpheresKernel(const Frustum &frustum, const float *x, const float *y, const float *z, const float *r,
+                             int begin, int end, unsigned char *visible)
+{
+#ifdef FRUSTUM_SSE
+    return cullSpheresSSE(frustum, x, y, z, r, begin, end, visible);
+#else
+    return cullSpheresScalar(frustum, x, y, z, r, begin, end, visible);
+#endif
+}
+
+class FrustumCuller
+{
+public:
+    void clear()
+    {
+        x.clear(); y.clear(); z.clear(); r.clear();
+        visible.clear();
+    }
+
+    void reserve(int count)
+    {
+        x.reserve(count); y.reserve(count); z.reserve(count); r.reserve(count);
+        visible.reserve(count);
+    }
+
+    // world-space bounds; returns the index used by set() and isVisible()
+    int add(const BoundingSphere &sphere)
+    {
+        x.push_back(sphere.center.x); y.push_back(sphere.center.y); z.push_back(sphere.center.z);
+        r.push_back(sphere.radius);
+        visible.push_back(1);
+        return (int)x.size() - 1;
+    }
+
+    void set(int index, const BoundingSphere &sphere)
+    {
+        x[index] = sphere.center.x; y[index] = sphere.center.y; z[index] = sphere.center.z;
+        r[index] = sphere.radius;
+    }
+
+    void resize(int count)
+    {
+        x.resize(count); y.resize(count); z.resize(count); r.resize(count);
+        visible.resize(count, 1);
+    }
+
+    int size() const
+    {
+        return (int)x.size();
+    }
+
+    // tests every sphere against the frustum of projection * view; returns the visible count
+    int cull(const glm::mat4 &viewProjection)
+    {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        Frustum frustum = Frustum::fromMatrix(viewProjection);
+        int count = size();
+        std::atomic<int> visibleCount(0);
+        if (count > 0) {
+            const float *px = &x[0], *py = &y[0], *pz = &z[0], *pr = &r[0];
+            unsigned char *out = &visible[0];
+            parallelFor(0, count, 16384, [&](int begin, int end) {
+                visibleCount += cullSpheresKernel(frustum, px, py, pz, pr, begin, end, out);
+            });
+        }
+        DrawStats &stats = drawStats();
+        stats.cullTested += count;
+        stats.culled += count - visibleCount;
+        stats.cullMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        return visibleCount;
+    }
+
+    // valid after cull()
+    bool isVisible(int index) const
+    {
+        return visible[index] != 0;
+    }
+
+    const unsigned char *getVisibility() const
+    {
+        return visible.empty() ? NULL : &visible[0];
+    }
+
+private:
+    std::vector<float> x, y, z, r;
+    std::vector<unsigned char> visible;
+};
+
+#endif
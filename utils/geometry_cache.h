@@ -0,0 +1,106 @@
+// geometry_cache.h
+//
+// Process-wide cache of GPU buffer sets for procedural primitives.
+// Primitives created with the same parameters (e.g. the two wings of a Fighter_plane)
+// share one VAO and one set of VBOs instead of each uploading its own copy.
+// Entries are refcounted: the GL objects are deleted when the last user releases them.
+//
+// Usage:
+//     GeometryBuffers *buffers = GeometryCache::instance().acquire(key, [&](GeometryBuffers &b) {
+//         ... glGenVertexArrays(1, &b.VAO); fill b.VBO / b.EBO; b.count = ... ...
+//     });
+//     ...
+//     GeometryCache::instance().release(buffers);
+
+#ifndef GEOMETRY_CACHE_H
+#define GEOMETRY_CACHE_H
+
+#include <GL/glew.h>
+
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <vector>
+
+// Identifies a primitive: its type name plus every parameter that changes the generated buffers.
+struct GeometryKey
+{
+    std::string type;
+    std::vector<float> params;
+
+    GeometryKey() { }
+
+    GeometryKey(const std::string &type, std::initializer_list<float> params)
+    {
+        this->type = type;
+        this->params = params;
+    }
+
+    bool operator<(const GeometryKey &other) const
+    {
+        if (type != other.type) return type < other.type;
+        return params < other.params;
+    }
+};
+
+// One shared set of GL objects. VBO/EBO entries that a primitive does not use stay 0.
+struct GeometryBuffers
+{
+    GeometryKey key;
+    unsigned int VAO = 0;
+    unsigned int VBO[4] = { 0, 0, 0, 0 };
+    unsigned int EBO = 0;
+    int count = 0;      // number of vertices (glDrawArrays) or indices (glDrawElements) to draw
+    int refCount = 0;
+};
+
+class GeometryCache
+{
+public:
+
+    static GeometryCache &instance()
+    {
+        static GeometryCache cache;
+        return cache;
+    }
+
+    // Returns the buffers for key, calling build(buffers) to create and fill them on a miss.
+    // The returned pointer stays valid until the matching release().
+    template <typename Builder>
+    GeometryBuffers *acquire(const GeometryKey &key, Builder build)
+    {
+        std::map<GeometryKey, GeometryBuffers>::iterator it = entries.find(key);
+        if (it == entries.end()) {
+            it = entries.insert(std::make_pair(key, GeometryBuffers())).first;
+            it->second.key = key;
+            build(it->second);
+        }
+        it->second.refCount++;
+        return &it->second;
+    }
+
+    void release(GeometryBuffers *buffers)
+    {
+        if (buffers == NULL || --buffers->refCount > 0) return;
+
+        glDeleteVertexArrays(1, &buffers->VAO);
+        glDeleteBuffers(4, buffers->VBO);
+        if (buffers->EBO != 0) glDeleteBuffers(1, &buffers->EBO);
+        entries.erase(buffers->key);
+    }
+
+    // number of distinct buffer sets currently alive
+    int size() const
+    {
+        return (int)entries.size();
+    }
+
+private:
+    std::map<GeometryKey, GeometryBuffers> entries;
+
+    GeometryCache() { }
+    GeometryCache(const GeometryCache &);
+    GeometryCache &operator=(const GeometryCache &);
+};
+
+#endif
@@ -0,0 +1,345 @@
+// half_edge.h
+//
+// Index-based half-edge topology for triangle meshes, GL independent.
+// Half-edge h belongs to face h / 3 and runs from triangles[h] to triangles[next(h)], so next/prev/
+// face/origin are arithmetic; the only stored links are twin[h] (-1 on a boundary), one outgoing
+// half-edge per vertex and an edge id per half-edge. Everything is a flat int array.
+//
+// Built from any indexed triangle list in linear time: half-edges are bucketed by their lower
+// vertex (a counting sort) and paired inside each bucket, in parallel (parallel.h). Faces whose
+// winding disagrees with a neighbour are flipped so the mesh is consistently oriented, and when
+// positions are given the whole mesh is turned outward (positive volume).
+//
+//     std::vector<glm::vec3> points;
+//     std::vector<unsigned int> triangles = weldPositions(sink.positions, points);  // procedural output
+//     HalfEdgeMesh topology(points, triangles);
+//     ... or HalfEdgeMesh topology((int)mesh.vertices.size(), mesh.indices);       // a Mesh (Mesh.h)
+//
+// Shared by the normal computation below, subdivision.h and the simplification tools.
+// Non-manifold edges (more than two faces) are left unpaired and treated as boundaries.
+
+#ifndef HALF_EDGE_H
+#define HALF_EDGE_H
+
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "parallel.h"
+
+// Welds a triangle list (3 floats per vertex, 3 vertices per triangle) by position: a vertex within
+// weldDistance of an earlier point becomes that point. Returns one index into points per input vertex.
+// Points are hashed into a grid of weldDistance cells and each vertex looks at its own and the 26
+// neighbouring cells, so the weld is linear and holds across cell boundaries.
+inline std::vector<unsigned int> weldPositions(const std::vector<float> &soup, std::vector<glm::vec3> &points,
+                                               float weldDistance = 1e-4f)
+{
+    struct CellHash
+    {
+        size_t operator()(const glm::ivec3 &c) const
+        {
+            return (size_t)((unsigned int)c.x * 73856093u ^ (unsigned int)c.y * 19349663u ^ (unsigned int)c.z * 83492791u);
+        }
+    };
+    int count = (int)soup.size() / 3;
+    std::unordered_map<glm::ivec3, unsigned int, CellHash> firstInCell;    // cell -> its first point
+    std::vector<unsigned int> nextInCell;                                   // per point, NONE ends the cell's list
+    const unsigned int NONE = ~0u;
+    firstInCell.reserve(count);
+    std::vector<unsigned int> indices(count);
+    points.clear();
+    float limit = weldDistance * weldDistance;
+    for (int i = 0; i < count; i++) {
+        glm::vec3 p(soup[i * 3], soup[i * 3 + 1], soup[i * 3 + 2]);
+        glm::ivec3 cell(glm::floor(p / weldDistance));
+        unsigned int found = NONE;
+        for (int n = 0; n < 27 && found == NONE; n++) {
+            glm::ivec3 neighbour = cell + glm::ivec3(n % 3 - 1, n / 3 % 3 - 1, n / 9 - 1);
+            std::unordered_map<glm::ivec3, unsigned int, CellHash>::iterator it = firstInCell.find(neighbour);
+            if (it == firstInCell.end()) continue;
+            for (unsigned int q = it->second; q != NONE; q = nextInCell[q]) {
+                glm::vec3 d = points[q] - p;
+                if (glm::dot(d, d) <= limit) {
+                    found = q;
+                    break;
+                }
+            }
+        }
+        if (found == NONE) {
+            found = (unsigned int)points.size();
+            points.push_back(p);
+            std::pair<std::unordered_map<glm::ivec3, unsigned int, CellHash>::iterator, bool> slot =
+                firstInCell.insert(std::make_pair(cell, found));
+            nextInCell.push_back(slot.second ? NONE : slot.first->second);
+            slot.first->second = found;
+        }
+        indices[i] = found;
+    }
+    return indices;
+}
+
+class HalfEdgeMesh
+{
+public:
+    std::vector<unsigned int> triangles;    // the input faces, reoriented where needed
+    std::vector<int> twin;                  // per half-edge, -1 on boundaries
+    std::vector<int> edge;                  // per half-edge: id of its undirected edge
+    std::vector<int> edgeHalf;              // per edge: its half-edge with the lower index
+    std::vector<int> vertexOut;             // per vertex: an outgoing half-edge (the boundary one if any), -1 if unused
+    int nonManifoldEdges = 0;
+
+    HalfEdgeMesh() { }
+
+    HalfEdgeMesh(int vertexCount, const std::vector<unsigned int> &triangles)
+    {
+        build(vertexCount, triangles, NULL);
+    }
+
+    HalfEdgeMesh(const std::vector<glm::vec3> &positions, const std::vector<unsigned int> &triangles)
+    {
+        build((int)positions.size(), triangles, &positions);
+    }
+
+    int vertexCount() const { return (int)vertexOut.size(); }
+    int faceCount() const { return (int)triangles.size() / 3; }
+    int halfEdgeCount() const { return (int)triangles.size(); }
+    int edgeCount() const { return (int)edgeHalf.size(); }
+
+    static int face(int h) { return h / 3; }
+    static int next(int h) { return h % 3 == 2 ? h - 2 : h + 1; }
+    static int prev(int h) { return h % 3 == 0 ? h + 2 : h - 1; }
+    int origin(int h) const { return (int)triangles[h]; }
+    int dest(int h) const { return (int)triangles[next(h)]; }
+    bool isBoundary(int h) const { return twin[h] < 0; }
+
+    // calls f(h) for every half-edge leaving v, walking around v from its boundary (if any)
+    template <typename F>
+    void forEachOutgoing(int v, F f) const
+    {
+        int start = vertexOut[v];
+        if (start < 0) return;
+        int h = start;
+        do {
+            f(h);
+            h = twin[prev(h)];
+        } while (h >= 0 && h != start);
+    }
+
+    // calls f(neighbour, edgeId) for every vertex joined to v by an edge
+    template <typename F>
+    void forEachNeighbour(int v, F f) const
+    {
+        int last = -1;
+        forEachOutgoing(v, [&](int h) {
+            f(dest(h), edge[h]);
+            last = h;
+        });
+        // on a boundary the last face's incoming edge leads to one more neighbour
+        if (last >= 0 && twin[prev(last)] < 0) f(origin(prev(last)), edge[prev(last)]);
+    }
+
+    int valence(int v) const
+    {
+        int count = 0;
+        forEachNeighbour(v, [&](int, int) { count++; });
+        return count;
+    }
+
+    // area-weighted (not normalized) face normals: cross(b - a, c - a)
+    void faceNormals(const std::vector<glm::vec3> &positions, std::vector<glm::vec3> &out) const
+    {
+        out.resize(faceCount());
+        parallelFor(0, faceCount(), 4096, [&](int begin, int end) {
+            for (int f = begin; f < end; f++) {
+                const glm::vec3 &a = positions[triangles[f * 3]];
+                out[f] = glm::cross(positions[triangles[f * 3 + 1]] - a, positions[triangles[f * 3 + 2]] - a);
+            }
+        });
+    }
+
+    // smooth vertex normals: area-weighted average of the faces around each vertex
+    void vertexNormals(const std::vector<glm::vec3> &positions, std::vector<glm::vec3> &out) const
+    {
+        std::vector<glm::vec3> faces;
+        faceNormals(positions, faces);
+        out.resize(vertexCount());
+        parallelFor(0, vertexCount(), 4096, [&](int begin, int end) {
+            for (int v = begin; v < end; v++) {
+                glm::vec3 sum(0.0f);
+                forEachOutgoing(v, [&](int h) { sum += faces[face(h)]; });
+                out[v] = normalizeOr(sum, glm::vec3(0.0f, 1.0f, 0.0f));
+            }
+        });
+    }
+
+    // One normal per face corner (per half-edge, at its origin): the average over the faces around
+    // that vertex in the same smoothing group, so edges between groups stay sharp.
+    void cornerNormals(const std::vector<glm::vec3> &positions, const std::vector<int> &faceGroups,
+                       std::vector<glm::vec3> &out) const
+    {
+        std::vector<glm::vec3> faces;
+        faceNormals(positions, faces);
+        out.resize(halfEdgeCount());
+        parallelFor(0, halfEdgeCount(), 4096, [&](int begin, int end) {
+            for (int h = begin; h < end; h++) {
+                int group = faceGroups[face(h)];
+                glm::vec3 sum(0.0f);
+                forEachOutgoing(origin(h), [&](int around) {
+                    if (faceGroups[face(around)] == group) sum += faces[face(around)];
+                });
+                out[h] = normalizeOr(sum, faces[face(h)]);
+            }
+        });
+    }
+
+private:
+
+    static glm::vec3 normalizeOr(const glm::vec3 &v, const glm::vec3 &fallback)
+    {
+        float length = glm::length(v);
+        if (length > 0.0f) return v / length;
+        float fallbackLength = glm::length(fallback);
+        return fallbackLength > 0.0f ? fallback / fallbackLength : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+
+    void build(int vertexCount, const std::vector<unsigned int> &input, const std::vector<glm::vec3> *positions)
+    {
+        triangles = input;
+        triangles.resize(input.size() / 3 * 3);
+
+        if (pair(vertexCount)) {
+            orient();
+            pair(vertexCount);
+        }
+        if (positions != NULL && signedVolume(*positions) < 0.0f) {
+            for (int f = 0; f < faceCount(); f++) std::swap(triangles[f * 3 + 1], triangles[f * 3 + 2]);
+            pair(vertexCount);
+        }
+
+        // edge ids: the lower half-edge of each pair owns the edge
+        edge.assign(halfEdgeCount(), -1);
+        edgeHalf.clear();
+        for (int h = 0; h < halfEdgeCount(); h++) {
+            if (twin[h] < 0 || h < twin[h]) {
+                edge[h] = (int)edgeHalf.size();
+                edgeHalf.push_back(h);
+            }
+        }
+        parallelFor(0, halfEdgeCount(), 8192, [&](int begin, int end) {
+            for (int h = begin; h < end; h++) if (edge[h] < 0) edge[h] = edge[twin[h]];
+        });
+
+        vertexOut.assign(vertexCount, -1);
+        for (int h = 0; h < halfEdgeCount(); h++) {
+            int v = origin(h);
+            if (vertexOut[v] < 0 || twin[h] < 0) vertexOut[v] = h;
+        }
+    }
+
+    // Fills twin by pairing the half-edges of each undirected edge. Returns true when some pair
+    // runs in the same direction (the two faces disagree on winding).
+    bool pair(int vertexCount)
+    {
+        const int count = halfEdgeCount();
+        twin.assign(count, -1);
+        nonManifoldEdges = 0;
+
+        // counting sort of the half-edges by their lower vertex
+        std::vector<std::atomic<int> > bucketSize(vertexCount + 1);
+        for (int v = 0; v <= vertexCount; v++) bucketSize[v].store(0, std::memory_order_relaxed);
+        parallelFor(0, count, 8192, [&](int begin, int end) {
+            for (int h = begin; h < end; h++)
+                bucketSize[std::min(origin(h), dest(h)) + 1].fetch_add(1, std::memory_order_relaxed);
+        });
+        std::vector<int> bucketStart(vertexCount + 1, 0);
+        for (int v = 0; v < vertexCount; v++) bucketStart[v + 1] = bucketStart[v] + bucketSize[v + 1].load(std::memory_order_relaxed);
+        for (int v = 0; v < vertexCount; v++) bucketSize[v].store(bucketStart[v], std::memory_order_relaxed);
+        std::vector<int> sorted(count);
+        parallelFor(0, count, 8192, [&](int begin, int end) {
+            for (int h = begin; h < end; h++)
+                sorted[bucketSize[std::min(origin(h), dest(h))].fetch_add(1, std::memory_order_relaxed)] = h;
+        });
+
+        // pair inside each bucket (a vertex's valence, so small)
+        std::atomic<int> nonManifold(0), flipped(0);
+        parallelFor(0, vertexCount, 4096, [&](int begin, int end) {
+            for (int v = begin; v < end; v++) {
+                int *first = &sorted[0] + bucketStart[v], *last = &sorted[0] + bucketStart[v + 1];
+                std::sort(first, last, [&](int a, int b) {
+                    int highA = std::max(origin(a), dest(a)), highB = std::max(origin(b), dest(b));
+                    return highA < highB || (highA == highB && a < b);
+                });
+                for (int *run = first; run < last; ) {
+                    int high = std::max(origin(*run), dest(*run));
+                    int *runEnd = run + 1;
+                    while (runEnd < last && std::max(origin(*runEnd), dest(*runEnd)) == high) runEnd++;
+                    if (runEnd - run == 2) {
+                        twin[run[0]] = run[1];
+                        twin[run[1]] = run[0];
+                        if (origin(run[0]) == origin(run[1])) flipped++;
+                    }
+                    else if (runEnd - run > 2) {
+                        nonManifold++;
+                    }
+                    run = runEnd;
+                }
+            }
+        });
+        nonManifoldEdges = nonManifold;
+        return flipped > 0;
+    }
+
+    // flips faces (breadth first over twins) until every pair of neighbours agrees on winding
+    void orient()
+    {
+        std::vector<char> visited(faceCount(), 0);
+        std::vector<int> queue;
+        for (int seed = 0; seed < faceCount(); seed++) {
+            if (visited[seed]) continue;
+            visited[seed] = 1;
+            queue.assign(1, seed);
+            for (size_t q = 0; q < queue.size(); q++) {
+                int f = queue[q];
+                for (int k = 0; k < 3; k++) {
+                    int h = f * 3 + k, t = twin[h];
+                    if (t < 0 || visited[face(t)]) continue;
+                    int g = face(t);
+                    visited[g] = 1;
+                    // a consistent neighbour runs the shared edge the other way
+                    if (origin(t) == origin(h)) {
+                        std::swap(triangles[g * 3 + 1], triangles[g * 3 + 2]);
+                        relinkFlipped(g);
+                    }
+                    queue.push_back(g);
+                }
+            }
+        }
+    }
+
+    // after swapping corners 1 and 2 of face g, its half-edges 0 and 2 trade places
+    // (1 stays in place reversed); keep the twins of not-yet-visited faces pointing right
+    void relinkFlipped(int g)
+    {
+        int h0 = g * 3, h2 = g * 3 + 2;
+        std::swap(twin[h0], twin[h2]);
+        for (int k = 0; k < 3; k++) {
+            int h = g * 3 + k;
+            if (twin[h] >= 0) twin[twin[h]] = h;
+        }
+    }
+
+    float signedVolume(const std::vector<glm::vec3> &positions) const
+    {
+        double volume = 0.0;
+        for (int f = 0; f < faceCount(); f++) {
+            const glm::vec3 &a = positions[triangles[f * 3]], &b = positions[triangles[f * 3 + 1]], &c = positions[triangles[f * 3 + 2]];
+            volume += glm::dot(a, glm::cross(b, c));
+        }
+        return (float)volume;
+    }
+};
+
+#endif
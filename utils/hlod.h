@@ -0,0 +1,397 @@
+// hlod.h
+//
+// Hierarchical level of detail for static scenery, GL independent.
+// Per-object LOD (lod.h) still leaves one draw per object; an HLOD tree groups nearby static
+// objects into clusters, clusters into bigger clusters, and gives every cluster one proxy: the
+// merged geometry of everything below it, simplified by vertex clustering to a size fitting the
+// cluster. Far away a whole block of objects is then one draw of a few hundred triangles:
+//
+//     std::vector<HlodObject> objects;
+//     objects.push_back(HlodObject(&cubeMesh, model));        // VectorSink from procedural.h, world placement
+//     HLOD hlod;
+//     hlod.build(&objects[0], (int)objects.size());
+//     ...
+//     HlodSelection selection;
+//     hlod.select(view, projection, viewportHeight, 1.0f, selection, &frustum);
+//     for (...) draw proxy selection.proxies[i] (HlodProxies, hlod_proxies.h) or object selection.objects[i]
+//
+// select() walks down from the root and stops at the first cluster whose proxy error, projected
+// on screen, is at most maxPixelError pixels; a leaf cluster that is still too coarse hands out
+// its objects. Every object not culled is covered exactly once, by itself or by one proxy.
+//
+// Proxies are in world space (draw them with an identity model matrix) and are made from the
+// proxies of the child clusters, so building stays linear in the scene size. A proxy's error is
+// its own cell diagonal plus the largest error of its children.
+
+#ifndef HLOD_H
+#define HLOD_H
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "procedural.h"
+#include "mesh_merge.h"
+#include "bounds.h"
+#include "frustum.h"
+#include "parallel.h"
+
+// one static object: its mesh (model space, indexed or a triangle list) and where it stands
+struct HlodObject
+{
+    const VectorSink *mesh;
+    glm::mat4 transform;
+
+    HlodObject() : mesh(NULL), transform(1.0f) { }
+    HlodObject(const VectorSink *mesh, const glm::mat4 &transform) : mesh(mesh), transform(transform) { }
+};
+
+struct HlodNode
+{
+    AABB bounds;                    // world space, of every object below
+    float error;                    // world-space distance the proxy may be off the real geometry
+    int firstChild, childCount;     // children are consecutive nodes; no children: a leaf cluster
+    int firstObject, objectCount;   // every object below, a range of HLOD::getObjectOrder()
+    int height;                     // 0 for leaves
+    MergedMesh proxy;               // one part (id 0), world space
+};
+
+// what select() chose: node ids whose proxy to draw and object ids to draw themselves
+struct HlodSelection
+{
+    std::vector<int> proxies;
+    std::vector<int> objects;
+    long long triangles = 0;
+
+    void clear()
+    {
+        proxies.clear();
+        objects.clear();
+        triangles = 0;
+    }
+
+    int drawCount() const
+    {
+        return (int)(proxies.size() + objects.size());
+    }
+};
+
+class HLOD
+{
+public:
+    enum { MAX_BRANCHING = 16 };
+
+    int leafObjects = 8;            // most objects in a leaf cluster
+    int branching = 4;              // children per cluster, at most MAX_BRANCHING
+    int proxyResolution = 16;       // vertex clustering cells along the longest side of a cluster
+
+    // objects must stay alive until build() returns; only their bounds and triangle counts are kept
+    void build(const HlodObject *objects, int count)
+    {
+        nodes.clear();
+        order.resize(count);
+        objectBounds.resize(count);
+        objectTriangles.resize(count);
+        centroids.resize(count);
+        parallelFor(0, count, 256, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                const VectorSink &mesh = *objects[i].mesh;
+                AABB box;
+                for (int v = 0; v < mesh.vertexCount(); v++) {
+                    box.extend(glm::vec3(objects[i].transform * glm::vec4(mesh.positions[v * 3], mesh.positions[v * 3 + 1], mesh.positions[v * 3 + 2], 1.0f)));
+                }
+                objectBounds[i] = box;
+                centroids[i] = box.center();
+                objectTriangles[i] = (int)(mesh.indices.empty() ? mesh.positions.size() / 9 : mesh.indices.size() / 3);
+                order[i] = i;
+            }
+        });
+        if (count == 0) return;
+
+        nodes.push_back(HlodNode());
+        split(0, 0, count);
+
+        // proxies bottom-up: all clusters of one height are independent of each other
+        int maxHeight = nodes[0].height;
+        std::vector<std::vector<int> > byHeight(maxHeight + 1);
+        for (int i = 0; i < (int)nodes.size(); i++) byHeight[nodes[i].height].push_back(i);
+        for (int h = 0; h <= maxHeight; h++) {
+            const std::vector<int> &level = byHeight[h];
+            parallelFor(0, (int)level.size(), 1, [&](int begin, int end) {
+                for (int i = begin; i < end; i++) buildProxy(objects, level[i]);
+            });
+        }
+    }
+
+    // Picks the coarsest clusters whose proxy is at most maxPixelError pixels off on a viewport
+    // viewportHeight pixels high. Subtrees outside frustum (if given) are skipped.
+    void select(const glm::mat4 &view, const glm::mat4 &projection, float viewportHeight, float maxPixelError,
+                HlodSelection &selection, const Frustum *frustum = NULL) const
+    {
+        selection.clear();
+        if (nodes.empty()) return;
+        // pixels per world unit at distance 1; projection[1][1] = cot(fovy / 2)
+        float pixelScale = projection[1][1] * 0.5f * viewportHeight;
+        glm::vec3 eye = -glm::transpose(glm::mat3(view)) * glm::vec3(view[3]);
+
+        int stack[STACK_SIZE];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const HlodNode &node = nodes[stack[--top]];
+            if (frustum && !frustum->intersects(node.bounds)) continue;
+
+            // nearest the cluster can be to the eye; inside its box nothing is far enough
+            float distance = glm::length(glm::max(glm::max(node.bounds.min - eye, eye - node.bounds.max), glm::vec3(0.0f)));
+            if (distance > 0.0f && node.error * pixelScale <= maxPixelError * distance) {
+                selection.proxies.push_back((int)(&node - &nodes[0]));
+                selection.triangles += node.proxy.triangleCount();
+                continue;
+            }
+            if (node.childCount == 0) {
+                for (int i = node.firstObject; i < node.firstObject + node.objectCount; i++) {
+                    int object = order[i];
+                    if (frustum && !frustum->intersects(objectBounds[object])) continue;
+                    selection.objects.push_back(object);
+                    selection.triangles += objectTriangles[object];
+                }
+                continue;
+            }
+            // pushed backwards so they are visited in order
+            for (int c = node.childCount - 1; c >= 0; c--) stack[top++] = node.firstChild + c;
+        }
+    }
+
+    const HlodNode &getNode(int node) const
+    {
+        return nodes[node];
+    }
+
+    int nodeCount() const
+    {
+        return (int)nodes.size();
+    }
+
+    int objectCount() const
+    {
+        return (int)order.size();
+    }
+
+    // object ids in cluster order: node.firstObject .. + objectCount index into it
+    const std::vector<int> &getObjectOrder() const
+    {
+        return order;
+    }
+
+    const AABB &getObjectBounds(int object) const
+    {
+        return objectBounds[object];
+    }
+
+    int getObjectTriangles(int object) const
+    {
+        return objectTriangles[object];
+    }
+
+    // triangles of the proxies of all clusters of one height
+    long long proxyTriangles(int height) const
+    {
+        long long triangles = 0;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            if (nodes[i].height == height) triangles += nodes[i].proxy.triangleCount();
+        }
+        return triangles;
+    }
+
+private:
+    enum { STACK_SIZE = 512 };     // MAX_BRANCHING per level of depth
+
+    std::vector<HlodNode> nodes;
+    std::vector<int> order;
+    std::vector<AABB> objectBounds;
+    std::vector<int> objectTriangles;
+    std::vector<glm::vec3> centroids;
+
+    // node covers order[begin, end): splits it into up to `branching` children at centroid medians
+    void split(int node, int begin, int end)
+    {
+        AABB bounds;
+        for (int i = begin; i < end; i++) bounds.extend(objectBounds[order[i]]);
+        nodes[node].bounds = bounds;
+        nodes[node].firstObject = begin;
+        nodes[node].objectCount = end - begin;
+        nodes[node].firstChild = -1;
+        nodes[node].childCount = 0;
+        nodes[node].height = 0;
+        nodes[node].error = 0.0f;
+        if (end - begin <= std::max(1, leafObjects)) return;
+
+        // halve the largest group along the longest axis of its centroids until there are enough
+        std::vector<std::pair<int, int> > groups(1, std::make_pair(begin, end));
+        int children = std::min(std::max(2, branching), (int)MAX_BRANCHING);
+        while ((int)groups.size() < children) {
+            int largest = 0;
+            for (int g = 1; g < (int)groups.size(); g++) {
+                if (groups[g].second - groups[g].first > groups[largest].second - groups[largest].first) largest = g;
+            }
+            int first = groups[largest].first, last = groups[largest].second;
+            if (last - first <= std::max(1, leafObjects)) break;
+
+            AABB centroidBounds;
+            for (int i = first; i < last; i++) centroidBounds.extend(centroids[order[i]]);
+            glm::vec3 size = centroidBounds.max - centroidBounds.min;
+            int axis = size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2);
+            int middle = (first + last) / 2;
+            std::nth_element(order.begin() + first, order.begin() + middle, order.begin() + last, [&](int a, int b) {
+                return centroids[a][axis] < centroids[b][axis];
+            });
+            groups[largest].second = middle;
+            groups.push_back(std::make_pair(middle, last));
+        }
+        std::sort(groups.begin(), groups.end());
+
+        int firstChild = (int)nodes.size();
+        nodes.resize(nodes.size() + groups.size());
+        nodes[node].firstChild = firstChild;
+        nodes[node].childCount = (int)groups.size();
+        int height = 0;
+        for (int g = 0; g < (int)groups.size(); g++) {
+            split(firstChild + g, groups[g].first, groups[g].second);
+            height = std::max(height, nodes[firstChild + g].height + 1);
+        }
+        nodes[node].height = height;
+    }
+
+    // merged world-space triangles of a cluster, before simplification
+    struct Soup
+    {
+        std::vector<glm::vec3> positions, normals;
+        std::vector<glm::vec2> texcoords;
+        std::vector<unsigned int> indices;
+    };
+
+    void buildProxy(const HlodObject *objects, int index)
+    {
+        HlodNode &node = nodes[index];
+        Soup soup;
+        float childError = 0.0f;
+        if (node.childCount == 0) {
+            for (int i = node.firstObject; i < node.firstObject + node.objectCount; i++) {
+                const HlodObject &object = objects[order[i]];
+                const VectorSink &mesh = *object.mesh;
+                glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(object.transform)));
+                unsigned int base = (unsigned int)soup.positions.size();
+                int vertexCount = mesh.vertexCount();
+                for (int v = 0; v < vertexCount; v++) {
+                    soup.positions.push_back(glm::vec3(object.transform * glm::vec4(mesh.positions[v * 3], mesh.positions[v * 3 + 1], mesh.positions[v * 3 + 2], 1.0f)));
+                    soup.normals.push_back(normalMatrix * glm::vec3(mesh.normals[v * 3], mesh.normals[v * 3 + 1], mesh.normals[v * 3 + 2]));
+                    soup.texcoords.push_back(glm::vec2(mesh.texcoords[v * 2], mesh.texcoords[v * 2 + 1]));
+                }
+                if (mesh.indices.empty()) {
+                    for (int v = 0; v < vertexCount; v++) soup.indices.push_back(base + v);
+                }
+                else {
+                    for (size_t k = 0; k < mesh.indices.size(); k++) soup.indices.push_back(base + mesh.indices[k]);
+                }
+            }
+        }
+        else {
+            for (int c = node.firstChild; c < node.firstChild + node.childCount; c++) {
+                const MergedMesh &proxy = nodes[c].proxy;
+                unsigned int base = (unsigned int)soup.positions.size();
+                soup.positions.insert(soup.positions.end(), proxy.positions.begin(), proxy.positions.end());
+                soup.normals.insert(soup.normals.end(), proxy.normals.begin(), proxy.normals.end());
+                soup.texcoords.insert(soup.texcoords.end(), proxy.texcoords.begin(), proxy.texcoords.end());
+                for (size_t k = 0; k < proxy.indices.size(); k++) soup.indices.push_back(base + proxy.indices[k]);
+                childError = std::max(childError, nodes[c].error);
+            }
+        }
+
+        glm::vec3 size = node.bounds.max - node.bounds.min;
+        float cellSize = std::max(std::max(size.x, size.y), size.z) / (float)std::max(1, proxyResolution);
+        if (cellSize <= 0.0f) cellSize = 1e-6f;
+        simplify(soup, node.bounds, cellSize, std::max(1, proxyResolution), node.proxy);
+        node.error = cellSize * std::sqrt(3.0f) + childError;
+    }
+
+    // Vertex clustering: every vertex moves to the mean position of its grid cell. Vertices of a
+    // cell are still split by the main direction of their normal, so flat faces meeting at an
+    // edge keep separate normals; triangles with two corners in one cell disappear. The grid
+    // spans bounds with at most resolution + 1 cells per axis, small enough to index directly.
+    static void simplify(const Soup &soup, const AABB &bounds, float cellSize, int resolution, MergedMesh &out)
+    {
+        int dims[3];
+        for (int axis = 0; axis < 3; axis++) {
+            dims[axis] = std::min((int)((bounds.max[axis] - bounds.min[axis]) / cellSize), resolution) + 1;
+        }
+        const int vertexCount = (int)soup.positions.size();
+        std::vector<int> cellIndex(vertexCount), vertexOf(vertexCount);
+        std::vector<glm::vec3> cellSum(dims[0] * dims[1] * dims[2], glm::vec3(0.0f));
+        std::vector<int> cellCount(cellSum.size(), 0);
+        std::vector<int> vertexSlot(cellSum.size() * 6, -1);    // output vertex of (cell, normal direction)
+
+        out = MergedMesh();
+        out.partCount = 1;
+        out.inputVertices = vertexCount;
+        std::vector<int> vertexCell;
+        std::vector<glm::vec2> texcoordSum;
+        std::vector<int> vertexSamples;
+        for (int i = 0; i < vertexCount; i++) {
+            glm::vec3 grid = (soup.positions[i] - bounds.min) / cellSize;
+            int c[3];
+            for (int axis = 0; axis < 3; axis++) c[axis] = std::min(std::max((int)grid[axis], 0), dims[axis] - 1);
+            int cell = (c[2] * dims[1] + c[1]) * dims[0] + c[0];
+            cellSum[cell] += soup.positions[i];
+            cellCount[cell]++;
+            cellIndex[i] = cell;
+
+            const glm::vec3 &n = soup.normals[i];
+            glm::vec3 a = glm::abs(n);
+            int direction = a.x >= a.y && a.x >= a.z ? 0 : (a.y >= a.z ? 2 : 4);
+            if (n[direction / 2] < 0.0f) direction++;
+            int &vertex = vertexSlot[cell * 6 + direction];
+            if (vertex < 0) {
+                vertex = (int)out.normals.size();
+                out.normals.push_back(glm::vec3(0.0f));
+                texcoordSum.push_back(glm::vec2(0.0f));
+                vertexSamples.push_back(0);
+                vertexCell.push_back(cell);
+            }
+            out.normals[vertex] += n;
+            texcoordSum[vertex] += soup.texcoords[i];
+            vertexSamples[vertex]++;
+            vertexOf[i] = vertex;
+        }
+
+        int outputVertices = (int)out.normals.size();
+        out.positions.resize(outputVertices);
+        out.texcoords.resize(outputVertices);
+        out.partIds.assign(outputVertices, 0);
+        for (int v = 0; v < outputVertices; v++) {
+            out.positions[v] = cellSum[vertexCell[v]] / (float)cellCount[vertexCell[v]];
+            float length = glm::length(out.normals[v]);
+            if (length > 0.0f) out.normals[v] /= length;
+            out.texcoords[v] = texcoordSum[v] / (float)vertexSamples[v];
+        }
+
+        // drop collapsed triangles and repeats (the same three vertices, any rotation)
+        std::unordered_set<unsigned long long> seen;
+        seen.reserve(soup.indices.size() / 3);
+        for (size_t t = 0; t + 2 < soup.indices.size(); t += 3) {
+            unsigned int i0 = soup.indices[t], i1 = soup.indices[t + 1], i2 = soup.indices[t + 2];
+            if (cellIndex[i0] == cellIndex[i1] || cellIndex[i1] == cellIndex[i2] || cellIndex[i0] == cellIndex[i2]) continue;
+            unsigned int v[3] = { (unsigned int)vertexOf[i0], (unsigned int)vertexOf[i1], (unsigned int)vertexOf[i2] };
+            int smallest = v[0] < v[1] ? (v[0] < v[2] ? 0 : 2) : (v[1] < v[2] ? 1 : 2);
+            unsigned long long key = ((unsigned long long)v[smallest] << 42) | ((unsigned long long)v[(smallest + 1) % 3] << 21) | v[(smallest + 2) % 3];
+            if (!seen.insert(key).second) continue;
+            out.indices.push_back(v[0]);
+            out.indices.push_back(v[1]);
+            out.indices.push_back(v[2]);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,55 @@
+// hlod_proxies.h
+//
+// GPU side of an HLOD tree (hlod.h): the proxy of every cluster as a StaticComposite, drawn for
+// the clusters a selection picked. The objects a selection hands out are the caller's to draw.
+//
+//     HlodProxies *proxies = new HlodProxies(hlod, glm::vec4(0.8f, 0.8f, 0.8f, 1.0f));
+//     hlod.select(view, projection, viewportHeight, 1.0f, selection, &frustum);
+//     proxies->draw(shader, selection);
+//     for (...) draw object selection.objects[i] as usual
+//
+// Vertex shader: as StaticComposite (the proxies are one part, id 0).
+
+#ifndef HLOD_PROXIES_H
+#define HLOD_PROXIES_H
+
+#include <vector>
+
+#include "shader.h"
+#include "hlod.h"
+#include "static_composite.h"
+
+class HlodProxies
+{
+public:
+    HlodProxies(const HLOD &hlod, const glm::vec4 &color = glm::vec4(1.0f))
+    {
+        for (int i = 0; i < hlod.nodeCount(); i++) proxies.push_back(new StaticComposite(hlod.getNode(i).proxy, color));
+    }
+
+    ~HlodProxies()
+    {
+        for (size_t i = 0; i < proxies.size(); i++) delete proxies[i];
+    }
+
+    // proxies are in world space: the shader's "model" is set to identity
+    void draw(Shader *shader, const HlodSelection &selection)
+    {
+        shader->use();
+        shader->setMat4("model", glm::mat4(1.0f));
+        for (size_t i = 0; i < selection.proxies.size(); i++) proxies[selection.proxies[i]]->draw(shader);
+    }
+
+    int getTriangleNum(int node) const
+    {
+        return proxies[node]->getTriangleNum();
+    }
+
+private:
+    std::vector<StaticComposite *> proxies;
+
+    HlodProxies(const HlodProxies &);
+    HlodProxies &operator=(const HlodProxies &);
+};
+
+#endif
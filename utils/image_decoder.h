@@ -0,0 +1,158 @@
+// image_decoder.h
+//
+// Background image decoding with stb_image, GL independent. request() queues a file and returns
+// at once; decoder threads load the queued files, and hand the decoded images back through a
+// lock-free queue (mpsc_queue.h) to the one thread that takes them with poll(). For textures that
+// thread is the GL thread (texture_loader.h).
+//
+//     ImageDecoder decoder(2);
+//     decoder.request("brick.png", 7);                 // 7: the caller's tag, returned with the image
+//     DecodedImage *image;
+//     while ((image = decoder.poll()) != NULL) {
+//         use(image->pixels, image->width, image->height, image->channels);
+//         decoder.release(image);
+//     }
+//
+// stb_image.h needs STB_IMAGE_IMPLEMENTATION defined in exactly one translation unit.
+// stbi_failure_reason() is one global for all threads: a failed image only has pixels == NULL.
+
+#ifndef IMAGE_DECODER_H
+#define IMAGE_DECODER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stb_image.h>
+
+#include "mpsc_queue.h"
+
+struct DecodedImage
+{
+    std::string path;
+    unsigned int tag;
+    int width, height, channels;
+    unsigned char *pixels;          // NULL when the file could not be decoded
+    double decodeMilliseconds;
+
+    size_t bytes() const
+    {
+        return (size_t)width * height * channels;
+    }
+};
+
+class ImageDecoder
+{
+public:
+    // one thread fewer than the hardware has, leaving one for the thread that draws
+    static int defaultThreads()
+    {
+        return std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    }
+
+    explicit ImageDecoder(int threads = defaultThreads()) : stopping(false), pending(0)
+    {
+        for (int i = 0; i < std::max(threads, 1); i++) workers.push_back(std::thread(&ImageDecoder::workerLoop, this));
+    }
+
+    // files not decoded yet are dropped
+    ~ImageDecoder()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+        DecodedImage *image;
+        while ((image = poll()) != NULL) release(image);
+    }
+
+    // any thread; returns at once
+    void request(const std::string &path, unsigned int tag)
+    {
+        pending++;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(Job(path, tag));
+        }
+        wake.notify_one();
+    }
+
+    // the consumer thread only: a decoded image, or NULL when none is ready; give it back with release()
+    DecodedImage *poll()
+    {
+        DecodedImage *image;
+        if (!decoded.pop(image)) return NULL;
+        pending--;
+        return image;
+    }
+
+    void release(DecodedImage *image)
+    {
+        if (image->pixels != NULL) stbi_image_free(image->pixels);
+        delete image;
+    }
+
+    // requested and not polled yet
+    int pendingCount() const
+    {
+        return pending;
+    }
+
+    int threadCount() const
+    {
+        return (int)workers.size();
+    }
+
+private:
+    struct Job
+    {
+        std::string path;
+        unsigned int tag;
+
+        Job(const std::string &path, unsigned int tag) : path(path), tag(tag) { }
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;                   // guards jobs and stopping
+    std::condition_variable wake;
+    std::deque<Job> jobs;
+    bool stopping;
+    std::atomic<int> pending;
+    MpscQueue<DecodedImage *> decoded;
+
+    ImageDecoder(const ImageDecoder &);
+    ImageDecoder &operator=(const ImageDecoder &);
+
+    void workerLoop()
+    {
+        for (;;) {
+            Job job("", 0);
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping) return;
+                job = jobs.front();
+                jobs.pop_front();
+            }
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            DecodedImage *image = new DecodedImage();
+            image->path = job.path;
+            image->tag = job.tag;
+            image->width = image->height = image->channels = 0;
+            image->pixels = stbi_load(job.path.c_str(), &image->width, &image->height, &image->channels, 0);
+            if (image->pixels == NULL) image->width = image->height = image->channels = 0;
+            image->decodeMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            decoded.push(image);
+        }
+    }
+};
+
+#endif
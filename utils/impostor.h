@@ -0,0 +1,183 @@
+// impostor.h
+//
+// Octahedral impostors: a model pre-rendered from gridSize x gridSize directions around it
+// (octahedral.h) into one atlas texture, drawn far away as a single camera-facing quad per
+// instance that blends the three stored views nearest to the viewing direction. A whole set of
+// distant instances is one instanced draw of 2 triangles each.
+//
+//     ImpostorAtlas *impostor = new ImpostorAtlas(8, 128);     // 8 x 8 views of 128 x 128 pixels
+//     impostor->bake(globalShader, bounds, [&](Shader *shader) {
+//         shader->setMat4("model", glm::mat4(1.0f));
+//         model->Draw(shader);
+//     });
+//     ...
+//     instances.upload(&farInstances[0], count);                // InstanceData as for instanced.vs
+//     impostor->draw(impostorShader, instances);
+//
+// bake() renders with the caller's shader and lighting uniforms (the light is baked into the
+// views) and sets its "view", "projection" and "viewPos": set them again before normal drawing.
+// Vertex shader: impostor.vs (0: quad corner (vec2), 4-7: instance model (mat4), 8: instance color (vec4))
+// Fragment shader: impostor.fs
+
+#ifndef IMPOSTOR_H
+#define IMPOSTOR_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+
+#include "shader.h"
+#include "bounds.h"
+#include "octahedral.h"
+#include "instance_buffer.h"
+
+class ImpostorAtlas
+{
+public:
+    enum { TEXTURE_UNIT = 0 };
+
+    ImpostorAtlas(int gridSize = 8, int frameSize = 128) : gridSize(gridSize), frameSize(frameSize), texture(0), baked(false)
+    {
+        static const float corners[12] = { -1, -1,  1, -1,  1, 1,  -1, -1,  1, 1,  -1, 1 };
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void *)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        int size = gridSize * frameSize;
+        GLint previousTexture;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, previousTexture);
+    }
+
+    ~ImpostorAtlas()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteTextures(1, &texture);
+    }
+
+    // renders every view into the atlas: draw(shader) draws the model in its model space, which
+    // bounds (model space as well) must enclose
+    template <typename Draw>
+    void bake(Shader *shader, const BoundingSphere &bounds, Draw draw)
+    {
+        this->bounds = bounds;
+        GLint previousFramebuffer, viewport[4];
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        glGetIntegerv(GL_VIEWPORT, viewport);
+
+        int size = gridSize * frameSize;
+        unsigned int framebuffer, depth;
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "ERROR::IMPOSTOR::FRAMEBUFFER_INCOMPLETE" << std::endl;
+        }
+
+        // transparent where the model is not: impostor.fs discards those pixels
+        GLfloat clearColor[4];
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        float radius = bounds.radius;
+        shader->use();
+        shader->setMat4("projection", glm::ortho(-radius, radius, -radius, radius, 0.0f, 4.0f * radius));
+        for (int y = 0; y < gridSize; y++) {
+            for (int x = 0; x < gridSize; x++) {
+                glm::vec3 direction = octahedralFrameDirection(x, y, gridSize);
+                glm::vec3 right, up;
+                octahedralFrameAxes(direction, right, up);
+                glm::vec3 eye = bounds.center + direction * (2.0f * radius);
+                glViewport(x * frameSize, y * frameSize, frameSize, frameSize);
+                shader->use();
+                shader->setMat4("view", glm::lookAt(eye, bounds.center, up));
+                shader->setVec3("viewPos", eye);
+                draw(shader);
+            }
+        }
+
+        GLint previousTexture;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, previousTexture);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+        glDeleteRenderbuffers(1, &depth);
+        glDeleteFramebuffers(1, &framebuffer);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+        baked = true;
+    }
+
+    // one quad per instance, one draw call; the shader's view / projection / viewPos are the caller's
+    void draw(Shader *shader, const InstanceBuffer &instances)
+    {
+        if (!baked) return;
+        shader->use();
+        shader->setInt("atlas", TEXTURE_UNIT);
+        shader->setInt("gridSize", gridSize);
+        shader->setVec3("boundsCenter", bounds.center);
+        shader->setFloat("boundsRadius", bounds.radius);
+        // the unit may hold the texture of the other drawing classes: put it back afterwards
+        GLint previousTexture;
+        glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        instances.drawArrays(VAO, 6);
+        glBindTexture(GL_TEXTURE_2D, previousTexture);
+    }
+
+    bool isBaked() const
+    {
+        return baked;
+    }
+
+    unsigned int getTexture() const
+    {
+        return texture;
+    }
+
+    int getGridSize() const
+    {
+        return gridSize;
+    }
+
+    // model-space bounds given to bake()
+    const BoundingSphere &getBounds() const
+    {
+        return bounds;
+    }
+
+private:
+    int gridSize, frameSize;
+    unsigned int VAO, VBO, texture;
+    BoundingSphere bounds;
+    bool baked;
+
+    ImpostorAtlas(const ImpostorAtlas &);
+    ImpostorAtlas &operator=(const ImpostorAtlas &);
+};
+
+#endif
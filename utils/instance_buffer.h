@@ -0,0 +1,117 @@
+// instance_buffer.h
+//
+// Per-instance model matrix and colour for instanced drawing.
+// The data is re-uploaded every frame into one streaming VBO; around an instanced draw the
+// buffer is attached to the mesh's VAO at the instance locations and detached again afterwards,
+// so the (shared, cached) mesh VAOs keep working with the non-instanced shaders.
+//
+//     instances.upload(&data[0], (int)data.size());
+//     glBindVertexArray(mesh VAO);
+//     instances.attach();
+//     glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, instances.getCount());
+//     instances.detach();
+//
+// Vertex shader: the locations 0-3 as the meshes (vertex_layout.h), 4-7: instance model (mat4),
+//                8: instance color (vec4) - see instanced.vs
+
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+#include "draw_stats.h"
+#include "instance_data.h"
+
+class InstanceBuffer
+{
+public:
+    enum { MODEL_LOCATION = 4, COLOR_LOCATION = 8 };
+
+    InstanceBuffer() : VBO(0), count(0), capacity(0)
+    {
+        glGenBuffers(1, &VBO);
+    }
+
+    ~InstanceBuffer()
+    {
+        glDeleteBuffers(1, &VBO);
+    }
+
+    // replaces the contents; the old storage is orphaned so the upload does not wait for
+    // draws that still read last frame's data
+    void upload(const InstanceData *data, int count)
+    {
+        this->count = count;
+        if (count > capacity) capacity = count + count / 2;
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(InstanceData), NULL, GL_STREAM_DRAW);
+        if (count > 0) glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(InstanceData), data);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    int getCount() const
+    {
+        return count;
+    }
+
+    // with the mesh VAO bound: feeds locations 4-8 from this buffer, advancing once per instance
+    void attach() const
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        for (int column = 0; column < 4; column++) {
+            glVertexAttribPointer(MODEL_LOCATION + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                                  (void *)(offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+            glEnableVertexAttribArray(MODEL_LOCATION + column);
+            glVertexAttribDivisor(MODEL_LOCATION + column, 1);
+        }
+        glVertexAttribPointer(COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void *)offsetof(InstanceData, color));
+        glEnableVertexAttribArray(COLOR_LOCATION);
+        glVertexAttribDivisor(COLOR_LOCATION, 1);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // with the same VAO bound: back to the state the mesh was created with
+    void detach() const
+    {
+        for (int location = MODEL_LOCATION; location <= COLOR_LOCATION; location++) {
+            glVertexAttribDivisor(location, 0);
+            glDisableVertexAttribArray(location);
+        }
+    }
+
+    // every instance of a glDrawArrays mesh, one draw call
+    void drawArrays(unsigned int VAO, int vertexCount) const
+    {
+        if (count == 0) return;
+        glBindVertexArray(VAO);
+        attach();
+        glDrawArraysInstanced(GL_TRIANGLES, 0, vertexCount, count);
+        detach();
+        glBindVertexArray(0);
+        drawStats().add(count, vertexCount / 3);
+    }
+
+    // every instance of a glDrawElements mesh, one draw call
+    void drawElements(unsigned int VAO, int indexCount) const
+    {
+        if (count == 0) return;
+        glBindVertexArray(VAO);
+        attach();
+        glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, count);
+        detach();
+        glBindVertexArray(0);
+        drawStats().add(count, indexCount / 3);
+    }
+
+private:
+    unsigned int VBO;
+    int count, capacity;
+
+    InstanceBuffer(const InstanceBuffer &);
+    InstanceBuffer &operator=(const InstanceBuffer &);
+};
+
+#endif
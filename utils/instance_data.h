@@ -0,0 +1,34 @@
+// instance_data.h
+//
+// What an instanced draw reads per instance (instance_buffer.h, instanced.vs), GL independent.
+
+#ifndef INSTANCE_DATA_H
+#define INSTANCE_DATA_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+struct InstanceData
+{
+    glm::mat4 model;
+    glm::vec4 color;
+
+    InstanceData() : model(1.0f), color(1.0f) { }
+    InstanceData(const glm::mat4 &model, const glm::vec4 &color) : model(model), color(color) { }
+};
+
+// Sorts instances into nearby and distant (appended) by the distance from the camera to their
+// center point (model space); e.g. full meshes close by, impostors (impostor.h) beyond.
+inline void splitByDistance(const InstanceData *instances, int count, const glm::vec3 &center, const glm::vec3 &camera, float distance,
+                            std::vector<InstanceData> &nearby, std::vector<InstanceData> &distant)
+{
+    float distanceSquared = distance * distance;
+    for (int i = 0; i < count; i++) {
+        glm::vec3 offset = glm::vec3(instances[i].model * glm::vec4(center, 1.0f)) - camera;
+        if (glm::dot(offset, offset) > distanceSquared) distant.push_back(instances[i]);
+        else nearby.push_back(instances[i]);
+    }
+}
+
+#endif
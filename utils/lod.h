@@ -0,0 +1,79 @@
+// lod.h
+//
+// Screen-size driven level of detail for the procedural primitives, GL independent.
+// A chain of tessellation levels is made once per parameter set (level 0 is the full one,
+// every following level has about half the sides), and each draw picks the coarsest level
+// whose rim still has an edge every `pixelsPerEdge` pixels on screen:
+//
+//     std::vector<BucketShape> chain = bucketLodChain(shape, 4);
+//     float r = projectedSphereRadius(center, bucketBoundingRadius(shape), view, projection, viewportHeight);
+//     int level = selectBucketLevel(chain, r, 8.0f);
+//
+// BucketLOD (bucket_lod.h) owns the GPU side of such a chain.
+
+#ifndef LOD_H
+#define LOD_H
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "procedural.h"
+
+// Up to maxLevels shapes, from shape itself down to 3 top sides.
+// top_n is halved per level; bottom_n follows it to the divisor of the new top_n that is
+// closest to the halved bottom_n (generateBucket needs topN = bottomN * natural number).
+inline std::vector<BucketShape> bucketLodChain(const BucketShape &shape, int maxLevels)
+{
+    std::vector<BucketShape> chain(1, shape);
+    int targetBottom = shape.bottomN;
+    while ((int)chain.size() < maxLevels && chain.back().topN > 3) {
+        BucketShape next = chain.back();
+        next.topN = next.topN / 2 < 3 ? 3 : next.topN / 2;
+        targetBottom = targetBottom / 2 < 3 ? 3 : targetBottom / 2;
+
+        next.bottomN = next.topN;
+        for (int d = 3; d <= next.topN; d++) {
+            if (next.topN % d == 0 && std::abs(d - targetBottom) < std::abs(next.bottomN - targetBottom))
+                next.bottomN = d;
+        }
+        chain.push_back(next);
+    }
+    return chain;
+}
+
+// radius of a sphere around the origin that holds the whole bucket
+inline float bucketBoundingRadius(const BucketShape &shape)
+{
+    float top = shape.topRadius * glm::max(1.0f, shape.topRatio);
+    float bottom = shape.bottomRadius * glm::max(1.0f, shape.bottomRatio);
+    float rim = glm::max(top, bottom);
+    return std::sqrt(rim * rim + shape.height * shape.height * 0.25f);
+}
+
+// Radius in pixels of a world-space sphere for a perspective projection.
+// A sphere that contains the eye covers the whole screen and returns viewportHeight.
+inline float projectedSphereRadius(const glm::vec3 &center, float radius,
+                                   const glm::mat4 &view, const glm::mat4 &projection, float viewportHeight)
+{
+    glm::vec3 eyeCenter = glm::vec3(view * glm::vec4(center, 1.0f));
+    float distance = glm::length(eyeCenter);
+    if (distance <= radius) return viewportHeight;
+    // projection[1][1] = cot(fovy / 2)
+    return radius * projection[1][1] * 0.5f * viewportHeight / std::sqrt(distance * distance - radius * radius);
+}
+
+// The coarsest level that keeps one rim edge per pixelsPerEdge pixels of projected circumference.
+inline int selectBucketLevel(const std::vector<BucketShape> &chain, float pixelRadius, float pixelsPerEdge)
+{
+    float wantedSides = 2.0f * 3.14159265f * pixelRadius / pixelsPerEdge;
+    int level = 0;
+    for (int i = 1; i < (int)chain.size(); i++) {
+        if ((float)chain[i].topN >= wantedSides) level = i;
+    }
+    return level;
+}
+
+#endif
@@ -0,0 +1,166 @@
+// mapped_file.h
+//
+// Read-only memory mapping of a whole file, GL independent: the pages are read in by the OS as
+// they are touched, nothing is copied or parsed. Windows (CreateFileMapping) and POSIX (mmap).
+//
+//     MappedFile file;
+//     if (file.open("model.obj.meshcache")) use(file.data(), file.size());
+//     file.close();                               // or let it go out of scope
+//
+// fileStamp() gives the modification time and size of a file, to tell whether a file derived
+// from it (a cache) is still current. The time has the file system's full resolution, so an
+// edit within the same second that keeps the size still changes the stamp. replaceFile()
+// moves a finished file over another in one step, so readers see the old or the new one.
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// false when path cannot be read; time is only for comparing: nanoseconds on POSIX, 100 ns
+// FILETIME ticks on Windows
+inline bool fileStamp(const std::string &path, long long &modificationTime, unsigned long long &size)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA status;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &status)) return false;
+    modificationTime = (long long)(((unsigned long long)status.ftLastWriteTime.dwHighDateTime << 32) | status.ftLastWriteTime.dwLowDateTime);
+    size = ((unsigned long long)status.nFileSizeHigh << 32) | status.nFileSizeLow;
+#else
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0) return false;
+#ifdef __APPLE__
+    modificationTime = (long long)status.st_mtimespec.tv_sec * 1000000000LL + status.st_mtimespec.tv_nsec;
+#else
+    modificationTime = (long long)status.st_mtim.tv_sec * 1000000000LL + status.st_mtim.tv_nsec;
+#endif
+    size = (unsigned long long)status.st_size;
+#endif
+    return true;
+}
+
+// renames from to to, replacing to if it exists; to is never missing in between
+inline bool replaceFile(const std::string &from, const std::string &to)
+{
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from.c_str(), to.c_str()) == 0;  // POSIX rename replaces atomically
+#endif
+}
+
+class MappedFile
+{
+public:
+    MappedFile() : bytes(NULL), length(0)
+    {
+#ifdef _WIN32
+        file = INVALID_HANDLE_VALUE;
+        mapping = NULL;
+#endif
+    }
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    // false when the file cannot be opened or is empty
+    bool open(const std::string &path)
+    {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+            close();
+            return false;
+        }
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping == NULL) {
+            close();
+            return false;
+        }
+        bytes = (const unsigned char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (bytes == NULL) {
+            close();
+            return false;
+        }
+        length = (size_t)fileSize.QuadPart;
+#else
+        int descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0) return false;
+        struct stat status;
+        if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+            ::close(descriptor);
+            return false;
+        }
+        void *mapped = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        ::close(descriptor);    // the mapping keeps the file
+        if (mapped == MAP_FAILED) return false;
+        bytes = (const unsigned char *)mapped;
+        length = (size_t)status.st_size;
+#endif
+        return true;
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (bytes != NULL) UnmapViewOfFile(bytes);
+        if (mapping != NULL) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (bytes != NULL) munmap((void *)bytes, length);
+#endif
+        bytes = NULL;
+        length = 0;
+    }
+
+    bool isOpen() const
+    {
+        return bytes != NULL;
+    }
+
+    const unsigned char *data() const
+    {
+        return bytes;
+    }
+
+    size_t size() const
+    {
+        return length;
+    }
+
+private:
+    const unsigned char *bytes;
+    size_t length;
+#ifdef _WIN32
+    HANDLE file, mapping;
+#endif
+
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+};
+
+#endif
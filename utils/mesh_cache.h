@@ -0,0 +1,325 @@
+// mesh_cache.h
+//
+// Binary cache of imported models, GL independent: the final vertex, index and material texture
+// data of every mesh (mesh_import.h) in one file that is memory-mapped on the next load
+// (mapped_file.h), so a cache hit parses nothing and hands pointers into the mapping straight to
+// the buffer upload. The file records what it was made from (source path, modification time and
+// size, importer flags) and the format version: if any of it differs, open() fails and the model
+// is imported again.
+//
+//     MeshCacheFile cache;
+//     if (cache.open(meshCachePath(path), path, flags)) {
+//         for (int i = 0; i < cache.meshCount(); i++) upload(cache.vertices(i), cache.vertexCount(i), ...);
+//     }
+//     else {
+//         long long time; unsigned long long size;
+//         fileStamp(path, time, size);            // before the import reads the source
+//         ... import, convert ...
+//         writeMeshCache(meshCachePath(path), path, time, size, flags, &data[0], &textures[0], count);
+//     }
+//
+// Layout (native byte order; the version changes with it or with Vertex):
+//     MeshCacheHeader, source path (padded to 8), MeshCacheEntry per mesh,
+//     texture references per mesh (type and path, each a 4-byte length and the characters, padded to 4),
+//     vertex arrays and index arrays (each starting 16-byte aligned).
+
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "mesh_import.h"
+#include "mapped_file.h"
+
+#define MESH_CACHE_VERSION 2        // 2: sub-second source times
+
+// one texture of a mesh's material, as Mesh binds it: type is the sampler name ("texture_diffuse")
+struct MeshCacheTexture
+{
+    std::string type;
+    std::string path;       // as the material names it, relative to the model's directory
+
+    MeshCacheTexture() { }
+    MeshCacheTexture(const std::string &type, const std::string &path) : type(type), path(path) { }
+};
+
+struct MeshCacheHeader
+{
+    char magic[4];                      // "MSHC"
+    unsigned int version;
+    unsigned int importerFlags;
+    unsigned int meshCount;
+    long long sourceTime;               // fileStamp() of the source
+    unsigned long long sourceSize;
+    unsigned int vertexSize;            // sizeof(Vertex) when written
+    unsigned int pathLength;
+    unsigned long long fileSize;        // a cut-off write does not match
+};
+
+struct MeshCacheEntry
+{
+    unsigned long long vertexOffset, indexOffset, textureOffset;    // from the start of the file
+    unsigned int vertexCount, indexCount, textureCount, materialIndex;
+    float boundsMin[3], boundsMax[3];
+};
+
+static_assert(sizeof(MeshCacheHeader) == 48, "MeshCacheHeader is written as it is in memory");
+static_assert(sizeof(MeshCacheEntry) == 64, "MeshCacheEntry is written as it is in memory");
+static_assert(sizeof(Vertex) == 32, "the cached vertices are Vertex as it is in memory");
+
+// where the cache of a model file lives: next to it
+inline std::string meshCachePath(const std::string &sourcePath)
+{
+    return sourcePath + ".meshcache";
+}
+
+inline size_t meshCacheAlign(size_t offset, size_t alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Writes count meshes with textures[i] the references of meshes[i]; false when the file cannot be
+// written. sourceTime and sourceSize are the fileStamp() of the source taken before it was read, so
+// a source saved during the import leaves a cache that is already stale. Written to a temporary
+// file first, so a reader never maps a half-written cache.
+inline bool writeMeshCache(const std::string &cachePath, const std::string &sourcePath, long long sourceTime,
+                           unsigned long long sourceSize, unsigned int importerFlags,
+                           const MeshData *meshes, const std::vector<MeshCacheTexture> *textures, int count)
+{
+    MeshCacheHeader header;
+    memcpy(header.magic, "MSHC", 4);
+    header.version = MESH_CACHE_VERSION;
+    header.importerFlags = importerFlags;
+    header.meshCount = (unsigned int)count;
+    header.sourceTime = sourceTime;
+    header.sourceSize = sourceSize;
+    header.vertexSize = sizeof(Vertex);
+    header.pathLength = (unsigned int)sourcePath.size();
+
+    // lay the file out first: every offset is known before anything is written
+    std::vector<MeshCacheEntry> entries(count);
+    size_t offset = meshCacheAlign(sizeof(MeshCacheHeader) + sourcePath.size(), 8) + count * sizeof(MeshCacheEntry);
+    for (int i = 0; i < count; i++) {
+        MeshCacheEntry &entry = entries[i];
+        memset(&entry, 0, sizeof(entry));
+        entry.textureOffset = offset;
+        entry.textureCount = (unsigned int)textures[i].size();
+        for (size_t t = 0; t < textures[i].size(); t++) {
+            offset += meshCacheAlign(4 + textures[i][t].type.size(), 4) + meshCacheAlign(4 + textures[i][t].path.size(), 4);
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        offset = meshCacheAlign(offset, 16);
+        entries[i].vertexOffset = offset;
+        entries[i].vertexCount = (unsigned int)meshes[i].vertices.size();
+        offset += meshes[i].vertices.size() * sizeof(Vertex);
+    }
+    for (int i = 0; i < count; i++) {
+        offset = meshCacheAlign(offset, 16);
+        entries[i].indexOffset = offset;
+        entries[i].indexCount = (unsigned int)meshes[i].indices.size();
+        offset += meshes[i].indices.size() * sizeof(unsigned int);
+        entries[i].materialIndex = meshes[i].materialIndex;
+        for (int axis = 0; axis < 3; axis++) {
+            entries[i].boundsMin[axis] = meshes[i].bounds.min[axis];
+            entries[i].boundsMax[axis] = meshes[i].bounds.max[axis];
+        }
+    }
+    header.fileSize = offset;
+
+    std::string temporary = cachePath + ".tmp";
+    FILE *file = fopen(temporary.c_str(), "wb");
+    if (file == NULL) return false;
+    size_t written = 0;
+    static const char zeros[16] = { 0 };
+    // pads the file up to the given offset
+    auto padTo = [&](size_t target) {
+        if (target > written) written += fwrite(zeros, 1, target - written, file);
+    };
+    auto writeBytes = [&](const void *bytes, size_t size) {
+        if (size > 0) written += fwrite(bytes, 1, size, file);
+    };
+    auto writeString = [&](const std::string &text) {
+        unsigned int length = (unsigned int)text.size();
+        writeBytes(&length, 4);
+        writeBytes(text.data(), text.size());
+        padTo(meshCacheAlign(written, 4));
+    };
+
+    writeBytes(&header, sizeof(header));
+    writeBytes(sourcePath.data(), sourcePath.size());
+    padTo(meshCacheAlign(written, 8));
+    writeBytes(entries.empty() ? NULL : &entries[0], entries.size() * sizeof(MeshCacheEntry));
+    for (int i = 0; i < count; i++) {
+        for (size_t t = 0; t < textures[i].size(); t++) {
+            writeString(textures[i][t].type);
+            writeString(textures[i][t].path);
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        padTo((size_t)entries[i].vertexOffset);
+        writeBytes(meshes[i].vertices.empty() ? NULL : &meshes[i].vertices[0], meshes[i].vertices.size() * sizeof(Vertex));
+    }
+    for (int i = 0; i < count; i++) {
+        padTo((size_t)entries[i].indexOffset);
+        writeBytes(meshes[i].indices.empty() ? NULL : &meshes[i].indices[0], meshes[i].indices.size() * sizeof(unsigned int));
+    }
+    bool complete = fclose(file) == 0 && written == header.fileSize;
+    if (!complete) {
+        remove(temporary.c_str());
+        return false;
+    }
+    // the old cache stays in place if this fails (on Windows, while another load has it mapped)
+    if (!replaceFile(temporary, cachePath)) {
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// a mapped cache file; the pointers stay valid until close() or destruction
+class MeshCacheFile
+{
+public:
+    MeshCacheFile() : header(NULL), entries(NULL) { }
+
+    // false when there is no cache for sourcePath, or it is stale (source changed, other flags,
+    // other format version) or damaged
+    bool open(const std::string &cachePath, const std::string &sourcePath, unsigned int importerFlags)
+    {
+        close();
+        long long sourceTime;
+        unsigned long long sourceSize;
+        if (!fileStamp(sourcePath, sourceTime, sourceSize) || !file.open(cachePath)) return false;
+        if (!validate(sourcePath, importerFlags, sourceTime, sourceSize)) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        file.close();
+        header = NULL;
+        entries = NULL;
+    }
+
+    bool isOpen() const
+    {
+        return header != NULL;
+    }
+
+    int meshCount() const
+    {
+        return header != NULL ? (int)header->meshCount : 0;
+    }
+
+    const Vertex *vertices(int mesh) const
+    {
+        return (const Vertex *)(file.data() + entries[mesh].vertexOffset);
+    }
+
+    unsigned int vertexCount(int mesh) const
+    {
+        return entries[mesh].vertexCount;
+    }
+
+    const unsigned int *indices(int mesh) const
+    {
+        return (const unsigned int *)(file.data() + entries[mesh].indexOffset);
+    }
+
+    unsigned int indexCount(int mesh) const
+    {
+        return entries[mesh].indexCount;
+    }
+
+    unsigned int materialIndex(int mesh) const
+    {
+        return entries[mesh].materialIndex;
+    }
+
+    AABB bounds(int mesh) const
+    {
+        const MeshCacheEntry &entry = entries[mesh];
+        return AABB(glm::vec3(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]),
+                    glm::vec3(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2]));
+    }
+
+    // the texture references of a mesh (copied out: they are a few short strings)
+    std::vector<MeshCacheTexture> textures(int mesh) const
+    {
+        std::vector<MeshCacheTexture> out(entries[mesh].textureCount);
+        size_t offset = (size_t)entries[mesh].textureOffset;
+        for (size_t t = 0; t < out.size(); t++) {
+            out[t].type = readString(offset);
+            out[t].path = readString(offset);
+        }
+        return out;
+    }
+
+    // bytes of the mapped file
+    size_t size() const
+    {
+        return file.size();
+    }
+
+private:
+    MappedFile file;
+    const MeshCacheHeader *header;
+    const MeshCacheEntry *entries;
+
+    MeshCacheFile(const MeshCacheFile &);
+    MeshCacheFile &operator=(const MeshCacheFile &);
+
+    std::string readString(size_t &offset) const
+    {
+        unsigned int length;
+        memcpy(&length, file.data() + offset, 4);
+        std::string text((const char *)file.data() + offset + 4, length);
+        offset += meshCacheAlign(4 + (size_t)length, 4);
+        return text;
+    }
+
+    // everything read later is checked here once: the accessors do no bounds checks
+    bool validate(const std::string &sourcePath, unsigned int importerFlags, long long sourceTime, unsigned long long sourceSize)
+    {
+        size_t size = file.size();
+        if (size < sizeof(MeshCacheHeader)) return false;
+        const MeshCacheHeader *h = (const MeshCacheHeader *)file.data();
+        if (memcmp(h->magic, "MSHC", 4) != 0 || h->version != MESH_CACHE_VERSION || h->vertexSize != sizeof(Vertex) ||
+            h->importerFlags != importerFlags || h->fileSize != size || h->sourceTime != sourceTime || h->sourceSize != sourceSize) return false;
+        if (h->pathLength != sourcePath.size() || sizeof(MeshCacheHeader) + h->pathLength > size ||
+            memcmp(file.data() + sizeof(MeshCacheHeader), sourcePath.data(), sourcePath.size()) != 0) return false;
+
+        // the path's padding may end past a truncated file: check before subtracting
+        size_t tableOffset = meshCacheAlign(sizeof(MeshCacheHeader) + h->pathLength, 8);
+        if (tableOffset > size || h->meshCount > (size - tableOffset) / sizeof(MeshCacheEntry)) return false;
+        const MeshCacheEntry *table = (const MeshCacheEntry *)(file.data() + tableOffset);
+        for (unsigned int i = 0; i < h->meshCount; i++) {
+            const MeshCacheEntry &entry = table[i];
+            if (entry.vertexOffset % 16 != 0 || entry.indexOffset % 16 != 0) return false;
+            if (entry.vertexOffset > size || entry.vertexCount > (size - entry.vertexOffset) / sizeof(Vertex)) return false;
+            if (entry.indexOffset > size || entry.indexCount > (size - entry.indexOffset) / sizeof(unsigned int)) return false;
+            // every reference is two strings of at least 4 bytes: bounds the count before counting strings
+            if (entry.textureOffset > size || entry.textureCount > (size - entry.textureOffset) / 8) return false;
+            size_t offset = (size_t)entry.textureOffset;
+            for (size_t t = 0; t < (size_t)entry.textureCount * 2; t++) {
+                unsigned int length;
+                if (offset > size || size - offset < 4) return false;
+                memcpy(&length, file.data() + offset, 4);
+                if (length > size - offset - 4) return false;
+                offset += meshCacheAlign(4 + (size_t)length, 4);
+            }
+        }
+        header = h;
+        entries = table;
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,86 @@
+// mesh_import.h
+//
+// CPU side of loading a model (Model.h), GL independent: converts imported meshes into the
+// interleaved vertex and index arrays a Mesh uploads. Every mesh is independent, so a whole
+// model converts in parallel on a worker pool (parallel.h), each mesh into its own preallocated
+// MeshData; only the GL buffer creation afterwards has to stay on the context thread.
+//
+//     std::vector<MeshData> data(count);
+//     convertMeshes(&sources[0], count, &data[0]);                // worker threads
+//     for (...) meshes.push_back(Mesh(data[i], textures));         // context thread
+//
+// The source type is read the way assimp lays out an aiMesh: mNumVertices, mVertices and
+// mNormals (x / y / z), mTextureCoords[0] (NULL when absent), mNumFaces and mFaces
+// (mNumIndices, mIndices), mMaterialIndex. Anything with those members converts the same way.
+
+#ifndef MESH_IMPORT_H
+#define MESH_IMPORT_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+#include "parallel.h"
+
+struct Vertex
+{
+    // Position
+    glm::vec3 Position;
+    // Normal
+    glm::vec3 Normal;
+    // TexCoords
+    glm::vec2 TexCoords;
+};
+
+struct MeshData
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    AABB bounds;                    // model space
+    unsigned int materialIndex = 0;
+};
+
+// fills out from mesh: sized once, then written in place
+template <typename SourceMesh>
+void convertMesh(const SourceMesh &mesh, MeshData &out)
+{
+    unsigned int vertexCount = mesh.mNumVertices;
+    out.vertices.resize(vertexCount);
+    out.bounds = AABB();
+    for (unsigned int i = 0; i < vertexCount; i++) {
+        Vertex &vertex = out.vertices[i];
+        vertex.Position = glm::vec3(mesh.mVertices[i].x, mesh.mVertices[i].y, mesh.mVertices[i].z);
+        out.bounds.extend(vertex.Position);
+    }
+    // normals are optional in assimp as well
+    for (unsigned int i = 0; i < vertexCount; i++) {
+        out.vertices[i].Normal = mesh.mNormals ? glm::vec3(mesh.mNormals[i].x, mesh.mNormals[i].y, mesh.mNormals[i].z) : glm::vec3(0.0f);
+    }
+    // only the first of up to 8 texture coordinate sets is used
+    for (unsigned int i = 0; i < vertexCount; i++) {
+        out.vertices[i].TexCoords = mesh.mTextureCoords[0] ? glm::vec2(mesh.mTextureCoords[0][i].x, mesh.mTextureCoords[0][i].y) : glm::vec2(0.0f);
+    }
+
+    // triangulated faces have 3 indices, but points and lines stay as they are: count first
+    size_t indexCount = 0;
+    for (unsigned int i = 0; i < mesh.mNumFaces; i++) indexCount += mesh.mFaces[i].mNumIndices;
+    out.indices.resize(indexCount);
+    unsigned int *index = indexCount > 0 ? &out.indices[0] : NULL;
+    for (unsigned int i = 0; i < mesh.mNumFaces; i++) {
+        const unsigned int *face = mesh.mFaces[i].mIndices;
+        for (unsigned int j = 0; j < mesh.mFaces[i].mNumIndices; j++) *index++ = face[j];
+    }
+    out.materialIndex = mesh.mMaterialIndex;
+}
+
+// converts meshes[0, count) into out[0, count), one mesh per task so large and small meshes balance
+template <typename SourceMesh>
+void convertMeshes(SourceMesh *const *meshes, int count, MeshData *out, ThreadPool &pool = ThreadPool::instance())
+{
+    pool.parallelFor(0, count, 1, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) convertMesh(*meshes[i], out[i]);
+    });
+}
+
+#endif
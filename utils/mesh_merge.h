@@ -0,0 +1,122 @@
+// mesh_merge.h
+//
+// Bakes the rigid parts of a composite model into one indexed mesh, GL independent.
+// Each part is a generator output (VectorSink, indexed or a plain triangle list) plus the
+// transform that places it in the model; the merged vertices are pre-transformed, welded where
+// position, normal and texture coordinate are identical, and tagged with their part's id so a
+// shader can still move the parts separately (static_composite.h, composite.vs):
+//
+//     MergedMesh merged;
+//     merged.addPart(bodyMesh, glm::mat4(1.0f));    // part 0
+//     merged.addPart(wingMesh, wingOffset);         // part 1
+//     StaticComposite *baked = new StaticComposite(merged);
+
+#ifndef MESH_MERGE_H
+#define MESH_MERGE_H
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "procedural.h"
+
+struct MergedMesh
+{
+    enum { MAX_PARTS = 256 };   // part ids are stored in one byte
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texcoords;
+    std::vector<unsigned char> partIds;
+    std::vector<unsigned int> indices;
+    int partCount = 0;
+    int inputVertices = 0;      // vertices handed to addPart(), before welding
+
+    // appends mesh placed by transform; returns its part id
+    int addPart(const VectorSink &mesh, const glm::mat4 &transform)
+    {
+        if (partCount >= MAX_PARTS) {
+            std::cout << "MESH_MERGE: more than " << (int)MAX_PARTS << " parts" << std::endl;
+            exit(-1);
+        }
+        int part = partCount++;
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(transform)));
+
+        int vertexCount = (int)mesh.positions.size() / 3;
+        inputVertices += vertexCount;
+        // merged index of each input vertex
+        std::vector<unsigned int> remap(vertexCount);
+        std::unordered_map<WeldKey, unsigned int, WeldKeyHash> welded;
+        welded.reserve(vertexCount);
+        for (int i = 0; i < vertexCount; i++) {
+            WeldKey key;
+            glm::vec3 p = glm::vec3(transform * glm::vec4(mesh.positions[i * 3], mesh.positions[i * 3 + 1], mesh.positions[i * 3 + 2], 1.0f));
+            glm::vec3 n = normalMatrix * glm::vec3(mesh.normals[i * 3], mesh.normals[i * 3 + 1], mesh.normals[i * 3 + 2]);
+            float length = glm::length(n);
+            if (length > 0.0f) n /= length;
+            key.values[0] = p.x; key.values[1] = p.y; key.values[2] = p.z;
+            key.values[3] = n.x; key.values[4] = n.y; key.values[5] = n.z;
+            key.values[6] = mesh.texcoords[i * 2]; key.values[7] = mesh.texcoords[i * 2 + 1];
+
+            std::unordered_map<WeldKey, unsigned int, WeldKeyHash>::const_iterator found = welded.find(key);
+            if (found != welded.end()) {
+                remap[i] = found->second;
+                continue;
+            }
+            unsigned int index = (unsigned int)positions.size();
+            positions.push_back(p);
+            normals.push_back(n);
+            texcoords.push_back(glm::vec2(key.values[6], key.values[7]));
+            partIds.push_back((unsigned char)part);
+            welded[key] = index;
+            remap[i] = index;
+        }
+
+        if (mesh.indices.empty()) {
+            for (int i = 0; i < vertexCount; i++) indices.push_back(remap[i]);
+        }
+        else {
+            for (size_t i = 0; i < mesh.indices.size(); i++) indices.push_back(remap[mesh.indices[i]]);
+        }
+        return part;
+    }
+
+    int vertexCount() const
+    {
+        return (int)positions.size();
+    }
+
+    int triangleCount() const
+    {
+        return (int)indices.size() / 3;
+    }
+
+private:
+    struct WeldKey
+    {
+        float values[8];    // position, normal, texcoord
+
+        bool operator==(const WeldKey &other) const
+        {
+            return std::memcmp(values, other.values, sizeof(values)) == 0;
+        }
+    };
+
+    struct WeldKeyHash
+    {
+        size_t operator()(const WeldKey &key) const
+        {
+            // FNV-1a over the bytes
+            const unsigned char *bytes = (const unsigned char *)key.values;
+            size_t hash = 2166136261u;
+            for (size_t i = 0; i < sizeof(key.values); i++) hash = (hash ^ bytes[i]) * 16777619u;
+            return hash;
+        }
+    };
+};
+
+#endif
@@ -0,0 +1,110 @@
+// mpsc_queue.h
+//
+// Lock-free queue for many producer threads and one consumer thread, GL independent.
+// push() is one atomic exchange and never waits for other producers or the consumer; pop() is
+// only ever called from one thread (e.g. the GL thread taking what workers produced).
+//
+//     MpscQueue<Image *> done;
+//     done.push(image);                      // any thread
+//     Image *image;
+//     while (done.pop(image)) upload(image); // the one consumer thread
+//
+// A push that has swapped the head but not linked its node yet is not visible to pop() for
+// that short moment: pop() then reports empty and the item comes out on a later call.
+// The queue is destroyed only after every producer's push() has returned.
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue() : head(&stub), tail(&stub)
+    {
+        stub.next.store(NULL, std::memory_order_relaxed);
+    }
+
+    // items still queued are dropped (their nodes freed, the values not looked at); walks the
+    // whole chain rather than popping, since pop() may stop early at a node it cannot take yet
+    ~MpscQueue()
+    {
+        Node *last = NULL;
+        for (Node *node = tail; node != NULL; ) {
+            Node *next = node->next.load(std::memory_order_acquire);
+            last = node;
+            if (node != &stub) delete node;
+            node = next;
+        }
+        // a break in the chain is a push still running: the queue outlived a producer
+        assert(last == head.load(std::memory_order_acquire));
+        (void)last;
+    }
+
+    // any thread
+    void push(const T &value)
+    {
+        Node *node = new Node();
+        node->value = value;
+        node->next.store(NULL, std::memory_order_relaxed);
+        Node *previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // the consumer thread only; false when nothing can be taken right now
+    bool pop(T &value)
+    {
+        Node *first = tail;
+        Node *next = first->next.load(std::memory_order_acquire);
+        if (first == &stub) {
+            if (next == NULL) return false;
+            // step over the stub, it is put back at the end below
+            tail = next;
+            first = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != NULL) {
+            tail = next;
+            value = first->value;
+            delete first;
+            return true;
+        }
+        // first is the last node: queue the stub behind it so first can be taken
+        if (first != head.load(std::memory_order_acquire)) return false;
+        stub.next.store(NULL, std::memory_order_relaxed);
+        Node *previous = head.exchange(&stub, std::memory_order_acq_rel);
+        previous->next.store(&stub, std::memory_order_release);
+        next = first->next.load(std::memory_order_acquire);
+        if (next == NULL) return false;
+        tail = next;
+        value = first->value;
+        delete first;
+        return true;
+    }
+
+    // consumer thread only: nothing to pop, as far as this thread can see
+    bool empty() const
+    {
+        return tail == &stub && stub.next.load(std::memory_order_acquire) == NULL;
+    }
+
+private:
+    struct Node
+    {
+        std::atomic<Node *> next;
+        T value;
+    };
+
+    std::atomic<Node *> head;   // producers: the last node
+    Node *tail;                 // consumer: the next node to take
+    Node stub;
+
+    MpscQueue(const MpscQueue &);
+    MpscQueue &operator=(const MpscQueue &);
+};
+
+#endif
@@ -0,0 +1,114 @@
+// normals.h
+//
+// Batched face normals for triangle lists, GL independent and allocation free.
+// Input is a span of triangles (9 floats each: three xyz corners, the layout the drawing classes
+// upload), output a span of unit normals written `copies` times per triangle: 1 gives one normal
+// per face, 3 gives the per-vertex flat normals of a glDrawArrays triangle list.
+//
+//     computeFaceNormals(vertices, triangleCount, normals, 3);
+//
+// The normal is cross(b - a, c - a), normalized; degenerate triangles get (0, 0, 0).
+// With awayFrom set, normals that point towards that point are flipped (the orientation the old
+// MyUtils get_normal produced for the paper sheets).
+// Chunks of triangles run in parallel (parallel.h); inside a chunk, 4 triangles at a time with SSE
+// where available, otherwise the scalar loop.
+
+#ifndef NORMALS_H
+#define NORMALS_H
+
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+#include "parallel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NORMALS_SSE 1
+#include <emmintrin.h>
+#endif
+
+// triangles [begin, end), one at a time
+inline void faceNormalsScalar(const float *positions, int begin, int end, float *out, int copies, const glm::vec3 *awayFrom)
+{
+    for (int t = begin; t < end; t++) {
+        const float *p = positions + (size_t)t * 9;
+        float e1x = p[3] - p[0], e1y = p[4] - p[1], e1z = p[5] - p[2];
+        float e2x = p[6] - p[0], e2y = p[7] - p[1], e2z = p[8] - p[2];
+        float nx = e1y * e2z - e1z * e2y;
+        float ny = e1z * e2x - e1x * e2z;
+        float nz = e1x * e2y - e1y * e2x;
+        float lengthSquared = nx * nx + ny * ny + nz * nz;
+        float scale = lengthSquared > 0.0f ? 1.0f / std::sqrt(lengthSquared) : 0.0f;
+        if (awayFrom != NULL && nx * (p[0] - awayFrom->x) + ny * (p[1] - awayFrom->y) + nz * (p[2] - awayFrom->z) < 0.0f)
+            scale = -scale;
+        float *o = out + (size_t)t * 3 * copies;
+        for (int c = 0; c < copies; c++) {
+            o[c * 3] = nx * scale; o[c * 3 + 1] = ny * scale; o[c * 3 + 2] = nz * scale;
+        }
+    }
+}
+
+#ifdef NORMALS_SSE
+// triangles [begin, end), four at a time (the remainder goes through the scalar loop)
+inline void faceNormalsSSE(const float *positions, int begin, int end, float *out, int copies, const glm::vec3 *awayFrom)
+{
+    int t = begin;
+    const __m128 zero = _mm_setzero_ps();
+    for (; t + 4 <= end; t += 4) {
+        const float *p = positions + (size_t)t * 9;
+        // AoS -> SoA: lane i holds triangle t + i
+        __m128 ax = _mm_setr_ps(p[0], p[9], p[18], p[27]), ay = _mm_setr_ps(p[1], p[10], p[19], p[28]), az = _mm_setr_ps(p[2], p[11], p[20], p[29]);
+        __m128 bx = _mm_setr_ps(p[3], p[12], p[21], p[30]), by = _mm_setr_ps(p[4], p[13], p[22], p[31]), bz = _mm_setr_ps(p[5], p[14], p[23], p[32]);
+        __m128 cx = _mm_setr_ps(p[6], p[15], p[24], p[33]), cy = _mm_setr_ps(p[7], p[16], p[25], p[34]), cz = _mm_setr_ps(p[8], p[17], p[26], p[35]);
+
+        __m128 e1x = _mm_sub_ps(bx, ax), e1y = _mm_sub_ps(by, ay), e1z = _mm_sub_ps(bz, az);
+        __m128 e2x = _mm_sub_ps(cx, ax), e2y = _mm_sub_ps(cy, ay), e2z = _mm_sub_ps(cz, az);
+        __m128 nx = _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e1z, e2y));
+        __m128 ny = _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e1x, e2z));
+        __m128 nz = _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e1y, e2x));
+
+        __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+        __m128 valid = _mm_cmpgt_ps(lengthSquared, zero);
+        __m128 scale = _mm_and_ps(valid, _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(lengthSquared, _mm_set1_ps(1e-30f)))));
+        if (awayFrom != NULL) {
+            __m128 dx = _mm_sub_ps(ax, _mm_set1_ps(awayFrom->x)), dy = _mm_sub_ps(ay, _mm_set1_ps(awayFrom->y)), dz = _mm_sub_ps(az, _mm_set1_ps(awayFrom->z));
+            __m128 facing = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, dx), _mm_mul_ps(ny, dy)), _mm_mul_ps(nz, dz));
+            __m128 flip = _mm_and_ps(_mm_cmplt_ps(facing, zero), _mm_set1_ps(-0.0f));   // sign bit where facing < 0
+            scale = _mm_xor_ps(scale, flip);
+        }
+        nx = _mm_mul_ps(nx, scale); ny = _mm_mul_ps(ny, scale); nz = _mm_mul_ps(nz, scale);
+
+        // SoA -> AoS
+        float x[4], y[4], z[4];
+        _mm_storeu_ps(x, nx); _mm_storeu_ps(y, ny); _mm_storeu_ps(z, nz);
+        float *o = out + (size_t)t * 3 * copies;
+        for (int i = 0; i < 4; i++) {
+            for (int c = 0; c < copies; c++) {
+                o[(i * copies + c) * 3] = x[i]; o[(i * copies + c) * 3 + 1] = y[i]; o[(i * copies + c) * 3 + 2] = z[i];
+            }
+        }
+    }
+    faceNormalsScalar(positions, t, end, out, copies, awayFrom);
+}
+#endif
+
+// the SIMD kernel where compiled in, otherwise the scalar one
+inline void faceNormalsKernel(const float *positions, int begin, int end, float *out, int copies, const glm::vec3 *awayFrom)
+{
+#ifdef NORMALS_SSE
+    faceNormalsSSE(positions, begin, end, out, copies, awayFrom);
+#else
+    faceNormalsScalar(positions, begin, end, out, copies, awayFrom);
+#endif
+}
+
+// all triangles, in parallel chunks
+inline void computeFaceNormals(const float *positions, int triangleCount, float *out, int copies = 1,
+                               const glm::vec3 *awayFrom = NULL)
+{
+    parallelFor(0, triangleCount, 4096, [=](int begin, int end) {
+        faceNormalsKernel(positions, begin, end, out, copies, awayFrom);
+    });
+}
+
+#endif
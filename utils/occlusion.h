@@ -0,0 +1,405 @@
+// occlusion.h
+//
+// Software occlusion culling on the CPU, GL independent.
+// A few large occluders (walls, buildings, the big model in front) are rasterized into a small
+// depth buffer; then the screen rectangle of every drawable's box is tested against it, and a
+// box whose nearest point is behind every occluder pixel it covers is not submitted.
+//
+//     OcclusionBuffer occlusion;                  // 256 x 128
+//     occlusion.clear();
+//     occlusion.addOccluder(wallMesh, projection * view * wallModel);
+//     occlusion.rasterize();                      // bands of tiles in parallel, 4 pixels per SSE op
+//     occlusion.testBoxes(&worldBoxes[0], count, projection * view, &visible[0]);
+//
+// Depth is NDC z mapped to [0, 1], smaller is nearer. Occluder triangles are clipped at the near
+// plane. Boxes that cross the near plane or lie off screen count as visible (frustum culling is
+// for those). rasterize() and testBoxes() record the counts and their time in drawStats().
+
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+#include "draw_stats.h"
+#include "parallel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OCCLUSION_SSE 1
+#include <emmintrin.h>
+#endif
+
+// CPU copy of an occluder's triangles: usually a coarse stand-in that lies inside the real mesh
+struct OccluderMesh
+{
+    std::vector<glm::vec3> positions;
+    std::vector<unsigned int> indices;
+
+    static OccluderMesh box(const AABB &box)
+    {
+        static const unsigned int faces[36] = {
+            0, 1, 3, 0, 3, 2,  4, 6, 7, 4, 7, 5,  0, 4, 5, 0, 5, 1,
+            2, 3, 7, 2, 7, 6,  0, 2, 6, 0, 6, 4,  1, 5, 7, 1, 7, 3 };
+        OccluderMesh mesh;
+        for (int i = 0; i < 8; i++) {
+            mesh.positions.push_back(glm::vec3(i & 4 ? box.max.x : box.min.x, i & 2 ? box.max.y : box.min.y, i & 1 ? box.max.z : box.min.z));
+        }
+        mesh.indices.assign(faces, faces + 36);
+        return mesh;
+    }
+};
+
+// a triangle in pixel coordinates: inside where all three edge functions a*x + b*y + c are >= 0,
+// depth z = zx * x + zy * y + z0
+struct OcclusionTriangle
+{
+    float a[3], b[3], c[3];
+    float zx, zy, z0;
+    int minX, maxX, minY, maxY;
+};
+
+// screen rectangle (pixels) and nearest depth of a projected box
+struct OcclusionRect
+{
+    float minX, minY, maxX, maxY, nearest;
+};
+
+// false when a corner is behind the near plane (no usable rectangle)
+inline bool projectBoxScalar(const AABB &box, const glm::mat4 &viewProjection, float width, float height, OcclusionRect &rect)
+{
+    rect.minX = rect.minY = rect.nearest = 1e30f;
+    rect.maxX = rect.maxY = -1e30f;
+    for (int i = 0; i < 8; i++) {
+        glm::vec4 p = viewProjection * glm::vec4(i & 4 ? box.max.x : box.min.x, i & 2 ? box.max.y : box.min.y, i & 1 ? box.max.z : box.min.z, 1.0f);
+        if (p.w <= 1e-6f || p.z < -p.w) return false;
+        float inverseW = 1.0f / p.w;
+        float x = (p.x * inverseW * 0.5f + 0.5f) * width, y = (p.y * inverseW * 0.5f + 0.5f) * height;
+        rect.minX = std::min(rect.minX, x); rect.maxX = std::max(rect.maxX, x);
+        rect.minY = std::min(rect.minY, y); rect.maxY = std::max(rect.maxY, y);
+        rect.nearest = std::min(rect.nearest, p.z * inverseW * 0.5f + 0.5f);
+    }
+    return true;
+}
+
+// pixels [begin, end) of row y (pixel centres at +0.5) covered by the triangle take the nearer depth
+inline void rasterizeSpanScalar(const OcclusionTriangle &t, int y, int begin, int end, float *row)
+{
+    float py = y + 0.5f;
+    for (int x = begin; x < end; x++) {
+        float px = x + 0.5f;
+        // summed in the order of the SSE kernel, so both give the same result
+        if (t.a[0] * px + (t.b[0] * py + t.c[0]) < 0.0f || t.a[1] * px + (t.b[1] * py + t.c[1]) < 0.0f ||
+            t.a[2] * px + (t.b[2] * py + t.c[2]) < 0.0f) continue;
+        row[x] = std::min(row[x], t.zx * px + (t.zy * py + t.z0));
+    }
+}
+
+// true if any of the pixels [begin, end) is at depth or further back
+inline bool anyDepthBehindScalar(const float *row, int begin, int end, float depth)
+{
+    for (int x = begin; x < end; x++) {
+        if (row[x] >= depth) return true;
+    }
+    return false;
+}
+
+#ifdef OCCLUSION_SSE
+// as rasterizeSpanScalar, four pixels at a time; begin is rounded down to a multiple of 4 and
+// end up, so the row must be padded to a multiple of 4 (pixels outside the triangle are untouched)
+inline void rasterizeSpanSSE(const OcclusionTriangle &t, int y, int begin, int end, float *row)
+{
+    float py = y + 0.5f;
+    begin &= ~3;
+    const __m128 lanes = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 a0 = _mm_set1_ps(t.a[0]), a1 = _mm_set1_ps(t.a[1]), a2 = _mm_set1_ps(t.a[2]), zx = _mm_set1_ps(t.zx);
+    __m128 rowC0 = _mm_set1_ps(t.b[0] * py + t.c[0]), rowC1 = _mm_set1_ps(t.b[1] * py + t.c[1]);
+    __m128 rowC2 = _mm_set1_ps(t.b[2] * py + t.c[2]), rowZ = _mm_set1_ps(t.zy * py + t.z0);
+    for (int x = begin; x < end; x += 4) {
+        __m128 px = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+        __m128 inside = _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), rowC0), zero),
+                                   _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), rowC1), zero));
+        inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), rowC2), zero));
+        if (_mm_movemask_ps(inside) == 0) continue;
+        __m128 old = _mm_loadu_ps(row + x);
+        __m128 nearer = _mm_min_ps(old, _mm_add_ps(_mm_mul_ps(zx, px), rowZ));
+        _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+    }
+}
+
+// as projectBoxScalar, the eight corners as two groups of four lanes (x = min.x, x = max.x)
+inline bool projectBoxSSE(const AABB &box, const glm::mat4 &viewProjection, float width, float height, OcclusionRect &rect)
+{
+    const float *m = &viewProjection[0][0];
+    __m128 y = _mm_set_ps(box.max.y, box.max.y, box.min.y, box.min.y), z = _mm_set_ps(box.max.z, box.min.z, box.max.z, box.min.z);
+    __m128 clip[2][4];      // [group][x, y, z, w]
+    for (int c = 0; c < 4; c++) {
+        __m128 shared = _mm_add_ps(_mm_mul_ps(y, _mm_set1_ps(m[4 + c])), _mm_mul_ps(z, _mm_set1_ps(m[8 + c])));
+        clip[0][c] = _mm_add_ps(shared, _mm_set1_ps(m[12 + c] + box.min.x * m[c]));
+        clip[1][c] = _mm_add_ps(shared, _mm_set1_ps(m[12 + c] + box.max.x * m[c]));
+    }
+    const __m128 half = _mm_set1_ps(0.5f), epsilon = _mm_set1_ps(1e-6f);
+    __m128 behind = _mm_or_ps(_mm_or_ps(_mm_cmple_ps(clip[0][3], epsilon), _mm_cmple_ps(clip[1][3], epsilon)),
+                              _mm_or_ps(_mm_cmplt_ps(_mm_add_ps(clip[0][2], clip[0][3]), _mm_setzero_ps()),
+                                        _mm_cmplt_ps(_mm_add_ps(clip[1][2], clip[1][3]), _mm_setzero_ps())));
+    if (_mm_movemask_ps(behind) != 0) return false;
+    __m128 minimum[3], maximum[3];
+    for (int g = 0; g < 2; g++) {
+        __m128 inverseW = _mm_div_ps(_mm_set1_ps(1.0f), clip[g][3]);
+        for (int c = 0; c < 3; c++) {
+            __m128 ndc = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(clip[g][c], inverseW), half), half);
+            minimum[c] = g == 0 ? ndc : _mm_min_ps(minimum[c], ndc);
+            maximum[c] = g == 0 ? ndc : _mm_max_ps(maximum[c], ndc);
+        }
+    }
+    float lowest[3], highest[3];
+    for (int c = 0; c < 3; c++) {
+        __m128 low = _mm_min_ps(minimum[c], _mm_shuffle_ps(minimum[c], minimum[c], _MM_SHUFFLE(1, 0, 3, 2)));
+        low = _mm_min_ps(low, _mm_shuffle_ps(low, low, _MM_SHUFFLE(2, 3, 0, 1)));
+        __m128 high = _mm_max_ps(maximum[c], _mm_shuffle_ps(maximum[c], maximum[c], _MM_SHUFFLE(1, 0, 3, 2)));
+        high = _mm_max_ps(high, _mm_shuffle_ps(high, high, _MM_SHUFFLE(2, 3, 0, 1)));
+        lowest[c] = _mm_cvtss_f32(low);
+        highest[c] = _mm_cvtss_f32(high);
+    }
+    rect.minX = lowest[0] * width; rect.maxX = highest[0] * width;
+    rect.minY = lowest[1] * height; rect.maxY = highest[1] * height;
+    rect.nearest = lowest[2];
+    return true;
+}
+
+inline bool anyDepthBehindSSE(const float *row, int begin, int end, float depth)
+{
+    __m128 limit = _mm_set1_ps(depth);
+    int x = begin;
+    for (; x + 4 <= end; x += 4) {
+        if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), limit)) != 0) return true;
+    }
+    return anyDepthBehindScalar(row, x, end, depth);
+}
+#endif
+
+// the SIMD kernels where compiled in, otherwise the scalar ones
+inline void rasterizeSpanKernel(const OcclusionTriangle &t, int y, int begin, int end, float *row)
+{
+#ifdef OCCLUSION_SSE
+    rasterizeSpanSSE(t, y, begin, end, row);
+#else
+    rasterizeSpanScalar(t, y, begin, end, row);
+#endif
+}
+
+inline bool projectBoxKernel(const AABB &box, const glm::mat4 &viewProjection, float width, float height, OcclusionRect &rect)
+{
+#ifdef OCCLUSION_SSE
+    return projectBoxSSE(box, viewProjection, width, height, rect);
+#else
+    return projectBoxScalar(box, viewProjection, width, height, rect);
+#endif
+}
+
+inline bool anyDepthBehindKernel(const float *row, int begin, int end, float depth)
+{
+#ifdef OCCLUSION_SSE
+    return anyDepthBehindSSE(row, begin, end, depth);
+#else
+    return anyDepthBehindScalar(row, begin, end, depth);
+#endif
+}
+
+class OcclusionBuffer
+{
+public:
+    // a tile row is the unit of parallel rasterization; a tile's farthest depth lets the tests
+    // skip the pixels of fully covered tiles
+    enum { TILE_WIDTH = 32, TILE_HEIGHT = 16 };
+
+    bool simd = true;       // off: the scalar kernels (for comparison)
+
+    // rounded up to whole tiles
+    OcclusionBuffer(int width = 256, int height = 128)
+    {
+        tilesX = std::max(1, (width + TILE_WIDTH - 1) / TILE_WIDTH);
+        tilesY = std::max(1, (height + TILE_HEIGHT - 1) / TILE_HEIGHT);
+        this->width = tilesX * TILE_WIDTH;
+        this->height = tilesY * TILE_HEIGHT;
+        depth.assign(this->width * this->height, 1.0f);
+        tileFarthest.assign(tilesX * tilesY, 1.0f);
+    }
+
+    // drops the occluders and the depth of the last frame
+    void clear()
+    {
+        triangles.clear();
+        std::fill(depth.begin(), depth.end(), 1.0f);
+        std::fill(tileFarthest.begin(), tileFarthest.end(), 1.0f);
+    }
+
+    void addOccluder(const OccluderMesh &mesh, const glm::mat4 &modelViewProjection)
+    {
+        if (mesh.positions.empty() || mesh.indices.empty()) return;
+        addOccluder(&mesh.positions[0], (int)mesh.positions.size(), &mesh.indices[0], (int)mesh.indices.size(), modelViewProjection);
+    }
+
+    // triangles (3 indices each) in model space; only set up here, drawn by rasterize()
+    void addOccluder(const glm::vec3 *positions, int vertexCount, const unsigned int *indices, int indexCount, const glm::mat4 &modelViewProjection)
+    {
+        clipSpace.resize(vertexCount);
+        for (int i = 0; i < vertexCount; i++) clipSpace[i] = modelViewProjection * glm::vec4(positions[i], 1.0f);
+
+        for (int i = 0; i + 2 < indexCount; i += 3) {
+            glm::vec4 corner[3] = { clipSpace[indices[i]], clipSpace[indices[i + 1]], clipSpace[indices[i + 2]] };
+            // clip at the near plane (z >= -w): up to 4 corners, drawn as a fan
+            glm::vec4 polygon[4];
+            int count = 0;
+            for (int k = 0; k < 3; k++) {
+                const glm::vec4 &p = corner[k], &q = corner[(k + 1) % 3];
+                float dp = p.z + p.w, dq = q.z + q.w;
+                if (dp >= 0.0f) polygon[count++] = p;
+                if ((dp >= 0.0f) != (dq >= 0.0f)) polygon[count++] = p + (q - p) * (dp / (dp - dq));
+            }
+            for (int k = 1; k + 1 < count; k++) addTriangle(polygon[0], polygon[k], polygon[k + 1]);
+        }
+    }
+
+    // draws the occluders added since clear()
+    void rasterize()
+    {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        if (!triangles.empty()) {
+            parallelFor(0, tilesY, 1, [&](int begin, int end) {
+                for (int band = begin; band < end; band++) rasterizeBand(band);
+            });
+        }
+        drawStats().occlusionMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // false when the world-space box is hidden behind the occluders (valid after rasterize())
+    bool isVisible(const AABB &box, const glm::mat4 &viewProjection) const
+    {
+        OcclusionRect rect;
+        if (!(simd ? projectBoxKernel(box, viewProjection, (float)width, (float)height, rect) :
+                     projectBoxScalar(box, viewProjection, (float)width, (float)height, rect))) return true;
+        float nearest = rect.nearest;
+        // every pixel the rectangle touches and one more around: occluders cover the pixels whose
+        // centre they cover, up to half a pixel more than their real outline
+        int x0 = (int)std::max(0.0f, std::floor(rect.minX) - 1.0f), x1 = (int)std::min(width - 1.0f, std::floor(rect.maxX) + 1.0f);
+        int y0 = (int)std::max(0.0f, std::floor(rect.minY) - 1.0f), y1 = (int)std::min(height - 1.0f, std::floor(rect.maxY) + 1.0f);
+        if (x0 > x1 || y0 > y1) return true;
+
+        for (int ty = y0 / TILE_HEIGHT; ty <= y1 / TILE_HEIGHT; ty++) {
+            for (int tx = x0 / TILE_WIDTH; tx <= x1 / TILE_WIDTH; tx++) {
+                if (tileFarthest[ty * tilesX + tx] < nearest) continue;
+                int rowBegin = std::max(x0, tx * TILE_WIDTH), rowEnd = std::min(x1 + 1, (tx + 1) * TILE_WIDTH);
+                int yEnd = std::min(y1 + 1, (ty + 1) * TILE_HEIGHT);
+                for (int y = std::max(y0, ty * TILE_HEIGHT); y < yEnd; y++) {
+                    const float *row = &depth[y * width];
+                    if (simd ? anyDepthBehindKernel(row, rowBegin, rowEnd, nearest) : anyDepthBehindScalar(row, rowBegin, rowEnd, nearest)) return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // visible[i] = 1 or 0 for boxes[i], in parallel; returns the visible count
+    int testBoxes(const AABB *boxes, int count, const glm::mat4 &viewProjection, unsigned char *visible) const
+    {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        std::atomic<int> visibleCount(0);
+        parallelFor(0, count, 1024, [&](int begin, int end) {
+            int chunkVisible = 0;
+            for (int i = begin; i < end; i++) {
+                visible[i] = isVisible(boxes[i], viewProjection) ? 1 : 0;
+                chunkVisible += visible[i];
+            }
+            visibleCount += chunkVisible;
+        });
+        DrawStats &stats = drawStats();
+        stats.occlusionTested += count;
+        stats.occluded += count - visibleCount;
+        stats.occlusionMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        return visibleCount;
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int triangleCount() const { return (int)triangles.size(); }
+
+    // row-major, width * height
+    const float *getDepth() const
+    {
+        return &depth[0];
+    }
+
+private:
+    int width, height, tilesX, tilesY;
+    std::vector<float> depth;
+    std::vector<float> tileFarthest;
+    std::vector<OcclusionTriangle> triangles;
+    std::vector<glm::vec4> clipSpace;
+
+    void addTriangle(const glm::vec4 &p0, const glm::vec4 &p1, const glm::vec4 &p2)
+    {
+        const glm::vec4 *clip[3] = { &p0, &p1, &p2 };
+        float x[3], y[3], z[3];
+        for (int k = 0; k < 3; k++) {
+            float w = std::max(clip[k]->w, 1e-6f);
+            x[k] = (clip[k]->x / w * 0.5f + 0.5f) * width;
+            y[k] = (clip[k]->y / w * 0.5f + 0.5f) * height;
+            z[k] = std::max(0.0f, clip[k]->z / w * 0.5f + 0.5f);
+        }
+        float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+        if (std::fabs(area) < 1e-8f) return;
+        if (area < 0.0f) {
+            std::swap(x[1], x[2]); std::swap(y[1], y[2]); std::swap(z[1], z[2]);
+            area = -area;
+        }
+
+        OcclusionTriangle t;
+        t.minX = std::max(0, (int)std::floor(std::min(x[0], std::min(x[1], x[2]))));
+        t.maxX = std::min(width - 1, (int)std::floor(std::max(x[0], std::max(x[1], x[2]))));
+        t.minY = std::max(0, (int)std::floor(std::min(y[0], std::min(y[1], y[2]))));
+        t.maxY = std::min(height - 1, (int)std::floor(std::max(y[0], std::max(y[1], y[2]))));
+        if (t.minX > t.maxX || t.minY > t.maxY) return;
+        for (int k = 0; k < 3; k++) {
+            int next = (k + 1) % 3;
+            t.a[k] = y[k] - y[next];
+            t.b[k] = x[next] - x[k];
+            t.c[k] = x[k] * y[next] - y[k] * x[next];
+        }
+        t.zx = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+        t.zy = ((z[2] - z[0]) * (x[1] - x[0]) - (z[1] - z[0]) * (x[2] - x[0])) / area;
+        // the farthest depth of the triangle inside the pixel rather than the one at its centre
+        t.z0 = z[0] - t.zx * x[0] - t.zy * y[0] + 0.5f * (std::fabs(t.zx) + std::fabs(t.zy));
+        triangles.push_back(t);
+    }
+
+    // one row of tiles: only this call writes its rows, so bands run in parallel without locks
+    void rasterizeBand(int band)
+    {
+        int bandBegin = band * TILE_HEIGHT, bandEnd = bandBegin + TILE_HEIGHT;
+        for (size_t i = 0; i < triangles.size(); i++) {
+            const OcclusionTriangle &t = triangles[i];
+            int yBegin = std::max(bandBegin, t.minY), yEnd = std::min(bandEnd, t.maxY + 1);
+            for (int y = yBegin; y < yEnd; y++) {
+                if (simd) rasterizeSpanKernel(t, y, t.minX, t.maxX + 1, &depth[y * width]);
+                else rasterizeSpanScalar(t, y, t.minX, t.maxX + 1, &depth[y * width]);
+            }
+        }
+        for (int tx = 0; tx < tilesX; tx++) {
+            float farthest = 0.0f;
+            for (int y = bandBegin; y < bandEnd; y++) {
+                const float *row = &depth[y * width + tx * TILE_WIDTH];
+                for (int x = 0; x < TILE_WIDTH; x++) farthest = std::max(farthest, row[x]);
+            }
+            tileFarthest[band * tilesX + tx] = farthest;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,89 @@
+// octahedral.h
+//
+// Octahedral mapping between unit directions and the unit square, GL independent.
+// The sphere is projected onto an octahedron and the octahedron unfolded into [0, 1]^2: the +y
+// pole is the centre of the square, the -y pole its four corners. An impostor atlas
+// (impostor.h) keeps one view of the model per point of a gridSize x gridSize lattice on it;
+// octahedralFrames() finds the three views around a direction and their blend weights.
+//
+//     OctahedralFrames frames = octahedralFrames(directionToCamera, 8);
+//     for (int k = 0; k < 3; k++) ... frame (frames.x[k], frames.y[k]) weighted frames.weight[k] ...
+//
+// impostor.vs does the same in GLSL; keep the two in step.
+
+#ifndef OCTAHEDRAL_H
+#define OCTAHEDRAL_H
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+// unit direction -> [0, 1]^2
+inline glm::vec2 octahedralEncode(const glm::vec3 &direction)
+{
+    glm::vec3 d = direction / (std::fabs(direction.x) + std::fabs(direction.y) + std::fabs(direction.z));
+    glm::vec2 p(d.x, d.z);
+    if (d.y < 0.0f) {
+        p = glm::vec2((1.0f - std::fabs(d.z)) * (d.x >= 0.0f ? 1.0f : -1.0f), (1.0f - std::fabs(d.x)) * (d.z >= 0.0f ? 1.0f : -1.0f));
+    }
+    return p * 0.5f + 0.5f;
+}
+
+// [0, 1]^2 -> unit direction
+inline glm::vec3 octahedralDecode(const glm::vec2 &uv)
+{
+    glm::vec2 p = uv * 2.0f - 1.0f;
+    glm::vec3 d(p.x, 1.0f - std::fabs(p.x) - std::fabs(p.y), p.y);
+    if (d.y < 0.0f) {
+        d.x = (1.0f - std::fabs(p.y)) * (p.x >= 0.0f ? 1.0f : -1.0f);
+        d.z = (1.0f - std::fabs(p.x)) * (p.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return glm::normalize(d);
+}
+
+// direction of the view stored at lattice point (x, y), 0 <= x, y < gridSize
+inline glm::vec3 octahedralFrameDirection(int x, int y, int gridSize)
+{
+    return octahedralDecode(glm::vec2((float)x, (float)y) / (float)(gridSize - 1));
+}
+
+// the three lattice points of the triangle (half a grid cell) around a direction, with
+// barycentric weights summing to 1
+struct OctahedralFrames
+{
+    int x[3], y[3];
+    float weight[3];
+};
+
+inline OctahedralFrames octahedralFrames(const glm::vec3 &direction, int gridSize)
+{
+    glm::vec2 grid = octahedralEncode(direction) * (float)(gridSize - 1);
+    int baseX = std::min(gridSize - 2, std::max(0, (int)std::floor(grid.x)));
+    int baseY = std::min(gridSize - 2, std::max(0, (int)std::floor(grid.y)));
+    float fx = grid.x - baseX, fy = grid.y - baseY;
+
+    OctahedralFrames frames;
+    if (fx + fy <= 1.0f) {
+        frames.x[0] = baseX;     frames.y[0] = baseY;     frames.weight[0] = 1.0f - fx - fy;
+        frames.x[1] = baseX + 1; frames.y[1] = baseY;     frames.weight[1] = fx;
+        frames.x[2] = baseX;     frames.y[2] = baseY + 1; frames.weight[2] = fy;
+    }
+    else {
+        frames.x[0] = baseX + 1; frames.y[0] = baseY + 1; frames.weight[0] = fx + fy - 1.0f;
+        frames.x[1] = baseX;     frames.y[1] = baseY + 1; frames.weight[1] = 1.0f - fx;
+        frames.x[2] = baseX + 1; frames.y[2] = baseY;     frames.weight[2] = 1.0f - fy;
+    }
+    return frames;
+}
+
+// the right and up axes of the camera that looks at the model from direction (glm::lookAt with
+// +y up, +z near the poles); view-space x and y of a model-space point p are dot(p, right), dot(p, up)
+inline void octahedralFrameAxes(const glm::vec3 &direction, glm::vec3 &right, glm::vec3 &up)
+{
+    glm::vec3 hint = std::fabs(direction.y) > 0.999f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    right = glm::normalize(glm::cross(-direction, hint));
+    up = glm::cross(right, -direction);
+}
+
+#endif
@@ -0,0 +1,170 @@
+// parallel.h
+//
+// A persistent worker pool and a chunked parallelFor on top of it.
+// The workers are started once (ThreadPool::instance() uses one per hardware thread) and sleep
+// between jobs; a parallelFor call hands out [begin, end) in chunks of `grain` items, runs chunks
+// on the calling thread as well, and returns when every chunk is done. Submitting a job does not
+// allocate: the body is passed by pointer, not wrapped in a std::function.
+//
+//     parallelFor(0, count, 1024, [&](int begin, int end) {
+//         for (int i = begin; i < end; i++) out[i] = work(in[i]);
+//     });
+//
+// Jobs run one at a time. A parallelFor issued from inside a job body runs serially on that thread.
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+
+    static ThreadPool &instance()
+    {
+        static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+        return pool;
+    }
+
+    // threads counts the calling thread, so ThreadPool(1) starts no workers
+    explicit ThreadPool(unsigned int threads)
+    {
+        for (unsigned int i = 1; i < threads; i++)
+            workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+    }
+
+    int threadCount() const
+    {
+        return (int)workers.size() + 1;
+    }
+
+    // calls body(chunkBegin, chunkEnd) for consecutive chunks covering [begin, end)
+    template <typename Body>
+    void parallelFor(int begin, int end, int grain, const Body &body)
+    {
+        if (end <= begin) return;
+        if (grain < 1) grain = 1;
+        int chunks = (end - begin + grain - 1) / grain;
+        if (chunks == 1 || workers.empty() || insideJob()) {
+            body(begin, end);
+            return;
+        }
+
+        std::lock_guard<std::mutex> serialize(submitMutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job.run = &invoke<Body>;
+            job.body = &body;
+            job.begin = begin;
+            job.end = end;
+            job.grain = grain;
+            job.chunks = chunks;
+            nextChunk = 0;
+            pendingChunks = chunks;
+            generation++;
+        }
+        wake.notify_all();
+
+        insideJob() = true;
+        runChunks();
+        insideJob() = false;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pendingChunks == 0 && activeWorkers == 0; });
+        job.body = NULL;
+    }
+
+private:
+    struct Job
+    {
+        void (*run)(const void *body, int begin, int end) = NULL;
+        const void *body = NULL;
+        int begin = 0, end = 0, grain = 1, chunks = 0;
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex submitMutex;     // one job at a time
+    std::mutex mutex;           // guards job, generation, activeWorkers, stopping
+    std::condition_variable wake, done;
+    Job job;
+    unsigned int generation = 0;
+    int activeWorkers = 0;
+    bool stopping = false;
+    std::atomic<int> nextChunk { 0 };
+    std::atomic<int> pendingChunks { 0 };
+
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+
+    template <typename Body>
+    static void invoke(const void *body, int begin, int end)
+    {
+        (*static_cast<const Body *>(body))(begin, end);
+    }
+
+    static bool &insideJob()
+    {
+        static thread_local bool inside = false;
+        return inside;
+    }
+
+    void runChunks()
+    {
+        for (;;) {
+            int chunk = nextChunk.fetch_add(1);
+            if (chunk >= job.chunks) return;
+            int chunkBegin = job.begin + chunk * job.grain;
+            job.run(job.body, chunkBegin, std::min(chunkBegin + job.grain, job.end));
+            if (pendingChunks.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.notify_all();
+            }
+        }
+    }
+
+    void workerLoop()
+    {
+        insideJob() = true;
+        unsigned int seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || (generation != seen && job.body != NULL); });
+                if (stopping) return;
+                seen = generation;
+                activeWorkers++;
+            }
+            runChunks();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                activeWorkers--;
+            }
+            done.notify_all();
+        }
+    }
+};
+
+// parallelFor on the shared pool
+template <typename Body>
+void parallelFor(int begin, int end, int grain, const Body &body)
+{
+    ThreadPool::instance().parallelFor(begin, end, grain, body);
+}
+
+#endif
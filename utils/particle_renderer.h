@@ -0,0 +1,97 @@
+// particle_renderer.h
+//
+// Draws a ParticlePool (particles.h) as point sprites: one streaming buffer and one
+// glDrawArrays(GL_POINTS) call per pool, i.e. per kind of particle. The pool writes its vertices
+// straight into the mapped buffer.
+//
+//     ParticleRenderer *renderer = new ParticleRenderer();
+//     renderer->draw(particleShader, bullets, glm::vec4(1.0f, 0.9f, 0.4f, 1.0f), glm::vec4(1.0f, 0.2f, 0.0f, 0.0f), 0.05f);
+//
+// The colour fades from startColor to endColor over a particle's life; size is the world-space
+// diameter of a sprite. Particles are drawn blended, without writing depth.
+// Vertex shader: particle.vs (0: position and age / lifetime (vec4))
+// Fragment shader: particle.fs
+
+#ifndef PARTICLE_RENDERER_H
+#define PARTICLE_RENDERER_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "shader.h"
+#include "particles.h"
+#include "draw_stats.h"
+
+class ParticleRenderer
+{
+public:
+    ParticleRenderer() : capacity(0)
+    {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    ~ParticleRenderer()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+    }
+
+    // the shader's view / projection are the caller's
+    void draw(Shader *shader, ParticlePool &pool, const glm::vec4 &startColor, const glm::vec4 &endColor, float size)
+    {
+        int count = pool.size();
+        if (count == 0) return;
+
+        // fresh storage every frame (orphaned, as InstanceBuffer::upload) written in place by the pool
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        if (count > capacity) capacity = count + count / 2;
+        glBufferData(GL_ARRAY_BUFFER, capacity * 4 * sizeof(float), NULL, GL_STREAM_DRAW);
+        float *vertices = (float *)glMapBufferRange(GL_ARRAY_BUFFER, 0, count * 4 * sizeof(float),
+                                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (vertices == NULL) {
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            return;
+        }
+        pool.writeVertices(vertices);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        shader->use();
+        shader->setVec4("startColor", startColor);
+        shader->setVec4("endColor", endColor);
+        shader->setFloat("pointSize", size);
+        shader->setFloat("viewportHeight", (float)viewport[3]);
+
+        GLboolean blend = glIsEnabled(GL_BLEND), depthWrite;
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &depthWrite);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
+        glEnable(GL_PROGRAM_POINT_SIZE);
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_POINTS, 0, count);
+        glBindVertexArray(0);
+        glDisable(GL_PROGRAM_POINT_SIZE);
+        glDepthMask(depthWrite);
+        if (!blend) glDisable(GL_BLEND);
+        drawStats().add(count, 0);
+    }
+
+private:
+    unsigned int VAO, VBO;
+    int capacity;
+
+    ParticleRenderer(const ParticleRenderer &);
+    ParticleRenderer &operator=(const ParticleRenderer &);
+};
+
+#endif
@@ -0,0 +1,306 @@
+// particles.h
+//
+// Particle simulation for projectiles and effects, GL independent.
+// A ParticlePool is one kind of particle (bullets, sparks, smoke ...) with a fixed capacity: its
+// state is separate arrays per component allocated once, the live particles packed at the
+// front. Each frame
+//   - emit() appends particles (in parallel, each one's random numbers hashed from its index),
+//   - update() moves them under gravity and drag and ages them: chunks in parallel (parallel.h),
+//     4 particles per SSE instruction inside a chunk where available,
+//   - the same update() keeps the live particles packed: the kernels list the ones that expire,
+//     and the last live particles move into their places, so compaction costs one copy per
+//     expired particle instead of a pass over the pool.
+// Nothing is allocated per particle; emitting into a full pool drops the rest of the emission.
+//
+//     ParticlePool bullets(100000);
+//     ParticleSpawn spawn;
+//     spawn.position = muzzle; spawn.velocity = direction * 40.0f; spawn.spread = 0.02f;
+//     bullets.emit(16, spawn);
+//     bullets.update(deltaTime);
+//     renderer->draw(shader, bullets);                  // particle_renderer.h, one draw call
+//
+// getStats() has the time of each stage of the last emit() / update() / writeVertices().
+
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "parallel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLES_SSE 1
+#include <emmintrin.h>
+#endif
+
+// what emit() gives the new particles
+struct ParticleSpawn
+{
+    glm::vec3 position = glm::vec3(0.0f);
+    float positionJitter = 0.0f;    // random offset up to this far on each axis
+    glm::vec3 velocity = glm::vec3(0.0f, 1.0f, 0.0f);
+    float spread = 0.1f;            // random velocity change, as a fraction of the speed, on each axis
+    float lifetime = 2.0f;          // seconds
+    float lifetimeJitter = 0.0f;    // up to this much shorter
+};
+
+// milliseconds of the stages of the last call of each
+struct ParticleStats
+{
+    int live = 0;
+    int emitted = 0, dropped = 0;   // by the last emit(): added, and not added for lack of room
+    int expired = 0;                // by the last update()
+    double emitMilliseconds = 0.0;
+    double integrateMilliseconds = 0.0;     // moving and ageing
+    double compactMilliseconds = 0.0;
+    double writeMilliseconds = 0.0;         // writeVertices()
+};
+
+// moves particles [begin, end) dt on and ages them; writes the indices of the ones that expired,
+// in order, to dead and returns their number
+inline int integrateParticlesScalar(float *x, float *y, float *z, float *vx, float *vy, float *vz, float *age, const float *lifetime,
+                                    int begin, int end, float dt, const glm::vec3 &gravity, float damping, int *dead)
+{
+    int expired = 0;
+    for (int i = begin; i < end; i++) {
+        vx[i] = vx[i] * damping + gravity.x * dt;
+        vy[i] = vy[i] * damping + gravity.y * dt;
+        vz[i] = vz[i] * damping + gravity.z * dt;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        z[i] += vz[i] * dt;
+        age[i] += dt;
+        if (!(age[i] < lifetime[i])) dead[expired++] = i;
+    }
+    return expired;
+}
+
+#ifdef PARTICLES_SSE
+// four particles at a time (the remainder goes through the scalar loop)
+inline int integrateParticlesSSE(float *x, float *y, float *z, float *vx, float *vy, float *vz, float *age, const float *lifetime,
+                                 int begin, int end, float dt, const glm::vec3 &gravity, float damping, int *dead)
+{
+    const __m128 step = _mm_set1_ps(dt), keep = _mm_set1_ps(damping);
+    const __m128 gx = _mm_set1_ps(gravity.x * dt), gy = _mm_set1_ps(gravity.y * dt), gz = _mm_set1_ps(gravity.z * dt);
+    int expired = 0;
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 nvx = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(vx + i), keep), gx);
+        __m128 nvy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(vy + i), keep), gy);
+        __m128 nvz = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(vz + i), keep), gz);
+        _mm_storeu_ps(vx + i, nvx);
+        _mm_storeu_ps(vy + i, nvy);
+        _mm_storeu_ps(vz + i, nvz);
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(nvx, step)));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(nvy, step)));
+        _mm_storeu_ps(z + i, _mm_add_ps(_mm_loadu_ps(z + i), _mm_mul_ps(nvz, step)));
+        __m128 older = _mm_add_ps(_mm_loadu_ps(age + i), step);
+        _mm_storeu_ps(age + i, older);
+        int mask = _mm_movemask_ps(_mm_cmplt_ps(older, _mm_loadu_ps(lifetime + i)));
+        if (mask == 15) continue;
+        for (int k = 0; k < 4; k++) {
+            if (!((mask >> k) & 1)) dead[expired++] = i + k;
+        }
+    }
+    return expired + integrateParticlesScalar(x, y, z, vx, vy, vz, age, lifetime, i, end, dt, gravity, damping, dead + expired);
+}
+#endif
+
+// the SIMD kernel where compiled in, otherwise the scalar one
+inline int integrateParticlesKernel(float *x, float *y, float *z, float *vx, float *vy, float *vz, float *age, const float *lifetime,
+                                    int begin, int end, float dt, const glm::vec3 &gravity, float damping, int *dead)
+{
+#ifdef PARTICLES_SSE
+    return integrateParticlesSSE(x, y, z, vx, vy, vz, age, lifetime, begin, end, dt, gravity, damping, dead);
+#else
+    return integrateParticlesScalar(x, y, z, vx, vy, vz, age, lifetime, begin, end, dt, gravity, damping, dead);
+#endif
+}
+
+class ParticlePool
+{
+public:
+    enum { CHUNK = 16384 };         // particles per parallel chunk of update()
+
+    glm::vec3 gravity = glm::vec3(0.0f, -9.81f, 0.0f);
+    float drag = 0.0f;              // velocity lost per second, as a fraction
+    bool simd = true;               // false: the scalar kernel (for comparison)
+
+    explicit ParticlePool(int capacity) : capacity(capacity), live(0), emissions(0),
+        x(capacity), y(capacity), z(capacity), vx(capacity), vy(capacity), vz(capacity), age(capacity), lifetime(capacity), dead(capacity)
+    {
+    }
+
+    // appends up to count particles; returns how many fitted
+    int emit(int count, const ParticleSpawn &spawn)
+    {
+        typedef std::chrono::high_resolution_clock Clock;
+        Clock::time_point start = Clock::now();
+        int first = live;
+        int added = std::max(0, std::min(count, capacity - live));
+        unsigned int seed = hash(++emissions * 0x9E3779B9u);
+        float speed = glm::length(spawn.velocity);
+        parallelFor(0, added, 4096, [&](int begin, int end) {
+            for (int k = begin; k < end; k++) {
+                int i = first + k;
+                unsigned int h = hash(seed ^ (unsigned int)k);
+                float r[7];
+                for (int j = 0; j < 7; j++) {
+                    h = hash(h);
+                    r[j] = (float)(h >> 8) * (2.0f / 16777216.0f) - 1.0f;     // [-1, 1)
+                }
+                x[i] = spawn.position.x + r[0] * spawn.positionJitter;
+                y[i] = spawn.position.y + r[1] * spawn.positionJitter;
+                z[i] = spawn.position.z + r[2] * spawn.positionJitter;
+                vx[i] = spawn.velocity.x + r[3] * spawn.spread * speed;
+                vy[i] = spawn.velocity.y + r[4] * spawn.spread * speed;
+                vz[i] = spawn.velocity.z + r[5] * spawn.spread * speed;
+                age[i] = 0.0f;
+                lifetime[i] = spawn.lifetime - (r[6] * 0.5f + 0.5f) * spawn.lifetimeJitter;
+            }
+        });
+        live += added;
+        stats.live = live;
+        stats.emitted = added;
+        stats.dropped = count - added;
+        stats.emitMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        return added;
+    }
+
+    // moves and ages every particle dt seconds, then fills the places of the expired ones with
+    // the last live particles (the order of the particles changes)
+    void update(float dt)
+    {
+        typedef std::chrono::high_resolution_clock Clock;
+        Clock::time_point start = Clock::now();
+        int chunks = (live + CHUNK - 1) / CHUNK;
+        chunkDead.assign(chunks, 0);
+        float damping = std::max(0.0f, 1.0f - drag * dt);
+        parallelFor(0, chunks, 1, [&](int begin, int end) {
+            for (int c = begin; c < end; c++) {
+                int first = c * CHUNK, last = std::min(live, first + CHUNK);
+                chunkDead[c] = simd ?
+                    integrateParticlesKernel(&x[0], &y[0], &z[0], &vx[0], &vy[0], &vz[0], &age[0], &lifetime[0], first, last, dt, gravity, damping, &dead[first]) :
+                    integrateParticlesScalar(&x[0], &y[0], &z[0], &vx[0], &vy[0], &vz[0], &age[0], &lifetime[0], first, last, dt, gravity, damping, &dead[first]);
+            }
+        });
+        Clock::time_point integrated = Clock::now();
+
+        // the chunks' lists of expired particles, joined in order at the front of dead
+        int expired = 0;
+        for (int c = 0; c < chunks; c++) {
+            std::copy(dead.begin() + c * CHUNK, dead.begin() + c * CHUNK + chunkDead[c], dead.begin() + expired);
+            expired += chunkDead[c];
+        }
+        // holes from the front, refilled from the back; expired particles at the back just drop off
+        int back = expired - 1, last = live - 1;
+        for (int h = 0; h <= back; h++) {
+            int hole = dead[h];
+            while (last > hole && back > h && dead[back] == last) {
+                back--;
+                last--;
+            }
+            if (last <= hole) break;
+            move(last, hole);
+            last--;
+        }
+        live -= expired;
+        stats.expired = expired;
+        stats.live = live;
+        Clock::time_point compacted = Clock::now();
+        stats.integrateMilliseconds = std::chrono::duration<double, std::milli>(integrated - start).count();
+        stats.compactMilliseconds = std::chrono::duration<double, std::milli>(compacted - integrated).count();
+    }
+
+    // 4 floats per live particle: position and age / lifetime (0 new, 1 about to expire), the
+    // vertex format of particle_renderer.h
+    void writeVertices(float *out)
+    {
+        typedef std::chrono::high_resolution_clock Clock;
+        Clock::time_point start = Clock::now();
+        parallelFor(0, live, 16384, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                out[i * 4] = x[i];
+                out[i * 4 + 1] = y[i];
+                out[i * 4 + 2] = z[i];
+                out[i * 4 + 3] = age[i] / lifetime[i];
+            }
+        });
+        stats.writeMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void clear()
+    {
+        live = 0;
+        stats.live = 0;
+    }
+
+    int size() const
+    {
+        return live;
+    }
+
+    int getCapacity() const
+    {
+        return capacity;
+    }
+
+    glm::vec3 getPosition(int i) const
+    {
+        return glm::vec3(x[i], y[i], z[i]);
+    }
+
+    glm::vec3 getVelocity(int i) const
+    {
+        return glm::vec3(vx[i], vy[i], vz[i]);
+    }
+
+    float getAge(int i) const
+    {
+        return age[i];
+    }
+
+    float getLifetime(int i) const
+    {
+        return lifetime[i];
+    }
+
+    const ParticleStats &getStats() const
+    {
+        return stats;
+    }
+
+private:
+    int capacity, live;
+    unsigned int emissions;
+    std::vector<float> x, y, z, vx, vy, vz, age, lifetime;
+    std::vector<int> dead;          // chunk c lists its expired particles at dead[c * CHUNK]
+    std::vector<int> chunkDead;
+    ParticleStats stats;
+
+    void move(int from, int to)
+    {
+        x[to] = x[from]; y[to] = y[from]; z[to] = z[from];
+        vx[to] = vx[from]; vy[to] = vy[from]; vz[to] = vz[from];
+        age[to] = age[from]; lifetime[to] = lifetime[from];
+    }
+
+    // integer hash (lowbias32)
+    static unsigned int hash(unsigned int x)
+    {
+        x ^= x >> 16; x *= 0x7feb352du;
+        x ^= x >> 15; x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    ParticlePool(const ParticlePool &);
+    ParticlePool &operator=(const ParticlePool &);
+};
+
+#endif
@@ -0,0 +1,446 @@
+// procedural.h
+//
+// GL-independent generators for the procedural primitives (cube, pyramid, bucket, paper sheets).
+// A generator only computes positions, normals, texture coordinates and indices and writes
+// them into a caller-supplied sink, so it can run on a worker thread or without a GL context.
+// Classes like Cube, Pyramid and Bucket only upload what a generator produced.
+//
+// A sink is any type with
+//     void begin(int vertexCount, int indexCount);   // called once, before any write, with exact counts
+//     void vertex(const glm::vec3 &position, const glm::vec3 &normal, const glm::vec2 &texcoord);
+//     void index(unsigned int i);
+// VectorSink (std::vector storage) and ArraySink (caller-owned memory such as an arena or a
+// mapped GPU buffer) are provided below.
+//
+// Triangle-list primitives (pyramid, bucket, paper) write no indices: every three vertices form
+// one triangle, matching the glDrawArrays(GL_TRIANGLES, ...) calls of the drawing classes.
+
+#ifndef PROCEDURAL_H
+#define PROCEDURAL_H
+
+#include <cmath>
+#include <vector>
+#include <iostream>
+
+#include <glm/glm.hpp>
+
+#include "half_edge.h"
+
+// -----------------------------------------------------------------------------
+// Shapes: every parameter that changes the generated geometry
+// -----------------------------------------------------------------------------
+
+struct CubeShape
+{
+    glm::vec3 offset = glm::vec3(0.0f);
+    float size = 1.0f;
+};
+
+struct PyramidShape
+{
+    float bottomLine = 1.0f;
+    float height = 1.0f;
+};
+
+struct BucketShape
+{
+    int topN = 12, bottomN = 6;                 // number of sides of top and bottom (topN = bottomN * ratio)
+    float topRadius = 1.0f, bottomRadius = 1.0f;
+    float topRatio = 1.0f, bottomRatio = 1.0f;  // depth / width of top and bottom
+    float height = 1.0f;
+    bool flatNormals = true;                    // false: smooth sides, each normal the normalized area-weighted
+                                                // average of the side faces around the vertex; caps stay flat
+};
+
+struct PaperShape
+{
+    float width = 1.0f, height = 1.0f;
+    int cols = 100, rows = 100;                 // boxes along x and y, each box is four triangles
+};
+
+struct ProceduralCounts
+{
+    int vertices;
+    int indices;
+};
+
+// -----------------------------------------------------------------------------
+// Sinks
+// -----------------------------------------------------------------------------
+
+// Owns its storage. positions/normals are 3 floats per vertex, texcoords 2 floats per vertex.
+struct VectorSink
+{
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> texcoords;
+    std::vector<unsigned int> indices;
+
+    void begin(int vertexCount, int indexCount)
+    {
+        positions.reserve(positions.size() + vertexCount * 3);
+        normals.reserve(normals.size() + vertexCount * 3);
+        texcoords.reserve(texcoords.size() + vertexCount * 2);
+        indices.reserve(indices.size() + indexCount);
+    }
+
+    void vertex(const glm::vec3 &p, const glm::vec3 &n, const glm::vec2 &t)
+    {
+        positions.push_back(p.x); positions.push_back(p.y); positions.push_back(p.z);
+        normals.push_back(n.x); normals.push_back(n.y); normals.push_back(n.z);
+        texcoords.push_back(t.x); texcoords.push_back(t.y);
+    }
+
+    void index(unsigned int i)
+    {
+        indices.push_back(i);
+    }
+
+    int vertexCount() const
+    {
+        return (int)positions.size() / 3;
+    }
+};
+
+// Writes into caller-owned arrays. Any of the pointers may be NULL to skip that attribute,
+// e.g. to regenerate only positions and normals of an animated mesh.
+struct ArraySink
+{
+    float *positions;
+    float *normals;
+    float *texcoords;
+    unsigned int *indices;
+    int vertexCapacity, indexCapacity;
+    int vertexCount = 0, indexCount = 0;
+    bool overflow = false;
+
+    ArraySink(float *positions, float *normals, float *texcoords, int vertexCapacity,
+              unsigned int *indices = NULL, int indexCapacity = 0)
+    {
+        this->positions = positions;
+        this->normals = normals;
+        this->texcoords = texcoords;
+        this->vertexCapacity = vertexCapacity;
+        this->indices = indices;
+        this->indexCapacity = indexCapacity;
+    }
+
+    void begin(int vertices, int indexes)
+    {
+        if (vertexCount + vertices > vertexCapacity || (indices != NULL && indexCount + indexes > indexCapacity)) {
+            std::cout << "ARRAYSINK: capacity too small for " << vertices << " vertices and " << indexes << " indices" << std::endl;
+            overflow = true;
+        }
+    }
+
+    void vertex(const glm::vec3 &p, const glm::vec3 &n, const glm::vec2 &t)
+    {
+        if (overflow) return;
+        if (positions) { positions[vertexCount * 3] = p.x; positions[vertexCount * 3 + 1] = p.y; positions[vertexCount * 3 + 2] = p.z; }
+        if (normals) { normals[vertexCount * 3] = n.x; normals[vertexCount * 3 + 1] = n.y; normals[vertexCount * 3 + 2] = n.z; }
+        if (texcoords) { texcoords[vertexCount * 2] = t.x; texcoords[vertexCount * 2 + 1] = t.y; }
+        vertexCount++;
+    }
+
+    void index(unsigned int i)
+    {
+        if (overflow || indices == NULL) return;
+        indices[indexCount++] = i;
+    }
+};
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+// unit normal of triangle abc, oriented away from the origin (the primitives are centered on it)
+inline glm::vec3 outwardNormal(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c)
+{
+    glm::vec3 n = glm::cross(b - a, c - a);
+    float length = glm::length(n);
+    if (length > 0.0f) n /= length;
+    return glm::dot(n, a) < 0.0f ? -n : n;
+}
+
+// unit normal of triangle abc following its winding (counter-clockwise is front)
+inline glm::vec3 windingNormal(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c)
+{
+    glm::vec3 n = glm::cross(b - a, c - a);
+    float length = glm::length(n);
+    return length > 0.0f ? n / length : n;
+}
+
+// topN / bottomN, or -1 when the two side counts cannot be stitched together
+inline int bucketRatio(int topN, int bottomN)
+{
+    if (bottomN <= 0 || topN < bottomN || topN % bottomN != 0) return -1;
+    return topN / bottomN;
+}
+
+inline int bucketTriangleCount(const BucketShape &shape)
+{
+    int ratio = bucketRatio(shape.topN, shape.bottomN);
+    return shape.topN + shape.bottomN + shape.bottomN * (ratio + 1);
+}
+
+inline ProceduralCounts cubeCounts(const CubeShape &)
+{
+    ProceduralCounts counts = { 24, 36 };
+    return counts;
+}
+
+inline ProceduralCounts pyramidCounts(const PyramidShape &)
+{
+    ProceduralCounts counts = { 6 * 3, 0 };
+    return counts;
+}
+
+inline ProceduralCounts bucketCounts(const BucketShape &shape)
+{
+    ProceduralCounts counts = { bucketTriangleCount(shape) * 3, 0 };
+    return counts;
+}
+
+inline ProceduralCounts paperCounts(const PaperShape &shape)
+{
+    ProceduralCounts counts = { shape.cols * shape.rows * 4 * 3, 0 };
+    return counts;
+}
+
+// Smoothing groups of the generated triangles, one id per triangle in generator order:
+// normals are only averaged inside a group, and subdivision keeps the edges between groups sharp.
+inline std::vector<int> bucketFaceGroups(const BucketShape &shape)
+{
+    std::vector<int> groups(bucketTriangleCount(shape), 2);     // sides
+    for (int i = 0; i < shape.topN; i++) groups[i] = 0;         // top polygon
+    for (int i = 0; i < shape.bottomN; i++) groups[shape.topN + i] = 1;
+    return groups;
+}
+
+inline std::vector<int> pyramidFaceGroups()
+{
+    int groups[6] = { 0, 0, 0, 0, 1, 1 };                       // 4 sides, then the base
+    return std::vector<int>(groups, groups + 6);
+}
+
+// -----------------------------------------------------------------------------
+// Cube: 24 vertices (4 per side) and 36 indices, see cube.h for the vertex naming
+// -----------------------------------------------------------------------------
+
+template <typename Sink>
+void generateCube(const CubeShape &shape, Sink &out)
+{
+    static const float positions[72] = {
+        .5f, .5f, .5f,  -.5f, .5f, .5f,  -.5f,-.5f, .5f,  .5f,-.5f, .5f, // v0,v1,v2,v3 (front)
+        .5f, .5f, .5f,   .5f,-.5f, .5f,   .5f,-.5f,-.5f,  .5f, .5f,-.5f, // v0,v3,v4,v5 (right)
+        .5f, .5f, .5f,   .5f, .5f,-.5f,  -.5f, .5f,-.5f, -.5f, .5f, .5f, // v0,v5,v6,v1 (top)
+        -.5f, .5f, .5f,  -.5f, .5f,-.5f,  -.5f,-.5f,-.5f, -.5f,-.5f, .5f, // v1,v6,v7,v2 (left)
+        -.5f,-.5f,-.5f,   .5f,-.5f,-.5f,   .5f,-.5f, .5f, -.5f,-.5f, .5f, // v7,v4,v3,v2 (bottom)
+        .5f,-.5f,-.5f,  -.5f,-.5f,-.5f,  -.5f, .5f,-.5f,  .5f, .5f,-.5f  // v4,v7,v6,v5 (back)
+    };
+    static const float normals[18] = { // one per side
+        0, 0, 1,   1, 0, 0,   0, 1, 0,   -1, 0, 0,   0,-1, 0,   0, 0,-1
+    };
+    static const float texcoords[48] = {
+        1, 0,   0, 0,   0, 1,   1, 1,               // v0,v1,v2,v3 (front)
+        0, 0,   0, 1,   1, 1,   1, 0,               // v0,v3,v4,v5 (right)
+        1, 1,   1, 0,   0, 0,   0, 1,               // v0,v5,v6,v1 (top)
+        1, 0,   0, 0,   0, 1,   1, 1,               // v1,v6,v7,v2 (left)
+        0, 1,   1, 1,   1, 0,   0, 0,               // v7,v4,v3,v2 (bottom)
+        0, 1,   1, 1,   1, 0,   0, 0                // v4,v7,v6,v5 (back)
+    };
+
+    out.begin(24, 36);
+    for (int i = 0; i < 24; i++) {
+        glm::vec3 p(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+        glm::vec3 n(normals[(i / 4) * 3], normals[(i / 4) * 3 + 1], normals[(i / 4) * 3 + 2]);
+        out.vertex(p * shape.size + shape.offset, n, glm::vec2(texcoords[i * 2], texcoords[i * 2 + 1]));
+    }
+    // two triangles per side: v0-v1-v2, v2-v3-v0
+    for (int side = 0; side < 6; side++) {
+        unsigned int base = side * 4;
+        out.index(base); out.index(base + 1); out.index(base + 2);
+        out.index(base + 2); out.index(base + 3); out.index(base);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Pyramid: 4 side triangles around the apex and 2 triangles for the bottom square
+// -----------------------------------------------------------------------------
+
+template <typename Sink>
+void generatePyramid(const PyramidShape &shape, Sink &out)
+{
+    // bottom corners in side order, as signs of x and z, with their texture coordinates
+    static const float corner[4][2] = { { -1.0f, -1.0f }, { +1.0f, -1.0f }, { +1.0f, +1.0f }, { -1.0f, +1.0f } };
+    static const float cornerUV[4][2] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+
+    float half = shape.bottomLine * 0.5f;
+    float top = shape.height * 0.5f;
+    glm::vec3 apex(0.0f, top, 0.0f);
+
+    out.begin(6 * 3, 0);
+    for (int side = 0; side < 4; side++) {
+        int next = (side + 1) % 4;
+        glm::vec3 b1(corner[side][0] * half, -top, corner[side][1] * half);
+        glm::vec3 b2(corner[next][0] * half, -top, corner[next][1] * half);
+        glm::vec3 n = outwardNormal(apex, b1, b2);
+        out.vertex(apex, n, glm::vec2(0.5f, 0.5f));
+        out.vertex(b1, n, glm::vec2(cornerUV[side][0], cornerUV[side][1]));
+        out.vertex(b2, n, glm::vec2(cornerUV[next][0], cornerUV[next][1]));
+    }
+    // bottom square: (-,-) -> (+,-) -> (+,+) and (-,-) -> (-,+) -> (+,+)
+    glm::vec3 down(0.0f, -1.0f, 0.0f);
+    for (int i = 0; i < 2; i++) {
+        float sign = i == 0 ? 1.0f : -1.0f;
+        out.vertex(glm::vec3(-half, -top, -half), down, glm::vec2(0.0f, 0.0f));
+        out.vertex(glm::vec3(sign * half, -top, -sign * half), down, glm::vec2(i == 0 ? 1.0f : 0.0f, i == 0 ? 0.0f : 1.0f));
+        out.vertex(glm::vec3(half, -top, half), down, glm::vec2(1.0f, 1.0f));
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Bucket: a top polygon, a bottom polygon and the sides stitching them together.
+// Each bottom edge is joined to `ratio` top edges by a fan of triangles.
+// -----------------------------------------------------------------------------
+
+template <typename Sink>
+void generateBucket(const BucketShape &shape, Sink &out)
+{
+    const float pi = 3.141592f;
+    int ratio = bucketRatio(shape.topN, shape.bottomN);
+    if (ratio < 1) {
+        std::cout << "PROCEDURAL: topN should be bottomN * some natural number" << std::endl;
+        out.begin(0, 0);
+        return;
+    }
+    float yTop = shape.height * 0.5f, yBottom = -shape.height * 0.5f;
+    float angleTop = 2.0f * pi / (float)shape.topN;
+    float angleBottom = 2.0f * pi / (float)shape.bottomN;
+
+    // smooth normals need the neighbouring faces: generate flat, then average the face normals
+    // around every vertex over the welded topology, inside each smoothing group (caps stay flat)
+    if (!shape.flatNormals) {
+        BucketShape flat = shape;
+        flat.flatNormals = true;
+        VectorSink soup;
+        generateBucket(flat, soup);
+
+        std::vector<glm::vec3> points, corners;
+        std::vector<unsigned int> welded = weldPositions(soup.positions, points);
+        HalfEdgeMesh topology(points, welded);
+        topology.cornerNormals(points, bucketFaceGroups(shape), corners);
+
+        out.begin(soup.vertexCount(), 0);
+        for (int i = 0; i < soup.vertexCount(); i++) {
+            // orienting may have flipped a face, so find the corner by vertex rather than by slot
+            int corner = i;
+            for (int k = i / 3 * 3; k < i / 3 * 3 + 3; k++) if (topology.triangles[k] == welded[i]) corner = k;
+            out.vertex(glm::vec3(soup.positions[i * 3], soup.positions[i * 3 + 1], soup.positions[i * 3 + 2]), corners[corner],
+                       glm::vec2(soup.texcoords[i * 2], soup.texcoords[i * 2 + 1]));
+        }
+        return;
+    }
+
+    out.begin(bucketTriangleCount(shape) * 3, 0);
+
+    struct Emitter {
+        Sink &out;
+        void triangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c,
+                      const glm::vec2 &ta, const glm::vec2 &tb, const glm::vec2 &tc)
+        {
+            glm::vec3 n = outwardNormal(a, b, c);
+            out.vertex(a, n, ta); out.vertex(b, n, tb); out.vertex(c, n, tc);
+        }
+    } emit = { out };
+
+    // top and bottom polygons, fanned around their centers
+    for (int cap = 0; cap < 2; cap++) {
+        int n = cap == 0 ? shape.topN : shape.bottomN;
+        float radius = cap == 0 ? shape.topRadius : shape.bottomRadius;
+        float depth = radius * (cap == 0 ? shape.topRatio : shape.bottomRatio);
+        float y = cap == 0 ? yTop : yBottom;
+        float angle = 2.0f * pi / (float)n;
+        for (int i = 0; i < n; i++) {
+            float theta = i * angle;
+            emit.triangle(glm::vec3(sinf(theta) * radius, y, cosf(theta) * depth),
+                          glm::vec3(sinf(theta + angle) * radius, y, cosf(theta + angle) * depth),
+                          glm::vec3(0.0f, y, 0.0f),
+                          glm::vec2((sinf(theta) + 1) * 0.5f, (cosf(theta) + 1) * 0.5f),
+                          glm::vec2((sinf(theta + angle) + 1) * 0.5f, (cosf(theta + angle) + 1) * 0.5f),
+                          glm::vec2(0.5f, 0.5f));
+        }
+    }
+
+    // sides; rim points come from their rim index with the caps' angles, so a point shared by
+    // several triangles is bit-identical in all of them (the smooth normals weld by position)
+    int middle = ratio / 2; // middle side of top (which makes rectangle with bottom side)
+    int top = 0;
+    auto topPoint = [&](int i) {
+        float theta = ((i + shape.topN) % shape.topN) * angleTop;
+        return glm::vec3(sinf(theta) * shape.topRadius, yTop, cosf(theta) * shape.topRadius * shape.topRatio);
+    };
+    auto bottomPoint = [&](int i) {
+        float theta = (i % shape.bottomN) * angleBottom;
+        return glm::vec3(sinf(theta) * shape.bottomRadius, yBottom, cosf(theta) * shape.bottomRadius * shape.bottomRatio);
+    };
+    for (int bottom = 0; bottom < shape.bottomN; bottom++) {
+        glm::vec3 b1 = bottomPoint(bottom), b2 = bottomPoint(bottom + 1);
+        glm::vec2 b1UV((float)bottom / shape.bottomN, 0.0f), b2UV((float)(bottom + 1) / shape.bottomN, 0.0f);
+
+        // top~middle with bottom_1
+        for (; top <= middle + bottom * ratio; top++) {
+            emit.triangle(topPoint(top - middle), topPoint(top + 1 - middle), b1,
+                          glm::vec2((float)top / shape.topN, 1.0f), glm::vec2((float)(top + 1) / shape.topN, 1.0f), b1UV);
+        }
+        // bottom with top_middle
+        emit.triangle(topPoint(top - middle), b1, b2, glm::vec2((float)top / shape.topN, 1.0f), b1UV, b2UV);
+        // middle~top with bottom_2
+        for (; top < ratio + bottom * ratio; top++) {
+            emit.triangle(topPoint(top - middle), topPoint(top + 1 - middle), b2,
+                          glm::vec2((float)top / shape.topN, 1.0f), glm::vec2((float)(top + 1) / shape.topN, 1.0f), b2UV);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Paper: a grid of boxes, each split into four triangles around its center point.
+// corner(h, w) gives the (rows + 1) x (cols + 1) box corners and center(h, w) the rows x cols
+// box centers, so animated sheets (Paper2) can feed their own coordinates.
+// Triangles are written box by box, w-major: ((w * rows) + h) * 4 + {bottom, right, top, left}.
+// Texture coordinates map [-width/2, width/2] x [-height/2, height/2] onto the unit square.
+// -----------------------------------------------------------------------------
+
+template <typename Sink, typename CornerFn, typename CenterFn>
+void generateFanGrid(int cols, int rows, float width, float height, CornerFn corner, CenterFn center, Sink &out)
+{
+    out.begin(cols * rows * 4 * 3, 0);
+    for (int w = 0; w < cols; w++) {
+        for (int h = 0; h < rows; h++) {
+            glm::vec3 quad[4] = { corner(h, w), corner(h, w + 1), corner(h + 1, w + 1), corner(h + 1, w) };
+            glm::vec3 c = center(h, w);
+            for (int k = 0; k < 4; k++) {
+                const glm::vec3 &a = quad[k];
+                const glm::vec3 &b = quad[(k + 1) % 4];
+                glm::vec3 n = windingNormal(a, b, c);
+                out.vertex(a, n, glm::vec2((a.x + width * 0.5f) / width, -(a.y + height * 0.5f) / height + 1.0f));
+                out.vertex(b, n, glm::vec2((b.x + width * 0.5f) / width, -(b.y + height * 0.5f) / height + 1.0f));
+                out.vertex(c, n, glm::vec2((c.x + width * 0.5f) / width, -(c.y + height * 0.5f) / height + 1.0f));
+            }
+        }
+    }
+}
+
+template <typename Sink>
+void generatePaper(const PaperShape &shape, Sink &out)
+{
+    float boxWidth = shape.width / (float)shape.cols;
+    float boxHeight = shape.height / (float)shape.rows;
+    float left = -shape.width * 0.5f, bottom = -shape.height * 0.5f;
+    generateFanGrid(shape.cols, shape.rows, shape.width, shape.height,
+        [=](int h, int w) { return glm::vec3(left + w * boxWidth, bottom + h * boxHeight, 0.0f); },
+        [=](int h, int w) { return glm::vec3(left + (w + 0.5f) * boxWidth, bottom + (h + 0.5f) * boxHeight, 0.0f); },
+        out);
+}
+
+#endif
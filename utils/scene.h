@@ -0,0 +1,244 @@
+// scene.h
+//
+// Scene components and systems on top of the ECS (ecs.h), GL independent.
+// A drawable entity has Transform + WorldMatrix + MeshHandle + Material; Velocity makes it move.
+// A frame is three passes over dense arrays, the first two in parallel:
+//
+//     integrateMotion(world, dt);                 // Transform += Velocity * dt
+//     updateWorldMatrices(world);                 // WorldMatrix = T * R * S
+//     gatherDrawBatches(world, batches);          // InstanceData per (shader, mesh)
+//     renderer.submit(batches);                   // GL side: scene_renderer.h
+//
+// Entities with the Hidden tag stay in the world but are not gathered.
+// Entities with LocalBounds can be found by position: SceneIndex (scene_index.h).
+// With occluders the gathering can skip what they hide:
+//
+//     rasterizeOccluders(world, occlusion, projection * view);
+//     gatherDrawBatches(world, batches, occlusion, projection * view);
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "ecs.h"
+#include "instance_data.h"
+#include "bounds.h"
+#include "occlusion.h"
+
+class Shader;
+
+struct Transform
+{
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+
+    Transform() { }
+    Transform(const glm::vec3 &position, const glm::vec3 &scale = glm::vec3(1.0f)) : position(position), scale(scale) { }
+
+    glm::mat4 matrix() const
+    {
+        glm::mat4 m = glm::mat4_cast(rotation);
+        m[0] *= scale.x; m[1] *= scale.y; m[2] *= scale.z;
+        m[3] = glm::vec4(position, 1.0f);
+        return m;
+    }
+};
+
+struct WorldMatrix
+{
+    glm::mat4 value = glm::mat4(1.0f);
+};
+
+struct Velocity
+{
+    glm::vec3 linear = glm::vec3(0.0f);
+    glm::vec3 angular = glm::vec3(0.0f);   // axis * radians per second
+
+    Velocity() { }
+    Velocity(const glm::vec3 &linear, const glm::vec3 &angular) : linear(linear), angular(angular) { }
+};
+
+// which GL buffers to draw: a VAO with a vertex count (glDrawArrays) or an index count (glDrawElements)
+struct MeshHandle
+{
+    unsigned int VAO = 0;
+    int count = 0;
+    bool indexed = false;
+
+    static MeshHandle arrays(unsigned int VAO, int vertexCount)
+    {
+        MeshHandle mesh;
+        mesh.VAO = VAO; mesh.count = vertexCount; mesh.indexed = false;
+        return mesh;
+    }
+
+    static MeshHandle elements(unsigned int VAO, int indexCount)
+    {
+        MeshHandle mesh;
+        mesh.VAO = VAO; mesh.count = indexCount; mesh.indexed = true;
+        return mesh;
+    }
+};
+
+// instanced: the shader reads model and colour per instance (instanced.vs), otherwise each entity
+// is its own draw with the "model" uniform (and the colour of its vertices)
+struct Material
+{
+    Shader *shader = NULL;
+    glm::vec4 color = glm::vec4(1.0f);
+    bool instanced = false;
+
+    Material() { }
+    Material(Shader *shader, const glm::vec4 &color = glm::vec4(1.0f), bool instanced = false)
+        : shader(shader), color(color), instanced(instanced) { }
+};
+
+struct Hidden { };
+
+// model-space bounds, for the spatial index (scene_index.h)
+struct LocalBounds
+{
+    AABB box;
+
+    LocalBounds() { }
+    LocalBounds(const AABB &box) : box(box) { }
+};
+
+// all entities that draw with one shader and one mesh
+struct DrawBatch
+{
+    Shader *shader;
+    MeshHandle mesh;
+    bool instanced;
+    std::vector<InstanceData> instances;
+};
+
+inline void integrateMotion(World &world, float dt)
+{
+    world.parallelEach<Transform, Velocity>(4096, [dt](Transform &transform, Velocity &velocity) {
+        transform.position += velocity.linear * dt;
+        float angle = glm::length(velocity.angular) * dt;
+        if (angle > 0.0f) {
+            transform.rotation = glm::normalize(glm::angleAxis(angle, glm::normalize(velocity.angular)) * transform.rotation);
+        }
+    });
+}
+
+inline void updateWorldMatrices(World &world)
+{
+    world.parallelEach<Transform, WorldMatrix>(4096, [](const Transform &transform, WorldMatrix &world) {
+        world.value = transform.matrix();
+    });
+}
+
+// model-space stand-in for what the entity hides behind it (occlusion.h); entities with an
+// Occluder are always drawn themselves
+struct Occluder
+{
+    const OccluderMesh *mesh = NULL;
+
+    Occluder() { }
+    Occluder(const OccluderMesh *mesh) : mesh(mesh) { }
+};
+
+// appends one entity to the batch of its shader and mesh; current is the batch of the last row
+inline void addToDrawBatch(std::vector<DrawBatch> &batches, int &current, const WorldMatrix &matrix, const MeshHandle &mesh, const Material &material)
+{
+    // rows of one archetype usually share their batch: only search when it changes
+    if (current < 0 || batches[current].shader != material.shader || batches[current].mesh.VAO != mesh.VAO ||
+        batches[current].mesh.count != mesh.count || batches[current].instanced != material.instanced) {
+        current = -1;
+        for (size_t b = 0; b < batches.size() && current < 0; b++) {
+            if (batches[b].shader == material.shader && batches[b].mesh.VAO == mesh.VAO && batches[b].mesh.count == mesh.count &&
+                batches[b].instanced == material.instanced) current = (int)b;
+        }
+        if (current < 0) {
+            DrawBatch batch;
+            batch.shader = material.shader;
+            batch.mesh = mesh;
+            batch.instanced = material.instanced;
+            batches.push_back(batch);
+            current = (int)batches.size() - 1;
+        }
+    }
+    batches[current].instances.push_back(InstanceData(matrix.value, material.color));
+}
+
+inline void dropEmptyDrawBatches(std::vector<DrawBatch> &batches)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < batches.size(); i++) {
+        if (batches[i].instances.empty()) continue;
+        if (kept != i) std::swap(batches[kept], batches[i]);
+        kept++;
+    }
+    batches.resize(kept);
+}
+
+// Refills batches (their instance arrays keep their capacity from frame to frame).
+// Batches come out in first-seen order; empty ones are dropped.
+inline void gatherDrawBatches(World &world, std::vector<DrawBatch> &batches)
+{
+    for (size_t i = 0; i < batches.size(); i++) batches[i].instances.clear();
+
+    world.eachChunk<WorldMatrix, MeshHandle, Material>([&](int count, const Entity *, WorldMatrix *matrices, MeshHandle *meshes, Material *materials) {
+        int current = -1;
+        for (int row = 0; row < count; row++) addToDrawBatch(batches, current, matrices[row], meshes[row], materials[row]);
+    }, maskOf<Hidden>());
+
+    dropEmptyDrawBatches(batches);
+}
+
+// clears occlusion and draws the Occluder of every shown entity into it (after updateWorldMatrices())
+inline void rasterizeOccluders(World &world, OcclusionBuffer &occlusion, const glm::mat4 &viewProjection)
+{
+    occlusion.clear();
+    world.eachChunk<WorldMatrix, Occluder>([&](int count, const Entity *, WorldMatrix *matrices, Occluder *occluders) {
+        for (int row = 0; row < count; row++) {
+            if (occluders[row].mesh != NULL) occlusion.addOccluder(*occluders[row].mesh, viewProjection * matrices[row].value);
+        }
+    }, maskOf<Hidden>());
+    occlusion.rasterize();
+}
+
+// as above, leaving out entities with LocalBounds that the occluders hide (after rasterizeOccluders())
+inline void gatherDrawBatches(World &world, std::vector<DrawBatch> &batches, const OcclusionBuffer &occlusion, const glm::mat4 &viewProjection)
+{
+    for (size_t i = 0; i < batches.size(); i++) batches[i].instances.clear();
+
+    // no bounds, or an occluder itself: always drawn
+    world.eachChunk<WorldMatrix, MeshHandle, Material>([&](int count, const Entity *, WorldMatrix *matrices, MeshHandle *meshes, Material *materials) {
+        int current = -1;
+        for (int row = 0; row < count; row++) addToDrawBatch(batches, current, matrices[row], meshes[row], materials[row]);
+    }, maskOf<Hidden>() | maskOf<LocalBounds>());
+    world.eachChunk<WorldMatrix, MeshHandle, Material, LocalBounds, Occluder>([&](int count, const Entity *, WorldMatrix *matrices, MeshHandle *meshes,
+                                                                                   Material *materials, LocalBounds *, Occluder *) {
+        int current = -1;
+        for (int row = 0; row < count; row++) addToDrawBatch(batches, current, matrices[row], meshes[row], materials[row]);
+    }, maskOf<Hidden>());
+
+    std::vector<AABB> boxes;
+    std::vector<unsigned char> visible;
+    world.eachChunk<WorldMatrix, MeshHandle, Material, LocalBounds>([&](int count, const Entity *, WorldMatrix *matrices, MeshHandle *meshes,
+                                                                         Material *materials, LocalBounds *bounds) {
+        boxes.resize(count);
+        visible.resize(count);
+        for (int row = 0; row < count; row++) boxes[row] = bounds[row].box.transformed(matrices[row].value);
+        occlusion.testBoxes(&boxes[0], count, viewProjection, &visible[0]);
+        int current = -1;
+        for (int row = 0; row < count; row++) {
+            if (visible[row]) addToDrawBatch(batches, current, matrices[row], meshes[row], materials[row]);
+        }
+    }, maskOf<Hidden>() | maskOf<Occluder>());
+
+    dropEmptyDrawBatches(batches);
+}
+
+#endif
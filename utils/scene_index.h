@@ -0,0 +1,88 @@
+// scene_index.h
+//
+// Spatial index (bvh.h) over the scene entities (scene.h) with WorldMatrix + LocalBounds, for
+// culling, picking and proximity queries without scanning every entity. GL independent.
+//
+//     updateWorldMatrices(world);
+//     index.update(world);                        // refit, or rebuild after entities came or went
+//     Entity picked = index.raycast(cameraPosition, direction, distance);
+//     index.querySphere(position, 5.0f, nearby);
+//
+// Hidden entities are left out by default. Boxes are the world transform of the local ones, so
+// picking is by box: test the mesh itself afterwards if that is too coarse.
+
+#ifndef SCENE_INDEX_H
+#define SCENE_INDEX_H
+
+#include <vector>
+
+#include "scene.h"
+#include "bvh.h"
+
+class SceneIndex
+{
+public:
+    SceneIndex() { }
+
+    void update(World &world, ComponentMask exclude = maskOf<Hidden>())
+    {
+        currentEntities.clear();
+        currentBoxes.clear();
+        world.eachChunk<WorldMatrix, LocalBounds>([&](int count, const Entity *rows, WorldMatrix *matrices, LocalBounds *bounds) {
+            for (int row = 0; row < count; row++) {
+                currentEntities.push_back(rows[row]);
+                currentBoxes.push_back(bounds[row].box.transformed(matrices[row].value));
+            }
+        }, exclude);
+
+        // the same entities in the same order: move the boxes; otherwise index from scratch
+        if (currentEntities == entities) {
+            for (size_t i = 0; i < currentBoxes.size(); i++) {
+                const AABB &old = bvh.getBounds((int)i);
+                if (currentBoxes[i].min != old.min || currentBoxes[i].max != old.max) bvh.setBounds((int)i, currentBoxes[i]);
+            }
+            bvh.commit();
+            return;
+        }
+        entities.swap(currentEntities);
+        bvh.build(currentBoxes.empty() ? NULL : &currentBoxes[0], (int)currentBoxes.size());
+    }
+
+    void queryFrustum(const Frustum &frustum, std::vector<Entity> &out) const
+    {
+        bvh.queryFrustum(frustum, [&](int object) { out.push_back(entities[object]); });
+    }
+
+    void querySphere(const glm::vec3 &center, float radius, std::vector<Entity> &out) const
+    {
+        bvh.querySphere(center, radius, [&](int object) { out.push_back(entities[object]); });
+    }
+
+    void queryAABB(const AABB &box, std::vector<Entity> &out) const
+    {
+        bvh.queryAABB(box, [&](int object) { out.push_back(entities[object]); });
+    }
+
+    // the entity whose box the ray enters first, an invalid Entity for none
+    Entity raycast(const glm::vec3 &origin, const glm::vec3 &direction, float &distance, float maxDistance = FLT_MAX) const
+    {
+        int object = bvh.raycast(origin, direction, distance, maxDistance);
+        return object < 0 ? Entity() : entities[object];
+    }
+
+    int size() const
+    {
+        return (int)entities.size();
+    }
+
+private:
+    BVH bvh;
+    std::vector<Entity> entities;           // by BVH object id
+    std::vector<Entity> currentEntities;
+    std::vector<AABB> currentBoxes;
+
+    SceneIndex(const SceneIndex &);
+    SceneIndex &operator=(const SceneIndex &);
+};
+
+#endif
@@ -0,0 +1,65 @@
+// scene_renderer.h
+//
+// Submits the draw batches of a scene (scene.h) to GL: one instanced draw per instanced batch,
+// one bind plus a draw per entity otherwise. The shaders' view / projection / lighting uniforms
+// are the caller's, as for the other drawing classes.
+//
+//     gatherDrawBatches(world, batches);
+//     renderer.submit(batches);
+
+#ifndef SCENE_RENDERER_H
+#define SCENE_RENDERER_H
+
+#include <vector>
+
+#include "shader.h"
+#include "scene.h"
+#include "instance_buffer.h"
+#include "draw_stats.h"
+
+class SceneRenderer
+{
+public:
+    SceneRenderer() { }
+
+    ~SceneRenderer()
+    {
+        for (size_t i = 0; i < buffers.size(); i++) delete buffers[i];
+    }
+
+    void submit(const std::vector<DrawBatch> &batches)
+    {
+        int used = 0;
+        for (size_t b = 0; b < batches.size(); b++) {
+            const DrawBatch &batch = batches[b];
+            batch.shader->use();
+            if (batch.instanced) {
+                // one streaming buffer per instanced batch of the frame
+                if (used == (int)buffers.size()) buffers.push_back(new InstanceBuffer());
+                InstanceBuffer *instances = buffers[used++];
+                instances->upload(&batch.instances[0], (int)batch.instances.size());
+                batch.shader->setMat4("model", glm::mat4(1.0f));
+                if (batch.mesh.indexed) instances->drawElements(batch.mesh.VAO, batch.mesh.count);
+                else instances->drawArrays(batch.mesh.VAO, batch.mesh.count);
+                continue;
+            }
+            int modelLocation = batch.shader->getUniformLocation("model");
+            glBindVertexArray(batch.mesh.VAO);
+            for (size_t i = 0; i < batch.instances.size(); i++) {
+                glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &batch.instances[i].model[0][0]);
+                if (batch.mesh.indexed) glDrawElements(GL_TRIANGLES, batch.mesh.count, GL_UNSIGNED_INT, 0);
+                else glDrawArrays(GL_TRIANGLES, 0, batch.mesh.count);
+                drawStats().add(1, batch.mesh.count / 3);
+            }
+            glBindVertexArray(0);
+        }
+    }
+
+private:
+    std::vector<InstanceBuffer *> buffers;
+
+    SceneRenderer(const SceneRenderer &);
+    SceneRenderer &operator=(const SceneRenderer &);
+};
+
+#endif
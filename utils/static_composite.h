@@ -0,0 +1,142 @@
+// static_composite.h
+//
+// GPU side of a MergedMesh (mesh_merge.h): all parts of a composite model in one VAO, drawn with
+// one call (one per fleet with instancing) instead of one bind and draw per part.
+//
+//     StaticComposite *baked = new StaticComposite(merged);
+//     shader->setMat4("model", model);
+//     baked->draw(shader);
+//
+// Vertex shader: the locations 0-3 as the other meshes (vertex_layout.h), 9: part id (uint).
+// Shaders that ignore location 9 draw the rest pose; composite.vs moves each part by
+// partPose[id] when animateParts is set (setPartPoses()). Only the first MAX_POSED_PARTS parts
+// can be posed, the others keep the rest pose.
+
+#ifndef STATIC_COMPOSITE_H
+#define STATIC_COMPOSITE_H
+
+#include <cassert>
+#include <vector>
+
+#include "shader.h"
+#include "mesh_merge.h"
+#include "vertex_layout.h"
+#include "instance_buffer.h"
+#include "draw_stats.h"
+#include "bounds.h"
+
+class StaticComposite
+{
+public:
+    enum { PART_ID_LOCATION = 9, MAX_POSED_PARTS = 8 };   // MAX_POSED_PARTS: size of partPose[] in composite.vs
+
+    // vertex format of the merged parts (see vertex_layout.h); the part ids are a second stream
+    typedef PackedVertex Layout;
+
+    StaticComposite(const MergedMesh &mesh, const glm::vec4 &color = glm::vec4(1.0f))
+    {
+        indexCount = (int)mesh.indices.size();
+        partCount = mesh.partCount;
+        for (int i = 0; i < mesh.vertexCount(); i++) bounds.extend(mesh.positions[i]);
+
+        std::vector<Layout::Vertex> vertices(mesh.vertexCount());
+        for (int i = 0; i < mesh.vertexCount(); i++)
+            Layout::write(vertices[i], VertexInput(mesh.positions[i], mesh.normals[i], color, mesh.texcoords[i]));
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(2, VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+
+        // VBO[0]: interleaved Layout::Vertex
+        glBindBuffer(GL_ARRAY_BUFFER, VBO[0]);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Layout::Vertex), vertices.empty() ? NULL : &vertices[0], GL_STATIC_DRAW);
+        Layout::setup();
+
+        // VBO[1]: one byte of part id per vertex
+        glBindBuffer(GL_ARRAY_BUFFER, VBO[1]);
+        glBufferData(GL_ARRAY_BUFFER, mesh.partIds.size(), mesh.partIds.empty() ? NULL : &mesh.partIds[0], GL_STATIC_DRAW);
+        glVertexAttribIPointer(PART_ID_LOCATION, 1, GL_UNSIGNED_BYTE, 1, (void *)0);
+        glEnableVertexAttribArray(PART_ID_LOCATION);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(unsigned int), mesh.indices.empty() ? NULL : &mesh.indices[0], GL_STATIC_DRAW);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    ~StaticComposite()
+    {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(2, VBO);
+        glDeleteBuffers(1, &EBO);
+    }
+
+    // every part with the "model" matrix already set on the shader
+    void draw(Shader *shader)
+    {
+        shader->use();
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
+        drawStats().add(1, indexCount / 3);
+    }
+
+    // every part of every instance in one call (shader: instanced.vs or composite.vs)
+    void drawInstanced(Shader *shader, const InstanceBuffer &instances)
+    {
+        shader->use();
+        shader->setMat4("model", glm::mat4(1.0f));
+        instances.drawElements(VAO, indexCount);
+    }
+
+    // composite.vs only: parts 0 .. count - 1 (count <= MAX_POSED_PARTS) are drawn moved by
+    // poses[part] (in model space) while animateParts is on; one upload for the whole array
+    static void setPartPoses(Shader *shader, const glm::mat4 *poses, int count)
+    {
+        assert(count >= 0 && count <= MAX_POSED_PARTS);
+        if (count > MAX_POSED_PARTS) count = MAX_POSED_PARTS;
+        if (count <= 0) return;
+        shader->use();
+        glUniformMatrix4fv(shader->getUniformLocation("partPose"), count, GL_FALSE, &poses[0][0][0]);
+    }
+
+    static void setAnimateParts(Shader *shader, bool animate)
+    {
+        shader->use();
+        shader->setBool("animateParts", animate);
+    }
+
+    unsigned int getVAO() const
+    {
+        return VAO;
+    }
+
+    int getTriangleNum() const
+    {
+        return indexCount / 3;
+    }
+
+    int getPartCount() const
+    {
+        return partCount;
+    }
+
+    // model-space bounds of the rest pose
+    AABB getBounds() const
+    {
+        return bounds;
+    }
+
+private:
+    unsigned int VAO, VBO[2], EBO;
+    int indexCount, partCount;
+    AABB bounds;
+
+    StaticComposite(const StaticComposite &);
+    StaticComposite &operator=(const StaticComposite &);
+};
+
+#endif
@@ -0,0 +1,92 @@
+// static_primitive.h
+//
+// Draws a compile-time mesh from constexpr_mesh.h. The vertex data is uploaded once per
+// mesh type, on the first draw, and kept for the life of the program; a StaticPrimitive
+// object itself is empty, so creating one costs nothing.
+//
+//     StaticPrimitive< StaticBucket<12, 6> > bucket;
+//     bucket.draw(shader);
+//
+// There is no color array: attribute 2 is set to the constant passed to draw (white by default).
+//
+// Vertex shader: the location (0: position attrib (vec3), 1: normal (vec3), 2: color (vec4), 3: texture (vec2))
+
+#ifndef STATIC_PRIMITIVE_H
+#define STATIC_PRIMITIVE_H
+
+#include <GL/glew.h>
+
+#include "shader.h"
+#include "constexpr_mesh.h"
+#include "bounds.h"
+
+template <typename Mesh>
+class StaticPrimitive
+{
+public:
+    void draw(Shader *shader, const glm::vec4 &color = glm::vec4(1.0f))
+    {
+        shader->use();
+        glBindVertexArray(getVAO());
+        glVertexAttrib4f(2, color.r, color.g, color.b, color.a);
+        if (Mesh::Data::indexCount > 0)
+            glDrawElements(GL_TRIANGLES, Mesh::Data::indexCount, GL_UNSIGNED_INT, 0);
+        else
+            glDrawArrays(GL_TRIANGLES, 0, Mesh::Data::vertexCount);
+        glBindVertexArray(0);
+    }
+
+    static unsigned int getVAO()
+    {
+        static unsigned int VAO = upload();
+        return VAO;
+    }
+
+    // model-space bounds of the compile-time positions
+    static AABB getBounds()
+    {
+        AABB bounds;
+        for (int i = 0; i < Mesh::Data::vertexCount; i++)
+            bounds.extend(glm::vec3(Mesh::data.positions[i * 3], Mesh::data.positions[i * 3 + 1], Mesh::data.positions[i * 3 + 2]));
+        return bounds;
+    }
+
+private:
+
+    static unsigned int upload()
+    {
+        const typename Mesh::Data &data = Mesh::data;
+        const int posBytes = sizeof(data.positions), nrmBytes = sizeof(data.normals), texBytes = sizeof(data.texcoords);
+        unsigned int VAO, VBO, EBO;
+
+        glGenVertexArrays(1, &VAO);
+        glBindVertexArray(VAO);
+
+        // positions, normals and texcoords one after another in a single buffer
+        glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, posBytes + nrmBytes + texBytes, 0, GL_STATIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, posBytes, data.positions);
+        glBufferSubData(GL_ARRAY_BUFFER, posBytes, nrmBytes, data.normals);
+        glBufferSubData(GL_ARRAY_BUFFER, posBytes + nrmBytes, texBytes, data.texcoords);
+
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)(size_t)posBytes);
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)(size_t)(posBytes + nrmBytes));
+
+        if (Mesh::Data::indexCount > 0) {
+            glGenBuffers(1, &EBO);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(data.indices), data.indices, GL_STATIC_DRAW);
+        }
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return VAO;
+    }
+};
+
+#endif
@@ -0,0 +1,470 @@
+// stress_scene.h
+//
+// Procedural stress scenes for scalability testing, GL independent. A seed and a count per kind
+// (cubes, buckets, pyramids, planes, paper sheets) always give the same scene: every object gets
+// a random transform, colour and speed and one of a few random shape variants of its kind.
+// The objects are scene entities (scene.h); StressFrame runs one frame of them phase by phase
+// and times each phase:
+//
+//     StressSceneConfig config = StressSceneConfig::mixed(100000);
+//     StressScene scene;
+//     scene.generate(world, config);
+//     StressFrame frame;
+//     frame.run(world, dt, projection * view);        // update, cull, sort, upload, submit
+//     printf("%f ms culling\n", frame.getTimes().cull);
+//
+// Without a context the entities get placeholder meshes (VAO i + 1 for variant i), and upload
+// and submit fill CPU-side stand-ins of what InstanceBuffer and SceneRenderer hand to GL: one
+// instance staging array and one draw command per draw. With a context, upload the variants:
+//
+//     scene.makeMeshes(config);
+//     for (int i = 0; i < scene.meshCount(); i++) handles.push_back(upload of scene.getMesh(i));
+//     scene.populate(world, config, &handles[0], instancedShader);
+//     ...
+//     frame.run(world, dt, projection * view);
+//     renderer.submit(frame.getBatches());
+
+#ifndef STRESS_SCENE_H
+#define STRESS_SCENE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "scene.h"
+#include "frustum.h"
+#include "procedural.h"
+#include "fighter_shape.h"
+
+enum StressKind
+{
+    STRESS_CUBE, STRESS_BUCKET, STRESS_PYRAMID, STRESS_PLANE, STRESS_PAPER, STRESS_KIND_COUNT
+};
+
+struct StressSceneConfig
+{
+    int counts[STRESS_KIND_COUNT];
+    unsigned int seed = 1;
+    int variants = 4;               // random shapes per kind; the plane has one
+    float density = 0.05f;          // objects per cubic unit: the scene grows with the count
+    float movingFraction = 0.5f;    // objects with a Velocity
+    float maxSpeed = 2.0f;
+    bool instanced = true;          // one draw per batch, or one per object
+
+    StressSceneConfig()
+    {
+        for (int kind = 0; kind < STRESS_KIND_COUNT; kind++) counts[kind] = 0;
+    }
+
+    // total objects over the kinds: 30% cubes, 20% buckets, 20% pyramids, 20% planes, 10% paper
+    static StressSceneConfig mixed(int total, unsigned int seed = 1)
+    {
+        StressSceneConfig config;
+        config.seed = seed;
+        config.counts[STRESS_BUCKET] = total / 5;
+        config.counts[STRESS_PYRAMID] = total / 5;
+        config.counts[STRESS_PLANE] = total / 5;
+        config.counts[STRESS_PAPER] = total / 10;
+        config.counts[STRESS_CUBE] = total - 2 * (total / 5) - total / 5 - total / 10;
+        return config;
+    }
+
+    int total() const
+    {
+        int sum = 0;
+        for (int kind = 0; kind < STRESS_KIND_COUNT; kind++) sum += counts[kind];
+        return sum;
+    }
+
+    // side of the cube the objects are spread over
+    float extent() const
+    {
+        return std::cbrt(std::max(total(), 1) / density);
+    }
+};
+
+// one shape variant: the parameters of its kind's generator (procedural.h)
+struct StressMesh
+{
+    StressKind kind;
+    CubeShape cube;
+    PyramidShape pyramid;
+    BucketShape bucket;
+    PaperShape paper;
+    ProceduralCounts counts;
+    AABB bounds;                    // model space
+
+    int triangleCount() const
+    {
+        return (counts.indices > 0 ? counts.indices : counts.vertices) / 3;
+    }
+
+    // false for the plane: it is baked from its parts (FighterShape::merge(), fighter_shape.h)
+    template <typename Sink>
+    bool generate(Sink &out) const
+    {
+        switch (kind) {
+        case STRESS_CUBE: generateCube(cube, out); return true;
+        case STRESS_BUCKET: generateBucket(bucket, out); return true;
+        case STRESS_PYRAMID: generatePyramid(pyramid, out); return true;
+        case STRESS_PAPER: generatePaper(paper, out); return true;
+        default: return false;
+        }
+    }
+};
+
+class StressScene
+{
+public:
+    StressScene() { }
+
+    // the shape variants of config; the same seed gives the same variants
+    void makeMeshes(const StressSceneConfig &config)
+    {
+        meshes.clear();
+        std::mt19937 random(config.seed);
+        for (int kind = 0; kind < STRESS_KIND_COUNT; kind++) {
+            int variants = kind == STRESS_PLANE ? 1 : std::max(config.variants, 1);
+            for (int v = 0; v < variants; v++) meshes.push_back(makeMesh((StressKind)kind, random));
+        }
+    }
+
+    // creates config.total() entities; handles[i] draws variant i (NULL: placeholders, no GL)
+    void populate(World &world, const StressSceneConfig &config, const MeshHandle *handles = NULL, Shader *shader = NULL)
+    {
+        if (meshes.empty()) makeMeshes(config);
+        std::vector<int> firstVariant(STRESS_KIND_COUNT + 1, 0);
+        // variants of kind k: firstVariant[k] to firstVariant[k + 1]
+        for (size_t i = 0; i < meshes.size(); i++) firstVariant[meshes[i].kind + 1] = (int)i + 1;
+
+        // kinds interleaved as a scene filled over time would be, not one kind after the other
+        std::vector<unsigned char> kinds;
+        kinds.reserve(config.total());
+        for (int kind = 0; kind < STRESS_KIND_COUNT; kind++) kinds.insert(kinds.end(), config.counts[kind], (unsigned char)kind);
+        std::mt19937 random(config.seed ^ 0x9e3779b9u);
+        for (int i = (int)kinds.size() - 1; i > 0; i--) std::swap(kinds[i], kinds[random() % (unsigned int)(i + 1)]);
+
+        int moving = (int)(kinds.size() * config.movingFraction);
+        world.reserve<Transform, Velocity, WorldMatrix, MeshHandle, Material, LocalBounds>(moving);
+        world.reserve<Transform, WorldMatrix, MeshHandle, Material, LocalBounds>((int)kinds.size() - moving);
+
+        float half = config.extent() * 0.5f;
+        for (size_t i = 0; i < kinds.size(); i++) {
+            int first = firstVariant[kinds[i]];
+            int variants = firstVariant[kinds[i] + 1] - first;
+            int variant = first + (int)(random() % (unsigned int)variants);
+
+            // one random draw per statement: the order of evaluating arguments is up to the compiler
+            glm::vec3 position = randomVector(random) * half;
+            float scale = 0.5f + 1.5f * unit(random);
+            Transform transform(position, glm::vec3(scale));
+            transform.rotation = randomRotation(random);
+            MeshHandle mesh = handles != NULL ? handles[variant] : placeholder(variant, meshes[variant]);
+            glm::vec3 color = (randomVector(random) + 1.0f) * 0.5f;
+            Material material(shader, glm::vec4(color, 1.0f), config.instanced);
+            LocalBounds bounds(meshes[variant].bounds);
+
+            if ((int)i < moving) {
+                glm::vec3 direction = randomRotation(random) * glm::vec3(0.0f, 0.0f, 1.0f);
+                float speed = config.maxSpeed * unit(random);
+                float spin = signedUnit(random);
+                Velocity velocity(direction * speed, glm::vec3(0.0f, spin, 0.0f));
+                world.create(transform, velocity, WorldMatrix(), mesh, material, bounds);
+            }
+            else {
+                world.create(transform, WorldMatrix(), mesh, material, bounds);
+            }
+        }
+    }
+
+    // makeMeshes() and populate() with placeholder meshes, for headless runs
+    void generate(World &world, const StressSceneConfig &config)
+    {
+        makeMeshes(config);
+        populate(world, config);
+    }
+
+    int meshCount() const
+    {
+        return (int)meshes.size();
+    }
+
+    const StressMesh &getMesh(int variant) const
+    {
+        return meshes[variant];
+    }
+
+private:
+    std::vector<StressMesh> meshes;
+
+    static float unit(std::mt19937 &random)
+    {
+        // from the bits, so a seed gives the same scene with every standard library
+        return (random() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    static float signedUnit(std::mt19937 &random)
+    {
+        return unit(random) * 2.0f - 1.0f;
+    }
+
+    static glm::vec3 randomVector(std::mt19937 &random)
+    {
+        float x = signedUnit(random);
+        float y = signedUnit(random);
+        float z = signedUnit(random);
+        return glm::vec3(x, y, z);
+    }
+
+    static glm::quat randomRotation(std::mt19937 &random)
+    {
+        float w = signedUnit(random);
+        glm::quat q(w, randomVector(random));
+        float length = glm::length(q);
+        return length > 1e-3f ? q / length : glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    }
+
+    // no VAO behind it, but the counts of the variant
+    static MeshHandle placeholder(int variant, const StressMesh &mesh)
+    {
+        if (mesh.counts.indices > 0) return MeshHandle::elements((unsigned int)variant + 1, mesh.counts.indices);
+        return MeshHandle::arrays((unsigned int)variant + 1, mesh.counts.vertices);
+    }
+
+    static StressMesh makeMesh(StressKind kind, std::mt19937 &random)
+    {
+        StressMesh mesh;
+        mesh.kind = kind;
+        switch (kind) {
+        case STRESS_CUBE:
+            mesh.cube.size = 0.5f + unit(random);
+            mesh.counts = cubeCounts(mesh.cube);
+            break;
+        case STRESS_BUCKET:
+            mesh.bucket.bottomN = 4 + (int)(random() % 9u);
+            mesh.bucket.topN = mesh.bucket.bottomN * (1 + (int)(random() % 3u));
+            mesh.bucket.topRadius = 0.5f + 0.5f * unit(random);
+            mesh.bucket.bottomRadius = 0.3f + 0.5f * unit(random);
+            mesh.bucket.height = 0.5f + unit(random);
+            mesh.counts = bucketCounts(mesh.bucket);
+            break;
+        case STRESS_PYRAMID:
+            mesh.pyramid.bottomLine = 0.5f + unit(random);
+            mesh.pyramid.height = 0.5f + unit(random);
+            mesh.counts = pyramidCounts(mesh.pyramid);
+            break;
+        case STRESS_PAPER:
+            mesh.paper.width = 0.5f + unit(random);
+            mesh.paper.height = 0.5f + unit(random);
+            mesh.paper.cols = 4 + (int)(random() % 29u);
+            mesh.paper.rows = 4 + (int)(random() % 29u);
+            mesh.counts = paperCounts(mesh.paper);
+            break;
+        default: {
+            // the baked fighter plane, as Fighter_plane::drawBaked() draws it
+            MergedMesh plane = FighterShape().merge();
+            mesh.counts.vertices = plane.vertexCount();
+            mesh.counts.indices = (int)plane.indices.size();
+            for (int i = 0; i < plane.vertexCount(); i++) mesh.bounds.extend(plane.positions[i]);
+            return mesh;
+        }
+        }
+        VectorSink sink;
+        mesh.generate(sink);
+        mesh.bounds = AABB::fromPoints(&sink.positions[0], sink.vertexCount());
+        return mesh;
+    }
+
+    StressScene(const StressScene &);
+    StressScene &operator=(const StressScene &);
+};
+
+// milliseconds per phase of one frame
+struct StressFrameTimes
+{
+    double update = 0.0;    // motion and world matrices
+    double cull = 0.0;      // world bounds and frustum test
+    double sort = 0.0;      // visible entities into batches, batches in state order
+    double upload = 0.0;    // instances into one staging array
+    double submit = 0.0;    // draw commands
+
+    double total() const
+    {
+        return update + cull + sort + upload + submit;
+    }
+
+    void add(const StressFrameTimes &other)
+    {
+        update += other.update; cull += other.cull; sort += other.sort;
+        upload += other.upload; submit += other.submit;
+    }
+};
+
+// a draw as the GL side would issue it: instanced batches are one command with baseInstance into
+// the staging array, other batches one command per entity (baseInstance is then its row)
+struct StressDrawCommand
+{
+    unsigned int VAO;
+    int count;
+    bool indexed;
+    int instanceCount;
+    int baseInstance;
+};
+
+class StressFrame
+{
+public:
+    StressFrame() : visibleCount(0), triangleCount(0) { }
+
+    // one frame of every entity with WorldMatrix + LocalBounds + MeshHandle + Material
+    void run(World &world, float dt, const glm::mat4 &viewProjection)
+    {
+        std::chrono::high_resolution_clock::time_point start = now();
+
+        integrateMotion(world, dt);
+        updateWorldMatrices(world);
+        times.update = since(start);
+
+        start = now();
+        int count = 0;
+        world.eachChunk<WorldMatrix, LocalBounds, MeshHandle, Material>([&](int rows, const Entity *, WorldMatrix *, LocalBounds *,
+                                                                            MeshHandle *, Material *) {
+            count += rows;
+        }, maskOf<Hidden>());
+        culler.resize(count);
+        int offset = 0;
+        world.eachChunk<WorldMatrix, LocalBounds, MeshHandle, Material>([&](int rows, const Entity *, WorldMatrix *matrices, LocalBounds *bounds,
+                                                                            MeshHandle *, Material *) {
+            parallelFor(0, rows, 16384, [&](int begin, int end) {
+                for (int row = begin; row < end; row++) {
+                    culler.set(offset + row, BoundingSphere::fromAABB(bounds[row].box).transformed(matrices[row].value));
+                }
+            });
+            offset += rows;
+        }, maskOf<Hidden>());
+        visibleCount = culler.cull(viewProjection);
+        times.cull = since(start);
+
+        // the same chunks in the same order as above, so rows line up with the culler's indices
+        start = now();
+        for (size_t i = 0; i < batches.size(); i++) batches[i].instances.clear();
+        offset = 0;
+        world.eachChunk<WorldMatrix, LocalBounds, MeshHandle, Material>([&](int rows, const Entity *, WorldMatrix *matrices, LocalBounds *,
+                                                                            MeshHandle *meshes, Material *materials) {
+            int current = -1;
+            for (int row = 0; row < rows; row++) {
+                if (culler.isVisible(offset + row)) addToDrawBatch(batches, current, matrices[row], meshes[row], materials[row]);
+            }
+            offset += rows;
+        }, maskOf<Hidden>());
+        dropEmptyDrawBatches(batches);
+        std::sort(batches.begin(), batches.end(), stateOrder);
+        times.sort = since(start);
+
+        start = now();
+        size_t instanceCount = 0;
+        for (size_t b = 0; b < batches.size(); b++) {
+            if (batches[b].instanced) instanceCount += batches[b].instances.size();
+        }
+        staging.resize(instanceCount);
+        size_t written = 0;
+        for (size_t b = 0; b < batches.size(); b++) {
+            if (!batches[b].instanced) continue;
+            memcpy(&staging[written], &batches[b].instances[0], batches[b].instances.size() * sizeof(InstanceData));
+            written += batches[b].instances.size();
+        }
+        times.upload = since(start);
+
+        start = now();
+        commands.clear();
+        triangleCount = 0;
+        int baseInstance = 0;
+        for (size_t b = 0; b < batches.size(); b++) {
+            const DrawBatch &batch = batches[b];
+            int instances = (int)batch.instances.size();
+            if (batch.instanced) {
+                StressDrawCommand command = { batch.mesh.VAO, batch.mesh.count, batch.mesh.indexed, instances, baseInstance };
+                commands.push_back(command);
+                baseInstance += instances;
+            }
+            else {
+                for (int row = 0; row < instances; row++) {
+                    StressDrawCommand command = { batch.mesh.VAO, batch.mesh.count, batch.mesh.indexed, 1, row };
+                    commands.push_back(command);
+                }
+            }
+            triangleCount += (long long)(batch.mesh.count / 3) * instances;
+        }
+        times.submit = since(start);
+    }
+
+    // of the last run()
+    const StressFrameTimes &getTimes() const
+    {
+        return times;
+    }
+
+    const std::vector<DrawBatch> &getBatches() const
+    {
+        return batches;
+    }
+
+    const std::vector<StressDrawCommand> &getCommands() const
+    {
+        return commands;
+    }
+
+    int getVisibleCount() const
+    {
+        return visibleCount;
+    }
+
+    long long getTriangleCount() const
+    {
+        return triangleCount;
+    }
+
+    size_t getUploadBytes() const
+    {
+        return staging.size() * sizeof(InstanceData);
+    }
+
+private:
+    FrustumCuller culler;
+    std::vector<DrawBatch> batches;
+    std::vector<InstanceData> staging;
+    std::vector<StressDrawCommand> commands;
+    StressFrameTimes times;
+    int visibleCount;
+    long long triangleCount;
+
+    static std::chrono::high_resolution_clock::time_point now()
+    {
+        return std::chrono::high_resolution_clock::now();
+    }
+
+    static double since(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(now() - start).count();
+    }
+
+    // fewest state changes: by shader, then by mesh
+    static bool stateOrder(const DrawBatch &a, const DrawBatch &b)
+    {
+        if (a.shader != b.shader) return std::less<Shader *>()(a.shader, b.shader);
+        if (a.mesh.VAO != b.mesh.VAO) return a.mesh.VAO < b.mesh.VAO;
+        if (a.mesh.count != b.mesh.count) return a.mesh.count < b.mesh.count;
+        return a.instanced < b.instanced;
+    }
+
+    StressFrame(const StressFrame &);
+    StressFrame &operator=(const StressFrame &);
+};
+
+#endif
@@ -0,0 +1,322 @@
+// subdivision.h
+//
+// Loop subdivision for the triangle meshes made by procedural.h, GL independent.
+//
+// The generators emit triangle lists with one vertex per corner; SubdivMesh::fromTriangleList welds
+// them into a shared-vertex mesh first. Edges can be marked as creases (the bucket rims, the
+// pyramid base): they stay sharp and are refined with the boundary rules.
+//
+// Subdivision is split in two parts:
+//   - LoopSubdivision(base, levels) refines the topology and precomputes, for every vertex of the
+//     last level, a stencil: its weights over the *base* vertices (the per-level stencils composed
+//     into one sparse matrix, stored as CSR).
+//   - evaluate(basePositions) is then a sparse matrix * vector product, so moving base vertices
+//     and re-evaluating does not redo any topology work.
+// Both parts run in parallel chunks (parallel.h).
+//
+//     SubdivMesh base = SubdivMesh::fromTriangleList(sink.positions);
+//     base.markFaceGroupCreases(bucketFaceGroups(shape));
+//     LoopSubdivision surface(base, 2);
+//     surface.evaluate(base.positions);
+//     surface.emit(out);     // any procedural.h sink
+//
+// Texture coordinates are not carried: welding merges the texture seams.
+
+#ifndef SUBDIVISION_H
+#define SUBDIVISION_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "procedural.h"
+#include "parallel.h"
+#include "half_edge.h"
+
+// -----------------------------------------------------------------------------
+// Shared-vertex triangle mesh with crease edges
+// -----------------------------------------------------------------------------
+
+struct SubdivMesh
+{
+    std::vector<glm::vec3> positions;
+    std::vector<unsigned int> triangles;        // 3 indices per triangle
+    std::vector<unsigned long long> creases;    // edgeKey() of every crease edge, sorted
+
+    int vertexCount() const { return (int)positions.size(); }
+    int triangleCount() const { return (int)triangles.size() / 3; }
+
+    static unsigned long long edgeKey(unsigned int a, unsigned int b)
+    {
+        if (a > b) std::swap(a, b);
+        return ((unsigned long long)a << 32) | b;
+    }
+
+    bool isCrease(unsigned int a, unsigned int b) const
+    {
+        return std::binary_search(creases.begin(), creases.end(), edgeKey(a, b));
+    }
+
+    // welds a triangle list (3 floats per vertex, 3 vertices per triangle) by position and
+    // orients its faces consistently outward (see half_edge.h)
+    static SubdivMesh fromTriangleList(const std::vector<float> &soup, float weldDistance = 1e-4f)
+    {
+        SubdivMesh mesh;
+        std::vector<unsigned int> welded = weldPositions(soup, mesh.positions, weldDistance);
+        mesh.triangles = HalfEdgeMesh(mesh.positions, welded).triangles;
+        return mesh;
+    }
+
+    // marks every edge whose two faces are in different groups (one group id per triangle)
+    void markFaceGroupCreases(const std::vector<int> &faceGroups)
+    {
+        HalfEdgeMesh topology(vertexCount(), triangles);
+        for (int e = 0; e < topology.edgeCount(); e++) {
+            int h = topology.edgeHalf[e], t = topology.twin[h];
+            if (t >= 0 && faceGroups[HalfEdgeMesh::face(h)] != faceGroups[HalfEdgeMesh::face(t)])
+                creases.push_back(edgeKey(topology.origin(h), topology.dest(h)));
+        }
+        std::sort(creases.begin(), creases.end());
+        creases.erase(std::unique(creases.begin(), creases.end()), creases.end());
+    }
+};
+
+// -----------------------------------------------------------------------------
+// Sparse stencils (CSR): row r of the matrix is the weights of vertex r over the base vertices
+// -----------------------------------------------------------------------------
+
+struct StencilTable
+{
+    std::vector<int> rowStart;          // rows + 1 entries
+    std::vector<int> columns;
+    std::vector<float> weights;
+
+    int rows() const { return (int)rowStart.size() - 1; }
+    int entries() const { return (int)columns.size(); }
+
+    // out[r] = sum of weights * in[columns]
+    void apply(const std::vector<glm::vec3> &in, std::vector<glm::vec3> &out) const
+    {
+        out.resize(rows());
+        parallelFor(0, rows(), 2048, [&](int begin, int end) {
+            for (int r = begin; r < end; r++) {
+                glm::vec3 sum(0.0f);
+                for (int k = rowStart[r]; k < rowStart[r + 1]; k++) sum += weights[k] * in[columns[k]];
+                out[r] = sum;
+            }
+        });
+    }
+
+    // this * previous: stencils of the rows of this table over the base of previous
+    StencilTable compose(const StencilTable &previous, int baseCount) const
+    {
+        const int grain = 1024;
+        int chunks = (rows() + grain - 1) / grain;
+        std::vector<StencilTable> parts(chunks);
+
+        parallelFor(0, chunks, 1, [&](int chunkBegin, int chunkEnd) {
+            std::vector<float> accumulated(baseCount, 0.0f);
+            std::vector<int> used;
+            for (int c = chunkBegin; c < chunkEnd; c++) {
+                StencilTable &part = parts[c];
+                part.rowStart.push_back(0);
+                for (int r = c * grain; r < std::min((c + 1) * grain, rows()); r++) {
+                    for (int k = rowStart[r]; k < rowStart[r + 1]; k++) {
+                        int middle = columns[k];
+                        for (int j = previous.rowStart[middle]; j < previous.rowStart[middle + 1]; j++) {
+                            int column = previous.columns[j];
+                            if (accumulated[column] == 0.0f) used.push_back(column);
+                            accumulated[column] += weights[k] * previous.weights[j];
+                        }
+                    }
+                    std::sort(used.begin(), used.end());
+                    for (size_t u = 0; u < used.size(); u++) {
+                        if (accumulated[used[u]] != 0.0f) {
+                            part.columns.push_back(used[u]);
+                            part.weights.push_back(accumulated[used[u]]);
+                        }
+                        accumulated[used[u]] = 0.0f;
+                    }
+                    used.clear();
+                    part.rowStart.push_back((int)part.columns.size());
+                }
+            }
+        });
+
+        StencilTable result;
+        result.rowStart.push_back(0);
+        for (int c = 0; c < chunks; c++) {
+            int offset = (int)result.columns.size();
+            result.columns.insert(result.columns.end(), parts[c].columns.begin(), parts[c].columns.end());
+            result.weights.insert(result.weights.end(), parts[c].weights.begin(), parts[c].weights.end());
+            for (size_t r = 1; r < parts[c].rowStart.size(); r++) result.rowStart.push_back(offset + parts[c].rowStart[r]);
+        }
+        return result;
+    }
+};
+
+// -----------------------------------------------------------------------------
+// Loop subdivision
+// -----------------------------------------------------------------------------
+
+class LoopSubdivision
+{
+public:
+
+    LoopSubdivision(const SubdivMesh &base, int levels)
+    {
+        baseCount = base.vertexCount();
+        SubdivMesh mesh = base;
+        for (int level = 0; level < levels; level++) {
+            StencilTable step;
+            SubdivMesh next;
+            refine(mesh, next, step);
+            stencils = level == 0 ? step : step.compose(stencils, baseCount);
+            mesh = next;
+        }
+        if (levels <= 0) {
+            stencils.rowStart.push_back(0);
+            for (int v = 0; v < baseCount; v++) {
+                stencils.columns.push_back(v);
+                stencils.weights.push_back(1.0f);
+                stencils.rowStart.push_back(v + 1);
+            }
+        }
+        topology = HalfEdgeMesh(stencils.rows(), mesh.triangles);
+    }
+
+    // recomputes the final positions and normals from (edited) base positions
+    void evaluate(const std::vector<glm::vec3> &basePositions)
+    {
+        stencils.apply(basePositions, finalPositions);
+        topology.vertexNormals(finalPositions, finalNormals);
+    }
+
+    // indexed output: one vertex per final vertex, uv (0, 0)
+    template <typename Sink>
+    void emit(Sink &out) const
+    {
+        out.begin(vertexCount(), (int)topology.triangles.size());
+        for (int v = 0; v < vertexCount(); v++) out.vertex(finalPositions[v], finalNormals[v], glm::vec2(0.0f));
+        for (size_t i = 0; i < topology.triangles.size(); i++) out.index(topology.triangles[i]);
+    }
+
+    int vertexCount() const { return stencils.rows(); }
+    int triangleCount() const { return topology.faceCount(); }
+    int stencilEntries() const { return stencils.entries(); }
+
+    const std::vector<glm::vec3> &positions() const { return finalPositions; }
+    const std::vector<glm::vec3> &normals() const { return finalNormals; }
+    const std::vector<unsigned int> &indices() const { return topology.triangles; }
+
+    // One level of Loop subdivision on mesh: next receives the refined topology and creases,
+    // step the stencils of next's vertices over mesh's vertices.
+    // Vertex numbering of next: mesh's vertices first, then one vertex per edge.
+    static void refine(const SubdivMesh &mesh, SubdivMesh &next, StencilTable &step)
+    {
+        const HalfEdgeMesh topology(mesh.vertexCount(), mesh.triangles);
+        const int vertexCount = topology.vertexCount();
+        const int faceCount = topology.faceCount();
+        const int edgeCount = topology.edgeCount();
+
+        // sharp edges: creases and boundaries (non-manifold edges are left as boundaries)
+        std::vector<char> sharp(edgeCount);
+        parallelFor(0, edgeCount, 4096, [&](int begin, int end) {
+            for (int e = begin; e < end; e++) {
+                int h = topology.edgeHalf[e];
+                sharp[e] = topology.isBoundary(h) || mesh.isCrease(topology.origin(h), topology.dest(h));
+            }
+        });
+
+        // stencil row sizes: vertex rows have at most valence + 1 entries, edge rows at most 4
+        std::vector<int> sharpCount(vertexCount, 0);
+        step.rowStart.assign(vertexCount + edgeCount + 1, 0);
+        parallelFor(0, vertexCount, 4096, [&](int begin, int end) {
+            for (int v = begin; v < end; v++) {
+                int valence = 0;
+                topology.forEachNeighbour(v, [&](int, int e) { valence++; sharpCount[v] += sharp[e]; });
+                step.rowStart[v + 1] = sharpCount[v] == 2 ? 3 : sharpCount[v] > 2 || valence == 0 ? 1 : valence + 1;
+            }
+        });
+        for (int e = 0; e < edgeCount; e++) step.rowStart[vertexCount + e + 1] = sharp[e] ? 2 : 4;
+        for (int r = 0; r < vertexCount + edgeCount; r++) step.rowStart[r + 1] += step.rowStart[r];
+        step.columns.resize(step.rowStart.back());
+        step.weights.resize(step.rowStart.back());
+
+        parallelFor(0, vertexCount, 2048, [&](int begin, int end) {
+            for (int v = begin; v < end; v++) {
+                int out = step.rowStart[v];
+                int valence = step.rowStart[v + 1] - out - 1;
+                if (sharpCount[v] > 2 || valence <= 0) {
+                    // corner (or unused vertex): stays where it is
+                    step.columns[out] = v; step.weights[out] = 1.0f;
+                }
+                else if (sharpCount[v] == 2) {
+                    // crease / boundary rule
+                    step.columns[out] = v; step.weights[out++] = 0.75f;
+                    topology.forEachNeighbour(v, [&](int neighbour, int e) {
+                        if (sharp[e]) { step.columns[out] = neighbour; step.weights[out++] = 0.125f; }
+                    });
+                }
+                else {
+                    // smooth rule (Loop's beta)
+                    double c = 0.375 + 0.25 * std::cos(2.0 * 3.14159265358979 / valence);
+                    float beta = (float)((0.625 - c * c) / valence);
+                    step.columns[out] = v; step.weights[out++] = 1.0f - valence * beta;
+                    topology.forEachNeighbour(v, [&](int neighbour, int) { step.columns[out] = neighbour; step.weights[out++] = beta; });
+                }
+            }
+        });
+
+        parallelFor(0, edgeCount, 2048, [&](int begin, int end) {
+            for (int e = begin; e < end; e++) {
+                int out = step.rowStart[vertexCount + e];
+                int h = topology.edgeHalf[e];
+                int a = topology.origin(h), b = topology.dest(h);
+                if (sharp[e]) {
+                    step.columns[out] = a; step.weights[out++] = 0.5f;
+                    step.columns[out] = b; step.weights[out] = 0.5f;
+                    continue;
+                }
+                step.columns[out] = a; step.weights[out++] = 0.375f;
+                step.columns[out] = b; step.weights[out++] = 0.375f;
+                step.columns[out] = topology.origin(HalfEdgeMesh::prev(h)); step.weights[out++] = 0.125f;
+                step.columns[out] = topology.origin(HalfEdgeMesh::prev(topology.twin[h])); step.weights[out] = 0.125f;
+            }
+        });
+
+        // topology: every face becomes 4, in face order; half-edge k of a face runs from corner k to k + 1
+        next.triangles.resize(faceCount * 12);
+        parallelFor(0, faceCount, 4096, [&](int begin, int end) {
+            for (int f = begin; f < end; f++) {
+                unsigned int v0 = topology.triangles[f * 3], v1 = topology.triangles[f * 3 + 1], v2 = topology.triangles[f * 3 + 2];
+                unsigned int e01 = vertexCount + topology.edge[f * 3], e12 = vertexCount + topology.edge[f * 3 + 1];
+                unsigned int e20 = vertexCount + topology.edge[f * 3 + 2];
+                unsigned int children[12] = { v0, e01, e20,   e01, v1, e12,   e20, e12, v2,   e01, e12, e20 };
+                std::copy(children, children + 12, next.triangles.begin() + f * 12);
+            }
+        });
+
+        // a crease edge (a, b) with midpoint m continues as (a, m) and (m, b)
+        next.creases.clear();
+        for (int e = 0; e < edgeCount; e++) {
+            int h = topology.edgeHalf[e];
+            unsigned int a = topology.origin(h), b = topology.dest(h), m = vertexCount + e;
+            if (!mesh.isCrease(a, b)) continue;
+            next.creases.push_back(SubdivMesh::edgeKey(a, m));
+            next.creases.push_back(SubdivMesh::edgeKey(m, b));
+        }
+        std::sort(next.creases.begin(), next.creases.end());
+        next.positions.assign(vertexCount + edgeCount, glm::vec3(0.0f));    // only the count matters to the next level
+    }
+
+private:
+    int baseCount;
+    StencilTable stencils;          // final vertices over base vertices
+    HalfEdgeMesh topology;          // final level
+    std::vector<glm::vec3> finalPositions, finalNormals;
+};
+
+#endif
@@ -0,0 +1,136 @@
+// texture_cache.h
+//
+// Process-wide cache of GL textures loaded from files, keyed by the normalized file path
+// ("a/./b/../c.png" and "a\c.png" are one texture), so models sharing a texture library load each
+// file once. Entries are refcounted: the texture is deleted when the last user releases it.
+// Textures from a TextureLoader pass it to acquire(), so that a release before the file was
+// decoded cancels the upload (the loader must outlive them).
+//
+// Usage:
+//     CachedTexture *texture = TextureCache::instance().acquire(path, [&](const std::string &file) {
+//         return loader.request(file);                     // or a synchronous load; returns the GL id
+//     }, &loader);                                         // no loader for a synchronous load
+//     ... bind texture->id ...
+//     TextureCache::instance().release(texture);
+
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <GL/glew.h>
+
+#include <cctype>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "texture_loader.h"
+
+// Forward slashes, no "." parts, ".." resolved where a part before it exists, no repeated
+// separators; lower case on Windows, where file names ignore case.
+inline std::string normalizeTexturePath(const std::string &path)
+{
+    std::vector<std::string> parts;
+    bool absolute = !path.empty() && (path[0] == '/' || path[0] == '\\');
+    std::string part;
+    for (size_t i = 0; i <= path.size(); i++) {
+        char c = i < path.size() ? path[i] : '/';
+        if (c != '/' && c != '\\') {
+#ifdef _WIN32
+            c = (char)std::tolower((unsigned char)c);
+#endif
+            part += c;
+            continue;
+        }
+        if (part == "..") {
+            if (!parts.empty() && parts.back() != "..") parts.pop_back();
+            else if (!absolute) parts.push_back(part);
+        }
+        else if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+        part.clear();
+    }
+    std::string normalized = absolute ? "/" : "";
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (i > 0) normalized += '/';
+        normalized += parts[i];
+    }
+    return normalized;
+}
+
+struct CachedTexture
+{
+    std::string path;       // normalized
+    GLuint id = 0;
+    int refCount = 0;
+    TextureLoader *loader = NULL;   // the loader that may still be decoding the file
+};
+
+class TextureCache
+{
+public:
+
+    static TextureCache &instance()
+    {
+        static TextureCache cache;
+        return cache;
+    }
+
+    // Returns the texture of path, calling load(normalizedPath) for its GL id on a miss; loader is
+    // the TextureLoader that load requests the file from, if any. The returned pointer stays valid
+    // until the matching release().
+    template <typename Loader>
+    CachedTexture *acquire(const std::string &path, Loader load, TextureLoader *loader = NULL)
+    {
+        std::string key = normalizeTexturePath(path);
+        std::unordered_map<std::string, CachedTexture>::iterator it = entries.find(key);
+        if (it == entries.end()) {
+            it = entries.insert(std::make_pair(key, CachedTexture())).first;
+            it->second.path = key;
+            it->second.id = load(key);
+            it->second.loader = loader;
+            loads++;
+        }
+        else {
+            hits++;
+        }
+        it->second.refCount++;
+        return &it->second;
+    }
+
+    void release(CachedTexture *texture)
+    {
+        if (texture == NULL || --texture->refCount > 0) return;
+
+        if (texture->loader != NULL) texture->loader->cancel(texture->id);
+        glDeleteTextures(1, &texture->id);
+        entries.erase(texture->path);
+    }
+
+    // number of distinct textures currently alive
+    int size() const
+    {
+        return (int)entries.size();
+    }
+
+    // misses (files loaded) and hits since the start
+    int getLoadCount() const
+    {
+        return loads;
+    }
+
+    int getHitCount() const
+    {
+        return hits;
+    }
+
+private:
+    std::unordered_map<std::string, CachedTexture> entries;
+    int loads = 0, hits = 0;
+
+    TextureCache() { }
+    TextureCache(const TextureCache &);
+    TextureCache &operator=(const TextureCache &);
+};
+
+#endif
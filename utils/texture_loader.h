@@ -0,0 +1,161 @@
+// texture_loader.h
+//
+// Asynchronous textures: request() creates the GL texture at once with a 1 x 1 grey placeholder
+// and queues the file; decoder threads decode it (image_decoder.h) and update(), once a frame on
+// the GL thread, uploads finished images into their textures within a byte budget. The id never
+// changes, so whatever holds it (a Mesh, a material) shows the real image as soon as it is in.
+//
+//     TextureLoader loader;
+//     GLuint id = loader.request("textures/brick.png");   // GL thread, no decoding here
+//     ...
+//     loader.update(8 << 20);                              // every frame: upload up to 8 MB
+//
+// update() uploads at least one ready image per call, however large. finish() blocks until every
+// requested file is in (a loading screen, or code that reads the texture back).
+// A file that cannot be decoded is reported and keeps its placeholder.
+// Call cancel(id) before deleting a texture whose file may still be decoding: GL reuses deleted
+// names, and the late image would otherwise land in whatever texture gets the name next.
+
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "image_decoder.h"
+
+class TextureLoader
+{
+public:
+    explicit TextureLoader(int decodeThreads = ImageDecoder::defaultThreads())
+        : decoder(decodeThreads), nextRequest(0), uploadedCount(0), uploadedBytes(0), updateMilliseconds(0.0) { }
+
+    // GL thread; leaves the bound texture as it was
+    GLuint request(const std::string &path, GLint wrap = GL_REPEAT)
+    {
+        static const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+        GLint previousTexture;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, previousTexture);
+
+        // the decoder carries a request number, not the id: the id may be deleted and reused before the file is decoded
+        unsigned int number = nextRequest++;
+        requests[number] = texture;
+        requestOfTexture[texture] = number;
+        decoder.request(path, number);
+        return texture;
+    }
+
+    // GL thread: the image of texture, if it is still being decoded, is dropped instead of
+    // uploaded; call before glDeleteTextures
+    void cancel(GLuint texture)
+    {
+        std::unordered_map<GLuint, unsigned int>::iterator it = requestOfTexture.find(texture);
+        if (it == requestOfTexture.end()) return;
+        requests.erase(it->second);
+        requestOfTexture.erase(it);
+    }
+
+    // GL thread, once a frame: uploads decoded images until budgetBytes of pixels went up;
+    // returns how many were uploaded
+    int update(size_t budgetBytes)
+    {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        GLint previousTexture, previousAlignment;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &previousTexture);
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &previousAlignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);     // rows of RGB images need not be 4-byte aligned
+
+        int uploaded = 0;
+        size_t bytes = 0;
+        DecodedImage *image;
+        while ((uploaded == 0 || bytes < budgetBytes) && (image = decoder.poll()) != NULL) {
+            std::unordered_map<unsigned int, GLuint>::iterator request = requests.find(image->tag);
+            if (request == requests.end()) {
+                // cancelled while its file was decoded: the texture is gone, its name may be reused
+                decoder.release(image);
+                continue;
+            }
+            GLuint texture = request->second;
+            requestOfTexture.erase(texture);
+            requests.erase(request);
+            if (image->pixels == NULL) {
+                printf("texture %s loading error ... \n", image->path.c_str());
+            }
+            else {
+                GLenum format = image->channels == 1 ? GL_RED : image->channels == 2 ? GL_RG : image->channels == 3 ? GL_RGB : GL_RGBA;
+                glBindTexture(GL_TEXTURE_2D, texture);
+                glTexImage2D(GL_TEXTURE_2D, 0, format, image->width, image->height, 0, format, GL_UNSIGNED_BYTE, image->pixels);
+                glGenerateMipmap(GL_TEXTURE_2D);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+                bytes += image->bytes();
+                uploaded++;
+            }
+            decoder.release(image);
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, previousAlignment);
+        glBindTexture(GL_TEXTURE_2D, previousTexture);
+        uploadedCount += uploaded;
+        uploadedBytes += bytes;
+        updateMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        return uploaded;
+    }
+
+    // GL thread: waits for and uploads everything requested so far
+    void finish()
+    {
+        while (decoder.pendingCount() > 0) {
+            if (update((size_t)-1) == 0) std::this_thread::yield();
+        }
+    }
+
+    // requested and not uploaded yet
+    int pendingCount() const
+    {
+        return decoder.pendingCount();
+    }
+
+    int getUploadedCount() const
+    {
+        return uploadedCount;
+    }
+
+    size_t getUploadedBytes() const
+    {
+        return uploadedBytes;
+    }
+
+    // time of the last update()
+    double getUpdateMilliseconds() const
+    {
+        return updateMilliseconds;
+    }
+
+private:
+    ImageDecoder decoder;
+    unsigned int nextRequest;
+    std::unordered_map<unsigned int, GLuint> requests;            // request number -> texture, until uploaded or cancelled
+    std::unordered_map<GLuint, unsigned int> requestOfTexture;    // the other way, for cancel()
+    int uploadedCount;
+    size_t uploadedBytes;
+    double updateMilliseconds;
+
+    TextureLoader(const TextureLoader &);
+    TextureLoader &operator=(const TextureLoader &);
+};
+
+#endif
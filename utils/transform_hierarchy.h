@@ -0,0 +1,153 @@
+// transform_hierarchy.h
+//
+// A flattened parent/child transform tree, GL independent.
+// Nodes live in parallel arrays (parent index, local matrix, world matrix, dirty flag) and a node
+// is always stored after its parent, so one front-to-back pass sees every parent before its
+// children. setLocal() only marks the node; update() walks the arrays once from the first dirty
+// node, passes the flag down to the children and recomputes world = world[parent] * local for the
+// marked nodes only.
+//
+//     TransformHierarchy tree;
+//     int root = tree.addNode(TransformHierarchy::NO_PARENT, model);
+//     int wing = tree.addNode(root, glm::translate(glm::mat4(1.0f), offset));
+//     tree.setLocal(root, newModel);
+//     tree.update();
+//     shader->setMat4("model", tree.getWorld(wing));
+//
+// The matrix product is 4 SSE columns where available, otherwise glm's.
+
+#ifndef TRANSFORM_HIERARCHY_H
+#define TRANSFORM_HIERARCHY_H
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRANSFORM_HIERARCHY_SSE 1
+#include <emmintrin.h>
+#endif
+
+// out = a * b for column-major 4x4 matrices; out may not alias a or b
+inline void multiplyMat4(const glm::mat4 &a, const glm::mat4 &b, glm::mat4 &out)
+{
+#ifdef TRANSFORM_HIERARCHY_SSE
+    const float *pa = &a[0][0], *pb = &b[0][0];
+    float *po = &out[0][0];
+    __m128 a0 = _mm_loadu_ps(pa), a1 = _mm_loadu_ps(pa + 4), a2 = _mm_loadu_ps(pa + 8), a3 = _mm_loadu_ps(pa + 12);
+    for (int c = 0; c < 4; c++) {
+        const float *column = pb + c * 4;
+        __m128 r = _mm_mul_ps(a0, _mm_set1_ps(column[0]));
+        r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(column[1])));
+        r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(column[2])));
+        r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(column[3])));
+        _mm_storeu_ps(po + c * 4, r);
+    }
+#else
+    out = a * b;
+#endif
+}
+
+class TransformHierarchy
+{
+public:
+    static const int NO_PARENT = -1;
+
+    TransformHierarchy() : firstDirty(0) {}
+
+    void reserve(int count)
+    {
+        parents.reserve(count);
+        locals.reserve(count);
+        worlds.reserve(count);
+        dirty.reserve(count);
+    }
+
+    // parent must be NO_PARENT or an existing node; returns the new node's index
+    int addNode(int parent, const glm::mat4 &local = glm::mat4(1.0f))
+    {
+        int node = size();
+        if (parent < NO_PARENT || parent >= node) {
+            std::cout << "ERROR::TRANSFORM_HIERARCHY::INVALID_PARENT " << parent << std::endl;
+            exit(-1);
+        }
+        parents.push_back(parent);
+        locals.push_back(local);
+        worlds.push_back(local);
+        dirty.push_back(1);
+        if (firstDirty > node) firstDirty = node;
+        return node;
+    }
+
+    void setLocal(int node, const glm::mat4 &local)
+    {
+        locals[node] = local;
+        markDirty(node);
+    }
+
+    // for callers that edit getLocal() in place
+    void markDirty(int node)
+    {
+        dirty[node] = 1;
+        if (firstDirty > node) firstDirty = node;
+    }
+
+    // Brings every world matrix up to date; returns how many were recomputed.
+    int update()
+    {
+        int count = size();
+        int recomputed = 0;
+        const int *parent = parents.empty() ? NULL : &parents[0];
+        unsigned char *flag = dirty.empty() ? NULL : &dirty[0];
+        for (int i = firstDirty; i < count; i++) {
+            int p = parent[i];
+            if (p != NO_PARENT && flag[p]) flag[i] = 1;
+            if (!flag[i]) continue;
+            if (p == NO_PARENT) worlds[i] = locals[i];
+            else multiplyMat4(worlds[p], locals[i], worlds[i]);
+            recomputed++;
+        }
+        // flags are cleared afterwards: children further down still need to see their parent's
+        for (int i = firstDirty; i < count; i++) flag[i] = 0;
+        firstDirty = count;
+        return recomputed;
+    }
+
+    int size() const
+    {
+        return (int)parents.size();
+    }
+
+    int getParent(int node) const
+    {
+        return parents[node];
+    }
+
+    glm::mat4 &getLocal(int node)
+    {
+        return locals[node];
+    }
+
+    // valid after update()
+    const glm::mat4 &getWorld(int node) const
+    {
+        return worlds[node];
+    }
+
+    // all world matrices, contiguous in node order (for uploading as a batch)
+    const glm::mat4 *getWorlds() const
+    {
+        return worlds.empty() ? NULL : &worlds[0];
+    }
+
+private:
+    std::vector<int> parents;
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<unsigned char> dirty;
+    int firstDirty;    // no node before this one is dirty
+};
+
+#endif
@@ -0,0 +1,190 @@
+// vertex_layout.h
+//
+// Compile-time description of an interleaved vertex format. A layout is a list of attribute
+// encodings; the stride, every attribute offset and the glVertexAttribPointer calls are derived
+// from that list, so a primitive no longer spells them out by hand:
+//
+//     typedef VertexLayout<PositionF32, NormalPacked, ColorRGBA8, TexcoordHalf> Layout;  // 24 bytes
+//     std::vector<Layout::Vertex> vertices(count);
+//     Layout::write(vertices[i], VertexInput(position, normal, color, uv));
+//     ...
+//     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Layout::Vertex), &vertices[0], GL_STATIC_DRAW);
+//     Layout::setup();    // with the VAO and the VBO bound
+//
+// Encodings (the shader locations stay 0: position, 1: normal, 2: color, 3: texcoord):
+//     PositionF32     vec3 float                          12 bytes
+//     NormalF32       vec3 float                          12 bytes
+//     NormalPacked    GL_INT_2_10_10_10_REV, normalized    4 bytes
+//     ColorF32        vec4 float                          16 bytes
+//     ColorRGBA8      4 x GL_UNSIGNED_BYTE, normalized     4 bytes
+//     TexcoordF32     vec2 float                           8 bytes
+//     TexcoordHalf    2 x GL_HALF_FLOAT                    4 bytes
+// The shader side does not change: packed values arrive as the same vec3/vec4/vec2 inputs.
+
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <cstring>
+#include <type_traits>
+
+// Everything a vertex may carry, before encoding. Each attribute picks the field it needs.
+struct VertexInput
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec4 color;
+    glm::vec2 texcoord;
+
+    VertexInput() : position(0.0f), normal(0.0f, 1.0f, 0.0f), color(1.0f), texcoord(0.0f) { }
+
+    VertexInput(const glm::vec3 &position, const glm::vec3 &normal, const glm::vec4 &color, const glm::vec2 &texcoord)
+        : position(position), normal(normal), color(color), texcoord(texcoord) { }
+};
+
+// -----------------------------------------------------------------------------
+// Attribute encodings
+// Each one has: location, size (bytes in the vertex), encode(input, dst) and pointer(stride, offset).
+// -----------------------------------------------------------------------------
+
+struct PositionF32
+{
+    enum { location = 0, size = 3 * sizeof(float) };
+    static void encode(const VertexInput &in, unsigned char *dst) { std::memcpy(dst, &in.position[0], size); }
+    static void pointer(int stride, size_t offset) { glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, stride, (void *)offset); }
+};
+
+struct NormalF32
+{
+    enum { location = 1, size = 3 * sizeof(float) };
+    static void encode(const VertexInput &in, unsigned char *dst) { std::memcpy(dst, &in.normal[0], size); }
+    static void pointer(int stride, size_t offset) { glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, stride, (void *)offset); }
+};
+
+struct NormalPacked
+{
+    enum { location = 1, size = sizeof(glm::uint32) };
+    static void encode(const VertexInput &in, unsigned char *dst)
+    {
+        glm::uint32 packed = glm::packSnorm3x10_1x2(glm::vec4(in.normal, 0.0f));
+        std::memcpy(dst, &packed, size);
+    }
+    static void pointer(int stride, size_t offset) { glVertexAttribPointer(location, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void *)offset); }
+};
+
+struct ColorF32
+{
+    enum { location = 2, size = 4 * sizeof(float) };
+    static void encode(const VertexInput &in, unsigned char *dst) { std::memcpy(dst, &in.color[0], size); }
+    static void pointer(int stride, size_t offset) { glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, (void *)offset); }
+};
+
+struct ColorRGBA8
+{
+    enum { location = 2, size = sizeof(glm::uint32) };
+    static void encode(const VertexInput &in, unsigned char *dst)
+    {
+        glm::uint32 packed = glm::packUnorm4x8(glm::clamp(in.color, 0.0f, 1.0f));
+        std::memcpy(dst, &packed, size);
+    }
+    static void pointer(int stride, size_t offset) { glVertexAttribPointer(location, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void *)offset); }
+};
+
+struct TexcoordF32
+{
+    enum { location = 3, size = 2 * sizeof(float) };
+    static void encode(const VertexInput &in, unsigned char *dst) { std::memcpy(dst, &in.texcoord[0], size); }
+    static void pointer(int stride, size_t offset) { glVertexAttribPointer(location, 2, GL_FLOAT, GL_FALSE, stride, (void *)offset); }
+};
+
+struct TexcoordHalf
+{
+    enum { location = 3, size = sizeof(glm::uint32) };
+    static void encode(const VertexInput &in, unsigned char *dst)
+    {
+        glm::uint32 packed = glm::packHalf2x16(in.texcoord);
+        std::memcpy(dst, &packed, size);
+    }
+    static void pointer(int stride, size_t offset) { glVertexAttribPointer(location, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void *)offset); }
+};
+
+// -----------------------------------------------------------------------------
+// Offset arithmetic over the attribute list
+// -----------------------------------------------------------------------------
+
+template <typename... Attrs>
+struct AttributeSize
+{
+    static const int value = 0;
+};
+
+template <typename First, typename... Rest>
+struct AttributeSize<First, Rest...>
+{
+    static const int value = First::size + AttributeSize<Rest...>::value;
+};
+
+// byte offset of Target in Attrs..., or -1 when the layout does not contain it
+template <typename Target, typename... Attrs>
+struct AttributeOffset
+{
+    static const int value = -1;
+};
+
+template <typename Target, typename First, typename... Rest>
+struct AttributeOffset<Target, First, Rest...>
+{
+    static const int rest = AttributeOffset<Target, Rest...>::value;
+    static const int value = std::is_same<Target, First>::value ? 0 : (rest < 0 ? -1 : First::size + rest);
+};
+
+// -----------------------------------------------------------------------------
+// VertexLayout
+// -----------------------------------------------------------------------------
+
+template <typename... Attrs>
+struct VertexLayout
+{
+    static const int stride = AttributeSize<Attrs...>::value;
+
+    // one interleaved vertex; every encoding is a multiple of 4 bytes, so vertices stay aligned
+    struct Vertex
+    {
+        unsigned char bytes[stride];
+    };
+    static_assert(stride % 4 == 0, "vertex attributes should keep 4-byte alignment");
+    static_assert(sizeof(Vertex) == stride, "Vertex should have no padding");
+
+    template <typename Attr>
+    static int offsetOf()
+    {
+        static_assert(AttributeOffset<Attr, Attrs...>::value >= 0, "attribute is not part of this layout");
+        return AttributeOffset<Attr, Attrs...>::value;
+    }
+
+    // encodes every attribute of the layout from the matching field of in
+    static void write(Vertex &vertex, const VertexInput &in)
+    {
+        int expand[] = { 0, (Attrs::encode(in, vertex.bytes + AttributeOffset<Attrs, Attrs...>::value), 0)... };
+        (void)expand;
+    }
+
+    // points and enables every attribute; the VAO and the GL_ARRAY_BUFFER should be bound,
+    // baseOffset is where the first vertex starts in that buffer
+    static void setup(size_t baseOffset = 0)
+    {
+        int expand[] = { 0, (Attrs::pointer(stride, baseOffset + AttributeOffset<Attrs, Attrs...>::value),
+                             glEnableVertexAttribArray(Attrs::location), 0)... };
+        (void)expand;
+    }
+};
+
+// The formats used by the primitives.
+// FullVertex keeps every attribute as float (48 bytes); PackedVertex is the compact one (24 bytes).
+typedef VertexLayout<PositionF32, NormalF32, ColorF32, TexcoordF32> FullVertex;
+typedef VertexLayout<PositionF32, NormalPacked, ColorRGBA8, TexcoordHalf> PackedVertex;
+
+#endif